@@ -1,14 +1,37 @@
 #version 450
 
+layout(constant_id = 0) const bool USE_TEXTURE = true;
+layout(constant_id = 1) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 2) const bool USE_NORMAL = false;
+layout(constant_id = 3) const bool ALPHA_TEST = false;
+
 layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragNormal;
+layout(location = 3) in vec4 fragInstanceColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
 
-    outColor = texture(texSampler, fragTexCoord);
+    vec4 color = USE_TEXTURE ? texture(texSampler, fragTexCoord) : vec4(1.0);
+    color *= fragInstanceColor;
+
+    if (USE_VERTEX_COLOR) {
+        color.rgb *= fragColor;
+    }
+
+    if (USE_NORMAL) {
+        float diffuse = max(dot(normalize(fragNormal), normalize(vec3(0.5, 1.0, 0.75))), 0.0);
+        color.rgb *= 0.2 + 0.8 * diffuse;
+    }
+
+    if (ALPHA_TEST && color.a < 0.5) {
+        discard;
+    }
+
+    outColor = color;
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,40 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(constant_id = 0) const bool USE_TEXTURE = true;
+layout(constant_id = 1) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 2) const bool USE_NORMAL = false;
+layout(constant_id = 3) const bool ALPHA_TEST = false;
+
+// Set 1 is the bindless texture array, indexed by the material of the instance
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragNormal;
+layout(location = 3) in vec4 fragInstanceColor;
+layout(location = 4) flat in uint fragMaterialIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+
+    vec4 color = USE_TEXTURE ? texture(textures[nonuniformEXT(fragMaterialIndex)], fragTexCoord) : vec4(1.0);
+    color *= fragInstanceColor;
+
+    if (USE_VERTEX_COLOR) {
+        color.rgb *= fragColor;
+    }
+
+    if (USE_NORMAL) {
+        float diffuse = max(dot(normalize(fragNormal), normalize(vec3(0.5, 1.0, 0.75))), 0.0);
+        color.rgb *= 0.2 + 0.8 * diffuse;
+    }
+
+    if (ALPHA_TEST && color.a < 0.5) {
+        discard;
+    }
+
+    outColor = color;
+
+}
@@ -1,7 +1,9 @@
 #version 450
 
+layout(constant_id = 1) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 2) const bool USE_NORMAL = false;
+
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
@@ -11,12 +13,23 @@ layout(location = 1) in vec2 inTexCoord;
 layout(location = 2) in vec3 inColor;
 layout(location = 3) in vec3 inNormal;
 
+// Per-instance, binding 1
+layout(location = 4) in mat4 inModel;
+layout(location = 8) in vec4 inInstanceColor;
+layout(location = 9) in uint inMaterialIndex;
+
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec4 fragInstanceColor;
+layout(location = 4) flat out uint fragMaterialIndex;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragColor = inColor;
+    gl_Position = ubo.proj * ubo.view * inModel * vec4(inPosition, 1.0);
+    fragColor = USE_VERTEX_COLOR ? inColor : vec3(1.0);
     fragTexCoord = inTexCoord;
-}
\ No newline at end of file
+    fragNormal = USE_NORMAL ? mat3(inModel) * inNormal : vec3(0.0, 0.0, 1.0);
+    fragInstanceColor = inInstanceColor;
+    fragMaterialIndex = inMaterialIndex;
+}
@@ -0,0 +1,36 @@
+#version 450
+
+layout(constant_id = 1) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 2) const bool USE_NORMAL = false;
+
+// Per-draw data, the transform is premultiplied on the CPU and row-major like every st::math matrix
+layout(push_constant) uniform DrawConstants {
+    layout(row_major) mat4 modelViewProjection;
+    // Upper three rows of the model matrix, enough to transform normals
+    vec4 modelRows[3];
+    uint materialIndex;
+} draw;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec3 inNormal;
+
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec4 fragInstanceColor;
+layout(location = 4) flat out uint fragMaterialIndex;
+
+void main() {
+    gl_Position = draw.modelViewProjection * vec4(inPosition, 1.0);
+    fragColor = USE_VERTEX_COLOR ? inColor : vec3(1.0);
+    fragTexCoord = inTexCoord;
+    fragNormal = USE_NORMAL ? vec3(dot(draw.modelRows[0].xyz, inNormal),
+                                   dot(draw.modelRows[1].xyz, inNormal),
+                                   dot(draw.modelRows[2].xyz, inNormal))
+                            : vec3(0.0, 0.0, 1.0);
+    fragInstanceColor = vec4(1.0);
+    fragMaterialIndex = draw.materialIndex;
+}
@@ -1,5 +1,9 @@
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe VertexShader.vert -o vert.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe VertexShaderObject.vert -o vert_object.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe FragShader.frag -o frag.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe FragShaderBindless.frag -o frag_bindless.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe line_vert.vert -o line_vert.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe line_frag.frag -o line_frag.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe cull.comp -o cull.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe depth_reduce.comp -o depth_reduce.spv
 pause
\ No newline at end of file
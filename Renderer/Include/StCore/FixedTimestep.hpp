@@ -0,0 +1,34 @@
+#ifndef CORE_FIXEDTIMESTEP_HPP
+#define CORE_FIXEDTIMESTEP_HPP
+
+#include <cstdint>
+
+namespace st::core
+{
+
+	// Accumulates real time and converts it into whole simulation ticks of a fixed length, so the
+	// simulation advances the same way at any display rate. What is left over is the fraction of
+	// the next tick the rendered state interpolates by.
+	class FixedTimestep
+	{
+	public:
+		explicit FixedTimestep(double tickSeconds = 1.0 / 60.0, uint32_t maxTicksPerFrame = 8);
+
+		// Number of ticks to simulate for elapsedSeconds of real time. Time beyond maxTicksPerFrame
+		// is dropped, a frame that took too long slows the simulation down instead of making the
+		// next frame longer still.
+		uint32_t advance(double elapsedSeconds);
+
+		// Between 0 and 1, how far real time is past the last simulated tick
+		float getAlpha() const;
+		double getTickSeconds() const;
+
+	private:
+		double m_tickSeconds;
+		uint32_t m_maxTicksPerFrame;
+		double m_accumulator { 0.0 };
+	};
+
+};
+
+#endif // CORE_FIXEDTIMESTEP_HPP
@@ -0,0 +1,72 @@
+#ifndef CORE_FRAMEARENA_HPP
+#define CORE_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace st::core
+{
+
+	struct FrameArenaStatistics
+	{
+		// Since the last reset, including the ones that did not fit the block
+		uint32_t allocationCount { 0 };
+		// Taken from the upstream resource because the block was full
+		uint32_t overflowCount { 0 };
+		size_t bytesUsed { 0 };
+		size_t capacity { 0 };
+	};
+
+	// Bump allocator for memory that lives no longer than one frame. Containers take it as their
+	// std::pmr memory resource, deallocation does nothing and reset() releases everything at once.
+	// What does not fit the block comes from the upstream resource and the block grows to the peak
+	// at the next reset, so a frame that fit once never touches the upstream resource again.
+	// Used by one thread at a time.
+	class FrameArena : public std::pmr::memory_resource
+	{
+	public:
+		static constexpr size_t defaultCapacity = 64 * 1024;
+
+		FrameArena();
+		explicit FrameArena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~FrameArena() override;
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		// Nothing allocated since the last reset may be used afterwards
+		void reset();
+
+		// Of the allocations since the last reset
+		FrameArenaStatistics getStatistics() const;
+
+	private:
+		// Header in front of every overflow allocation, they are freed together at reset
+		struct Overflow
+		{
+			Overflow* next;
+			size_t size;
+			size_t alignment;
+		};
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		void releaseOverflows();
+
+		std::pmr::memory_resource* m_upstream;
+		std::byte* m_block { nullptr };
+		size_t m_capacity { 0 };
+		size_t m_offset { 0 };
+
+		Overflow* m_overflows { nullptr };
+		size_t m_overflowBytes { 0 };
+
+		FrameArenaStatistics m_statistics;
+	};
+
+};
+
+#endif // CORE_FRAMEARENA_HPP
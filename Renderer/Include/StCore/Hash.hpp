@@ -0,0 +1,60 @@
+#ifndef CORE_HASH_HPP
+#define CORE_HASH_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace st::core
+{
+
+	// 64-bit FNV-1a for the keys of caches and lookup tables. Different inputs can share a hash, a
+	// cache that must not mix them up still compares the full key on a hit.
+	inline constexpr uint64_t fnv1aOffsetBasis = 14695981039346656037ULL;
+	inline constexpr uint64_t fnv1aPrime = 1099511628211ULL;
+
+	inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= fnv1aPrime;
+		}
+	}
+
+	// Low byte first, the hash does not depend on the byte order of the host
+	inline void hashValue(uint64_t& hash, uint64_t value)
+	{
+		for (size_t i = 0; i < sizeof(value); ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= fnv1aPrime;
+		}
+	}
+
+	// By bit pattern, 0.0 and -0.0 hash differently
+	inline void hashFloat(uint64_t& hash, float value)
+	{
+		const auto bits = std::bit_cast<uint32_t>(value);
+		hashBytes(hash, &bits, sizeof(bits));
+	}
+
+	inline uint64_t hashString(std::string_view data)
+	{
+		uint64_t hash = fnv1aOffsetBasis;
+		hashBytes(hash, data.data(), data.size());
+		return hash;
+	}
+
+	// Vulkan-Hpp handle as an integer, dispatchable handles are pointers and the others integers
+	template<typename Handle>
+	uint64_t handleValue(Handle handle)
+	{
+		return reinterpret_cast<uint64_t>(static_cast<typename Handle::CType>(handle));
+	}
+
+};
+
+#endif // CORE_HASH_HPP
@@ -0,0 +1,54 @@
+#ifndef CORE_JOB_HPP
+#define CORE_JOB_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace st::core
+{
+
+	class JobCounter;
+
+	using JobFunction = void (*)(void* data);
+
+	// A function pointer and its argument, cheap enough to copy into the deques by value. data
+	// must outlive the job, usually by waiting on its counter in the scope that owns it.
+	struct Job
+	{
+		JobFunction function { nullptr };
+		void* data { nullptr };
+		// Decremented once the job ran, may be null
+		JobCounter* counter { nullptr };
+	};
+
+	// Number of scheduled jobs that have not finished. Jobs scheduled after a counter start once it
+	// reaches zero, the counter must outlive them and every wait on it.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool isDone() const
+		{
+			return m_value.load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_value { 0 };
+
+		// Guards the continuations and the last decrement, a waiter may destroy the counter as soon
+		// as it can take the lock with the value at zero
+		std::mutex m_mutex;
+		std::vector<Job> m_continuations;
+	};
+
+};
+
+#endif // CORE_JOB_HPP
@@ -0,0 +1,151 @@
+#ifndef CORE_JOBSYSTEM_HPP
+#define CORE_JOBSYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "StCore/Job.hpp"
+#include "StCore/WorkStealingDeque.hpp"
+
+namespace st::core
+{
+
+	// Work-stealing scheduler. The thread that creates it is worker 0, the others each own a deque
+	// of jobs they push to and pop from, idle workers steal from the top of the others. Waiting on
+	// a counter runs other jobs until it reaches zero, so a job may schedule and wait on children
+	// without blocking a worker. Threads that are not workers schedule through a shared queue.
+	//
+	// Jobs marked for the main thread, such as Vulkan queue submissions, only run on worker 0, in
+	// wait() or runMainThreadJobs(). Background jobs, such as pipeline compiles or file writes, only
+	// run on worker threads with nothing else to do, a wait never picks one up and stalls behind it.
+	class JobSystem
+	{
+	public:
+		explicit JobSystem(uint32_t workerCount = defaultWorkerCount());
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		void schedule(const Job& job);
+		// Runs job once dependency reached zero
+		void scheduleAfter(JobCounter& dependency, const Job& job);
+		void scheduleOnMainThread(const Job& job);
+		// Without worker threads the job runs on the calling thread before this returns
+		void scheduleBackground(const Job& job);
+
+		// Runs other jobs until the counter reaches zero, sleeps while there are none to run
+		void wait(JobCounter& counter);
+		// Main thread only, runs the main thread jobs queued so far
+		void runMainThreadJobs();
+
+		// body(begin, end) over [0, count) in ranges of grainSize, returns once every range ran.
+		// Workers claim ranges from a shared cursor, a slow range does not hold up the others.
+		template <typename Body>
+		void parallelFor(uint32_t count, uint32_t grainSize, Body&& body);
+
+		// Including the main thread
+		uint32_t getWorkerCount() const;
+		bool isMainThread() const;
+
+		static uint32_t defaultWorkerCount();
+
+	private:
+		void workerLoop(uint32_t workerIndex);
+
+		void enqueue(const Job& job);
+		std::optional<Job> findJob(std::optional<uint32_t> workerIndex);
+		std::optional<Job> popMainThreadJob();
+		std::optional<Job> popBackgroundJob();
+		void run(const Job& job);
+		void finish(JobCounter& counter);
+		void wake();
+		// For jobs only some of the sleeping threads may take, and for finished counters
+		void wakeAll();
+
+		// Index of the calling thread, none when it is not a worker of this system
+		std::optional<uint32_t> currentWorker() const;
+
+		std::vector<std::unique_ptr<WorkStealingDeque>> m_deques;
+		std::vector<std::thread> m_threads;
+		std::thread::id m_mainThread;
+
+		// Jobs from threads without a deque and jobs overflowing a full one
+		std::mutex m_injectedMutex;
+		std::deque<Job> m_injected;
+
+		std::mutex m_mainThreadMutex;
+		std::deque<Job> m_mainThreadJobs;
+
+		std::mutex m_backgroundMutex;
+		std::deque<Job> m_backgroundJobs;
+
+		// Queued and not yet taken, idle workers and waiters sleep while there is nothing for them
+		std::atomic<int64_t> m_queuedJobs { 0 };
+		std::atomic<int64_t> m_queuedMainThreadJobs { 0 };
+		std::atomic<int64_t> m_queuedBackgroundJobs { 0 };
+		std::atomic<uint32_t> m_sleepingThreads { 0 };
+		std::mutex m_sleepMutex;
+		std::condition_variable m_jobAvailable;
+		bool m_stopping { false };
+	};
+
+	template <typename Body>
+	void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, Body&& body)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		struct Shared
+		{
+			std::remove_reference_t<Body>* body;
+			uint32_t count;
+			uint32_t grainSize;
+			std::atomic<uint64_t> next { 0 };
+		};
+
+		Shared shared { &body, count, std::max(grainSize, 1U) };
+
+		const JobFunction claimRanges = [](void* data) {
+			Shared& shared = *static_cast<Shared*>(data);
+			while (true)
+			{
+				const uint64_t begin = shared.next.fetch_add(shared.grainSize, std::memory_order_relaxed);
+				if (begin >= shared.count)
+				{
+					return;
+				}
+
+				const uint64_t end = std::min<uint64_t>(begin + shared.grainSize, shared.count);
+				(*shared.body)(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+			}
+		};
+
+		const uint32_t rangeCount = (count + shared.grainSize - 1) / shared.grainSize;
+		const uint32_t jobCount = std::min(rangeCount, getWorkerCount());
+
+		// The caller claims ranges too, one job fewer to schedule
+		JobCounter counter;
+		for (uint32_t i = 1; i < jobCount; ++i)
+		{
+			schedule(Job { claimRanges, &shared, &counter });
+		}
+
+		claimRanges(&shared);
+		wait(counter);
+	}
+
+};
+
+#endif // CORE_JOBSYSTEM_HPP
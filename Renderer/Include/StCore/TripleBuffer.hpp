@@ -0,0 +1,92 @@
+#ifndef CORE_TRIPLEBUFFER_HPP
+#define CORE_TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace st::core
+{
+
+	// Hands the latest value from one producer thread to one consumer thread without locks. Each
+	// side owns one buffer and the third is swapped in and out of the middle with a single atomic
+	// exchange, so publish and acquire never block and neither side copies a buffer. A value
+	// published before the consumer took the previous one replaces it. waitUntilConsumed and
+	// waitForPublish are opt-in pacing for a side that wants to wait for the other.
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// Producer, filled in place. Holds an older value, not necessarily the last one published.
+		T& getWriteBuffer()
+		{
+			return m_buffers[m_write];
+		}
+
+		void publish()
+		{
+			m_write = m_middle.exchange(static_cast<uint8_t>(m_write | freshBit), std::memory_order_acq_rel) & indexMask;
+			m_middle.notify_all();
+		}
+
+		// Producer, blocks while the last published value has not been acquired
+		void waitUntilConsumed() const
+		{
+			uint8_t middle = m_middle.load(std::memory_order_acquire);
+			while (middle & freshBit)
+			{
+				m_middle.wait(middle, std::memory_order_acquire);
+				middle = m_middle.load(std::memory_order_acquire);
+			}
+		}
+
+		// Consumer, true when a value was published since the last acquire. The read buffer keeps
+		// the previous value otherwise.
+		bool acquire()
+		{
+			if (!(m_middle.load(std::memory_order_relaxed) & freshBit))
+			{
+				return false;
+			}
+
+			m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & indexMask;
+			m_middle.notify_all();
+			return true;
+		}
+
+		// Consumer, blocks until acquire() would return true
+		void waitForPublish() const
+		{
+			uint8_t middle = m_middle.load(std::memory_order_acquire);
+			while (!(middle & freshBit))
+			{
+				m_middle.wait(middle, std::memory_order_acquire);
+				middle = m_middle.load(std::memory_order_acquire);
+			}
+		}
+
+		T& getReadBuffer()
+		{
+			return m_buffers[m_read];
+		}
+
+	private:
+		static constexpr uint8_t indexMask = 0x3;
+		static constexpr uint8_t freshBit = 0x4;
+
+		std::array<T, 3> m_buffers {};
+
+		uint8_t m_write { 0 };
+		// Index of the middle buffer, with freshBit while it holds a value nobody acquired
+		std::atomic<uint8_t> m_middle { 1 };
+		uint8_t m_read { 2 };
+	};
+
+};
+
+#endif // CORE_TRIPLEBUFFER_HPP
@@ -0,0 +1,41 @@
+#ifndef CORE_WORKSTEALINGDEQUE_HPP
+#define CORE_WORKSTEALINGDEQUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include "StCore/Job.hpp"
+
+namespace st::core
+{
+
+	// Chase-Lev deque of a single worker. The owner pushes and pops at the bottom without locks,
+	// other workers steal from the top with one compare exchange. The ring is fixed, a push into a
+	// full deque fails and the caller runs the job itself.
+	class WorkStealingDeque
+	{
+	public:
+		static constexpr uint32_t capacity = 4096;
+
+		// Owner only
+		bool push(const Job& job);
+		std::optional<Job> pop();
+
+		// Any thread
+		std::optional<Job> steal();
+
+	private:
+		static constexpr int64_t mask = capacity - 1;
+		static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+		// Own cache lines, thieves hammer the top while the owner works the bottom
+		alignas(64) std::atomic<int64_t> m_top { 0 };
+		alignas(64) std::atomic<int64_t> m_bottom { 0 };
+		alignas(64) std::array<Job, capacity> m_jobs;
+	};
+
+};
+
+#endif // CORE_WORKSTEALINGDEQUE_HPP
@@ -0,0 +1,21 @@
+#ifndef GEOMETRY_MATRIXBATCH_HPP
+#define GEOMETRY_MATRIXBATCH_HPP
+
+#include <span>
+#include "Matrix4x4.hpp"
+
+namespace st::math
+{
+
+    /*! \brief Multiplies one matrix with many
+     *
+     *  result[i] = lhs * rhs[i], the usual case being a view projection applied to every model
+     *  matrix of a frame. The broadcast terms of lhs are computed once and each product is four
+     *  SSE or NEON row operations, with a scalar path on other targets. result must be at least
+     *  as long as rhs and may alias it.
+     */
+    void multiplyBatch(const Matrix4x4& lhs, std::span<const Matrix4x4> rhs, std::span<Matrix4x4> result);
+
+}
+
+#endif // !GEOMETRY_MATRIXBATCH_HPP
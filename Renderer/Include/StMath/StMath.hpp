@@ -5,6 +5,8 @@
 #include "Vector3.hpp"
 #include "Vector4.hpp"
 #include "Matrix4x4.hpp"
+#include "MatrixBatch.hpp"
+#include "TransformBuffer.hpp"
 
 
 
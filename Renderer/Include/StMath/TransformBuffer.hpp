@@ -0,0 +1,64 @@
+#ifndef GEOMETRY_TRANSFORMBUFFER_HPP
+#define GEOMETRY_TRANSFORMBUFFER_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "Matrix4x4.hpp"
+
+namespace st::math
+{
+
+    /*! \brief Transforms of one simulation tick, one array per component
+     *
+     *  Rotations are unit quaternions, scale is uniform. Loops over a single component touch
+     *  only that array, which keeps them in cache and lets the compiler vectorize them.
+     */
+    struct TransformStream
+    {
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+        std::vector<float> positionZ;
+
+        std::vector<float> rotationX;
+        std::vector<float> rotationY;
+        std::vector<float> rotationZ;
+        std::vector<float> rotationW;
+
+        std::vector<float> scale;
+
+        void resize(size_t count);
+        size_t size() const;
+    };
+
+    /*! \brief Previous and current tick of a set of transforms
+     *
+     *  The simulation writes the current stream once per tick, after beginTick() kept the old
+     *  one as previous. Rendering blends the two by the fraction of a tick that has passed, so
+     *  motion stays smooth when the display runs faster or slower than the simulation.
+     */
+    class TransformBuffer
+    {
+    public:
+        // New transforms are the identity in both ticks
+        void resize(size_t count);
+        size_t size() const;
+
+        void beginTick();
+
+        TransformStream& current();
+        const TransformStream& current() const;
+        const TransformStream& previous() const;
+
+        // Position lerp, rotation nlerp and scale lerp into model matrices, models must be at
+        // least size() long
+        void interpolate(float alpha, std::span<Matrix4x4> models) const;
+
+    private:
+        TransformStream m_previous;
+        TransformStream m_current;
+    };
+
+}
+
+#endif // !GEOMETRY_TRANSFORMBUFFER_HPP
@@ -0,0 +1,64 @@
+#ifndef RENDERER_BINDLESSTEXTURES_HPP
+#define RENDERER_BINDLESSTEXTURES_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+
+namespace st::renderer
+{
+
+	// Index of a texture in the bindless array, stored in InstanceData::m_materialIndex
+	using TextureHandle = uint32_t;
+
+	struct GpuTexture
+	{
+		vk::Image image;
+		MemoryAllocation memory;
+		vk::ImageView view;
+	};
+
+	// One update-after-bind descriptor set holding a runtime sized array of combined image samplers.
+	// It is bound once per frame and shaders select the texture with an index, so adding materials
+	// neither rebinds descriptor sets per draw nor waits for the frames in flight.
+	class BindlessTextures
+	{
+	public:
+		static constexpr uint32_t defaultCapacity = 4096;
+
+		BindlessTextures() = default;
+		~BindlessTextures();
+
+		BindlessTextures(const BindlessTextures&) = delete;
+		BindlessTextures& operator=(const BindlessTextures&) = delete;
+
+		// Descriptor indexing is core in Vulkan 1.2, the features below must be enabled on the device
+		static bool isSupported(const vk::PhysicalDeviceVulkan12Features& features);
+		static void enableFeatures(vk::PhysicalDeviceVulkan12Features& features);
+
+		// The capacity is clamped to the update-after-bind limits of the device
+		void init(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t capacity = defaultCapacity);
+		void shutdown();
+
+		bool isEnabled() const;
+
+		// The view must stay alive until shutdown, slots are never reused
+		TextureHandle add(vk::ImageView view, vk::Sampler sampler);
+
+		vk::DescriptorSetLayout getSetLayout() const;
+		vk::DescriptorSet getDescriptorSet() const;
+
+	private:
+		vk::Device m_device;
+
+		vk::DescriptorSetLayout m_setLayout;
+		vk::DescriptorPool m_descriptorPool;
+		vk::DescriptorSet m_descriptorSet;
+
+		uint32_t m_capacity { 0 };
+		uint32_t m_count { 0 };
+	};
+
+};
+
+#endif // RENDERER_BINDLESSTEXTURES_HPP
@@ -38,6 +38,9 @@ namespace st::renderer
 
 
 		math::Matrix4x4 getViewMatrix() const;
+		math::Vector3 getEye() const;
+		math::Vector3 getCenter() const;
+		math::Vector3 getUp() const;
 		math::Matrix4x4 getProjectionMatrix(float fovy, float aspect, float nearPlane, float farPlane) const;
 
 
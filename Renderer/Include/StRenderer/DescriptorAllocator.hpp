@@ -0,0 +1,105 @@
+#ifndef RENDERER_DESCRIPTORALLOCATOR_HPP
+#define RENDERER_DESCRIPTORALLOCATOR_HPP
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace st::renderer
+{
+
+	// Descriptors of each type per set of a pool
+	struct DescriptorPoolRatio
+	{
+		vk::DescriptorType type;
+		float ratio;
+	};
+
+	// Allocates descriptor sets from a chain of pools, a new and larger pool is created whenever the
+	// current one runs out, so allocation never fails on pool capacity. Sets are not freed one by
+	// one, reset() recycles every pool at once. A transient allocator per frame in flight is reset
+	// once the fence of its frame signaled.
+	class DescriptorAllocator
+	{
+	public:
+		static constexpr uint32_t defaultSetsPerPool = 64;
+		static constexpr uint32_t maxSetsPerPool = 4096;
+
+		DescriptorAllocator() = default;
+		~DescriptorAllocator();
+
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		void init(vk::Device device, uint32_t setsPerPool = defaultSetsPerPool);
+		void init(vk::Device device, uint32_t setsPerPool, std::span<const DescriptorPoolRatio> ratios);
+		void shutdown();
+
+		vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+		// Every set allocated so far becomes invalid, the GPU must be done with them
+		void reset();
+
+		uint32_t getPoolCount() const;
+
+	private:
+		vk::DescriptorPool createPool(uint32_t setCount) const;
+		vk::DescriptorPool nextPool();
+
+		vk::Device m_device;
+		std::vector<DescriptorPoolRatio> m_ratios;
+		uint32_t m_setsPerPool { defaultSetsPerPool };
+
+		vk::DescriptorPool m_currentPool;
+		std::vector<vk::DescriptorPool> m_fullPools;
+		std::vector<vk::DescriptorPool> m_readyPools;
+	};
+
+	// A single descriptor of a set, only the info matching the type is used
+	struct DescriptorBinding
+	{
+		uint32_t binding;
+		vk::DescriptorType type;
+		vk::DescriptorBufferInfo buffer;
+		vk::DescriptorImageInfo image;
+
+		bool operator==(const DescriptorBinding&) const = default;
+	};
+
+	// Sets keyed by their layout and contents, identical requests return the same set so it is
+	// written once. Sets come from the given allocator and live until it is reset.
+	class DescriptorCache
+	{
+	public:
+		void init(vk::Device device, DescriptorAllocator& allocator);
+
+		vk::DescriptorSet get(vk::DescriptorSetLayout layout, std::span<const DescriptorBinding> bindings);
+
+		// Call after destroying resources referenced by cached sets or resetting the allocator
+		void clear();
+
+		size_t size() const;
+
+	private:
+		struct Key
+		{
+			vk::DescriptorSetLayout layout;
+			std::vector<DescriptorBinding> bindings;
+
+			bool operator==(const Key&) const = default;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		vk::Device m_device;
+		DescriptorAllocator* m_allocator { nullptr };
+		std::unordered_map<Key, vk::DescriptorSet, KeyHash> m_sets;
+	};
+
+};
+
+#endif // RENDERER_DESCRIPTORALLOCATOR_HPP
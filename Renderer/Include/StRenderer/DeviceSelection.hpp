@@ -0,0 +1,49 @@
+#ifndef RENDERER_DEVICESELECTION_HPP
+#define RENDERER_DEVICESELECTION_HPP
+
+#include <string>
+#include <vulkan/vulkan.hpp>
+
+namespace st::renderer
+{
+
+	// Optional capabilities the renderer has a faster path for. Filled per candidate when the
+	// devices are ranked, the renderer keeps the set it enabled on the logical device.
+	struct DeviceFeatures
+	{
+		// Bindless textures, see BindlessTextures::isSupported
+		bool descriptorIndexing { false };
+		// VkPhysicalDeviceVulkan12Features::timelineSemaphore, required by the frame loop
+		bool timelineSemaphore { false };
+		// VkPhysicalDeviceVulkan12Features::drawIndirectCount
+		bool drawIndirectCount { false };
+		// VkPhysicalDeviceFeatures::multiDrawIndirect
+		bool multiDrawIndirect { false };
+		// VK_EXT_memory_budget, the allocator statistics report the device local budget
+		bool memoryBudget { false };
+		// A transfer family without graphics, uploads overlap with rendering
+		bool dedicatedTransferQueue { false };
+		// A compute family without graphics, nothing is submitted to it yet
+		bool asyncComputeQueue { false };
+	};
+
+	// What the renderer knows about a physical device when choosing one
+	struct DeviceProfile
+	{
+		vk::PhysicalDevice physicalDevice;
+		std::string name;
+		vk::PhysicalDeviceType type { vk::PhysicalDeviceType::eOther };
+		// Largest device local heap, on integrated GPUs this is shared with the system
+		vk::DeviceSize deviceLocalMemory { 0 };
+		DeviceFeatures features;
+
+		static DeviceProfile query(vk::PhysicalDevice physicalDevice);
+
+		// Higher is better. The device type dominates, memory, queue layout and features only
+		// order devices of the same type, so an integrated GPU is taken when it is the only one.
+		uint64_t score() const;
+	};
+
+};
+
+#endif // RENDERER_DEVICESELECTION_HPP
@@ -0,0 +1,91 @@
+#ifndef RENDERER_DRAWLIST_HPP
+#define RENDERER_DRAWLIST_HPP
+
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace st::renderer
+{
+
+	// 64 bit sort key, from the most significant bits: pass, pipeline, material, mesh and depth.
+	// Sorting by it groups draws by the state they bind, the most expensive change first, and
+	// orders draws sharing all state front to back. Fields wider than their bits are truncated,
+	// which only costs grouping, never correctness.
+	struct DrawKey
+	{
+		static constexpr uint32_t passBits = 4;
+		static constexpr uint32_t pipelineBits = 12;
+		static constexpr uint32_t materialBits = 16;
+		static constexpr uint32_t meshBits = 16;
+		static constexpr uint32_t depthBits = 16;
+
+		static uint64_t make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+
+		// Maps a view space distance in [0, farPlane] to the depth field
+		static uint32_t quantizeDepth(float distance, float farPlane);
+
+		static uint32_t pass(uint64_t key);
+	};
+
+	struct DrawPacket
+	{
+		uint64_t key;
+		// Index into the draw data of the owner
+		uint32_t payload;
+	};
+
+	// Draw packets of one frame, sorted with an LSD radix sort on the key. Byte positions where every
+	// key holds the same value are skipped, so the usual case costs a few linear passes.
+	class DrawList
+	{
+	public:
+		void clear();
+		void add(uint64_t key, uint32_t payload);
+		void sort();
+
+		std::span<const DrawPacket> getPackets() const;
+		bool empty() const;
+
+	private:
+		std::vector<DrawPacket> m_packets;
+		std::vector<DrawPacket> m_scratch;
+	};
+
+	struct DrawStatistics
+	{
+		uint32_t drawCount { 0 };
+		uint32_t pipelineBinds { 0 };
+		uint32_t bufferBinds { 0 };
+		// Binds skipped because the state was already bound
+		uint32_t bindsSaved { 0 };
+	};
+
+	// Filters redundant binds while recording and counts them. State persists across render passes
+	// of a command buffer but is not inherited by secondaries, each needs a tracker of its own.
+	class CommandStateCache
+	{
+	public:
+		CommandStateCache(vk::CommandBuffer commandBuffer, DrawStatistics& statistics);
+
+		void bindPipeline(vk::Pipeline pipeline);
+		void bindVertexBuffer(uint32_t binding, vk::Buffer buffer);
+		void bindIndexBuffer(vk::Buffer buffer);
+
+		// Call after binds issued directly on the command buffer
+		void invalidate();
+
+	private:
+		static constexpr uint32_t maxVertexBindings = 2;
+
+		vk::CommandBuffer m_commandBuffer;
+		DrawStatistics* m_statistics;
+
+		vk::Pipeline m_pipeline;
+		vk::Buffer m_vertexBuffers[maxVertexBindings];
+		vk::Buffer m_indexBuffer;
+	};
+
+};
+
+#endif // RENDERER_DRAWLIST_HPP
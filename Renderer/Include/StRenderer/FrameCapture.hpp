@@ -0,0 +1,78 @@
+#ifndef RENDERER_FRAMECAPTURE_HPP
+#define RENDERER_FRAMECAPTURE_HPP
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StCore/JobSystem.hpp"
+#include "StRenderer/MemoryAllocator.hpp"
+
+namespace st::renderer
+{
+
+	// Copies a finished frame into a host visible buffer of its frame slot. The pixels are read once
+	// the fence of the slot signaled and encoded in the background of the job system, so a capture
+	// never stalls the frame loop. Paths ending in .png are written as PNG, anything else as binary PPM.
+	class FrameCapture
+	{
+	public:
+		FrameCapture() = default;
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		void init(vk::Device device, MemoryAllocator& allocator, vk::CommandPool commandPool, uint32_t frameCount, st::core::JobSystem& jobSystem);
+		void shutdown();
+
+		// Captures the next recorded frame
+		void request(const std::string& path);
+
+		// The image must be in eTransferSrcOptimal after color attachment writes, 8 bit RGBA or BGRA.
+		// Returns the command buffer to submit after the frame, null when nothing was requested.
+		vk::CommandBuffer record(uint32_t frameIndex, vk::Image image, vk::Format format, vk::Extent2D extent);
+
+		// The fence of the frame signaled, its pixels go to a background job
+		void collect(uint32_t frameIndex);
+
+		// Blocks until every collected capture is on disk
+		void waitIdle();
+
+	private:
+		struct Frame
+		{
+			vk::CommandBuffer commandBuffer;
+			vk::Buffer buffer;
+			MemoryAllocation memory;
+			vk::DeviceSize capacity { 0 };
+
+			// Empty when the frame recorded no capture
+			std::string path;
+			vk::Extent2D extent;
+			bool bgra { false };
+		};
+
+		// Owned by its write job, which deletes it
+		struct PendingWrite
+		{
+			std::string path;
+			vk::Extent2D extent;
+			std::vector<uint8_t> rgba;
+		};
+
+		static void write(const std::string& path, vk::Extent2D extent, const std::vector<uint8_t>& rgba);
+
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+		vk::CommandPool m_commandPool;
+
+		std::vector<Frame> m_frames;
+		std::string m_requestedPath;
+		st::core::JobSystem* m_jobSystem { nullptr };
+		st::core::JobCounter m_pendingWrites;
+	};
+
+};
+
+#endif // RENDERER_FRAMECAPTURE_HPP
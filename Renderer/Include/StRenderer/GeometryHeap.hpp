@@ -0,0 +1,105 @@
+#ifndef RENDERER_GEOMETRYHEAP_HPP
+#define RENDERER_GEOMETRYHEAP_HPP
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+#include "StRenderer/Mesh.hpp"
+#include "StRenderer/TlsfAllocator.hpp"
+#include "StRenderer/TransferContext.hpp"
+
+namespace st::renderer
+{
+
+	// One device-local vertex buffer and one index buffer shared by every static mesh. Meshes are
+	// sub-allocated with a TLSF allocator counting in vertices and indices, so an allocation offset
+	// is directly the vertexOffset and firstIndex of the draw. All meshes bind the same two buffers,
+	// which lets draws of different meshes follow each other without rebinding.
+	//
+	// Geometry is deduplicated by a hash of its contents, adding the same data twice returns the
+	// existing range with a reference more. Each entry keeps a CPU copy of its data and a hash hit
+	// is only shared when the copy matches. Released ranges are reused once the frames that may
+	// still read them completed.
+	class GeometryHeap
+	{
+	public:
+		static constexpr uint32_t defaultVertexCapacity = 1U << 20;
+		static constexpr uint32_t defaultIndexCapacity = 4U << 20;
+
+		GeometryHeap() = default;
+		~GeometryHeap();
+
+		GeometryHeap(const GeometryHeap&) = delete;
+		GeometryHeap& operator=(const GeometryHeap&) = delete;
+
+		void init(vk::Device device,
+				  MemoryAllocator& allocator,
+				  TransferContext& transferContext,
+				  uint32_t frameCount,
+				  uint32_t vertexCapacity = defaultVertexCapacity,
+				  uint32_t indexCapacity = defaultIndexCapacity);
+		void shutdown();
+
+		// Indices are relative to the mesh, the upload goes through the transfer context. Empty
+		// geometry is rejected.
+		GeometryRange add(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+		void release(const GeometryRange& range);
+
+		// Frees the ranges released during the previous use of the frame, its fence must have signaled
+		void beginFrame(uint32_t frameIndex);
+
+		// Binds both buffers at vertex binding 0
+		void bind(vk::CommandBuffer commandBuffer) const;
+
+		vk::Buffer getVertexBuffer() const;
+		vk::Buffer getIndexBuffer() const;
+
+		uint32_t getUsedVertices() const;
+		uint32_t getUsedIndices() const;
+
+	private:
+		struct Entry
+		{
+			uint64_t contentHash { 0 };
+			TlsfAllocator::Allocation vertices;
+			TlsfAllocator::Allocation indices;
+			uint32_t vertexCount { 0 };
+			uint32_t indexCount { 0 };
+			uint32_t references { 0 };
+
+			// Compared against on a hash hit
+			std::vector<Vertex> vertexData;
+			std::vector<uint32_t> indexData;
+		};
+
+		static uint64_t hashGeometry(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+
+		void free(uint32_t entry);
+
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+		TransferContext* m_transferContext { nullptr };
+
+		vk::Buffer m_vertexBuffer;
+		MemoryAllocation m_vertexMemory;
+		vk::Buffer m_indexBuffer;
+		MemoryAllocation m_indexMemory;
+
+		TlsfAllocator m_vertexAllocator;
+		TlsfAllocator m_indexAllocator;
+
+		std::vector<Entry> m_entries;
+		std::vector<uint32_t> m_unusedEntries;
+		std::unordered_map<uint64_t, uint32_t> m_entriesByHash;
+
+		// Entries released while each frame was recorded
+		std::vector<std::vector<uint32_t>> m_pendingFrees;
+		uint32_t m_frameIndex { 0 };
+	};
+
+};
+
+#endif // RENDERER_GEOMETRYHEAP_HPP
@@ -0,0 +1,234 @@
+#ifndef RENDERER_GPUCULLING_HPP
+#define RENDERER_GPUCULLING_HPP
+
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StMath/StMath.hpp"
+#include "StRenderer/DescriptorAllocator.hpp"
+#include "StRenderer/MemoryAllocator.hpp"
+#include "StRenderer/Mesh.hpp"
+#include "StRenderer/PipelineManager.hpp"
+#include "StRenderer/UniformRing.hpp"
+
+namespace st::renderer
+{
+
+	// Normalized planes, xyz is the inward facing normal and w the distance
+	using FrustumPlanes = std::array<math::Vector4, 6>;
+
+	// Extracts the planes of a row-major view projection matrix with a [0, 1] depth range
+	FrustumPlanes extractFrustumPlanes(const math::Matrix4x4& viewProjection);
+
+	// Camera state read by the cull shader, mirrors CullView in cull.comp (std140)
+	struct CullView
+	{
+		// Column-major
+		math::Matrix4x4 view;
+		FrustumPlanes frustumPlanes;
+		// P00, P11, P22 and P23 of the row-major projection
+		float projection[4];
+		float nearPlane;
+		uint32_t pyramidWidth;
+		uint32_t pyramidHeight;
+		uint32_t pyramidLevels;
+	};
+
+	// Takes row-major matrices as returned by the camera
+	CullView makeCullView(const math::Matrix4x4& view, const math::Matrix4x4& projection);
+
+	enum class CullPhase : uint32_t
+	{
+		// Instances visible last frame, drawn before the depth pyramid is built
+		eEarly,
+		// Everything else, tested against the depth pyramid of the early draws
+		eLate
+	};
+
+	// Two phase GPU culling. The early phase frustum culls the instances that were visible last
+	// frame and draws them, their depth is reduced into a hierarchical-Z pyramid and the late phase
+	// tests every instance against it: newly visible ones are drawn on top and the result becomes
+	// the visibility history of the next frame. Each phase compacts VkDrawIndexedIndirectCommands
+	// into the command range of every MeshDraw and counts them for drawIndexedIndirectCount, so the
+	// CPU cost is a few dispatches plus two indirect draws per MeshDraw regardless of instance count.
+	//
+	// Instance visibility is tracked by index, so it carries over as long as the application
+	// submits its instances in the same order every frame.
+	class GpuCulling
+	{
+	public:
+		struct Features
+		{
+			// VkPhysicalDeviceVulkan12Features::drawIndirectCount
+			bool drawIndirectCount { false };
+			// VkPhysicalDeviceFeatures::multiDrawIndirect
+			bool multiDrawIndirect { false };
+		};
+
+		GpuCulling() = default;
+		~GpuCulling();
+
+		GpuCulling(const GpuCulling&) = delete;
+		GpuCulling& operator=(const GpuCulling&) = delete;
+
+		void init(vk::Device device,
+				  MemoryAllocator& allocator,
+				  PipelineManager& pipelineManager,
+				  UniformRing& uniformRing,
+				  uint32_t frameCount,
+				  Features features);
+		void shutdown();
+
+		// (Re)creates the depth pyramid for a depth attachment of this size. The previous pyramid is
+		// destroyed by beginFrame(frameIndex), frameIndex must be the slot of the last submitted frame.
+		// The depth image is sampled in eDepthStencilReadOnlyOptimal.
+		void resize(vk::ImageView depthView, vk::Extent2D extent, uint32_t frameIndex);
+
+		// Destroys the pyramids retired into this frame, its fence must have signaled
+		void beginFrame(uint32_t frameIndex);
+
+		// Both compute pipelines compile on the pipeline workers, until then the caller draws directly
+		bool isReady() const;
+
+		// Writes the per draw table and the camera of the frame, instanceBuffer must hold the frame
+		// instances and have storage buffer usage. The uniform ring must be in this frame, the
+		// descriptor set comes from the transient allocator of the frame.
+		void prepare(uint32_t frameIndex,
+					 vk::Buffer instanceBuffer,
+					 std::span<const MeshDraw> draws,
+					 std::span<const GpuMesh> meshes,
+					 uint32_t instanceCount,
+					 DescriptorAllocator& frameDescriptors,
+					 CullView view);
+
+		// Outside of a render pass, ends with a barrier making the commands visible to the indirect stage
+		void recordCulling(vk::CommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase);
+
+		// Between the phases, after the early render pass left the depth in eDepthStencilReadOnlyOptimal
+		void recordDepthPyramid(vk::CommandBuffer commandBuffer) const;
+
+		// Inside the render pass with the mesh pipeline, the geometry heap and the instance binding bound
+		void recordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase, std::span<const MeshDraw> draws) const;
+
+	private:
+		// Mirrors CullBatch in cull.comp
+		struct CullBatch
+		{
+			math::Vector4 boundingSphere;
+			uint32_t indexCount;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+			uint32_t firstIndex;
+			int32_t vertexOffset;
+			uint32_t padding[3] { 0, 0, 0 };
+		};
+
+		struct CullConstants
+		{
+			uint32_t instanceCount;
+			uint32_t batchCount;
+			uint32_t historyCount;
+			CullPhase phase;
+		};
+
+		struct ReduceConstants
+		{
+			int32_t sourceWidth;
+			int32_t sourceHeight;
+			int32_t destinationWidth;
+			int32_t destinationHeight;
+		};
+
+		struct FrameBuffer
+		{
+			vk::Buffer buffer;
+			MemoryAllocation memory;
+			vk::DeviceSize capacity { 0 };
+		};
+
+		struct PyramidLevel
+		{
+			vk::ImageView view;
+			vk::DescriptorSet descriptorSet;
+			vk::Extent2D extent;
+		};
+
+		struct RetiredPyramid
+		{
+			vk::Image image;
+			MemoryAllocation memory;
+			vk::ImageView view;
+			std::vector<PyramidLevel> levels;
+		};
+
+		struct Frame
+		{
+			FrameBuffer batches;
+			// Early commands first, then the late ones, same for the counters
+			FrameBuffer commands;
+			FrameBuffer counts;
+			// Written by the late phase, read by the early phase of the next frame
+			FrameBuffer visibility;
+			// Previous visibility buffer, may still be read as history by the frame in flight
+			FrameBuffer retiredVisibility;
+			// Replaced by a resize after this frame was submitted
+			std::vector<RetiredPyramid> retiredPyramids;
+
+			vk::DescriptorSet descriptorSet;
+			uint32_t viewOffset { 0 };
+			uint32_t instanceCount { 0 };
+			uint32_t drawCount { 0 };
+			uint32_t historyCount { 0 };
+		};
+
+		static constexpr uint32_t workgroupSize = 64;
+		static constexpr uint32_t reduceWorkgroupSize = 8;
+		static constexpr uint32_t maxPyramidLevels = 16;
+
+		void createCullResources(uint32_t frameCount);
+		void createPyramidResources();
+		RetiredPyramid retirePyramid();
+		void destroy(RetiredPyramid& pyramid);
+
+		void ensureCapacity(FrameBuffer& frameBuffer, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
+		void destroy(FrameBuffer& frameBuffer);
+
+		vk::DeviceSize commandBase(const Frame& frame, CullPhase phase) const;
+		vk::DeviceSize countBase(const Frame& frame, CullPhase phase) const;
+
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+		PipelineManager* m_pipelineManager { nullptr };
+		UniformRing* m_uniformRing { nullptr };
+		Features m_features;
+
+		vk::DescriptorSetLayout m_cullSetLayout;
+		vk::PipelineLayout m_cullLayout;
+		PipelineHandle m_cullPipeline { 0 };
+
+		std::vector<Frame> m_frames;
+		// Frame whose late phase ran last, its visibility is the history of the next frame
+		std::optional<uint32_t> m_historyFrame;
+		// Instances its late phase wrote, the slot may have been prepared again since
+		uint32_t m_historyInstanceCount { 0 };
+
+		vk::DescriptorSetLayout m_reduceSetLayout;
+		vk::DescriptorPool m_reduceDescriptorPool;
+		vk::PipelineLayout m_reduceLayout;
+		PipelineHandle m_reducePipeline { 0 };
+
+		vk::Sampler m_pyramidSampler;
+		vk::Image m_pyramidImage;
+		MemoryAllocation m_pyramidMemory;
+		vk::ImageView m_pyramidView;
+		std::vector<PyramidLevel> m_pyramidLevels;
+		vk::ImageView m_depthView;
+		vk::Extent2D m_depthExtent;
+	};
+
+};
+
+#endif // RENDERER_GPUCULLING_HPP
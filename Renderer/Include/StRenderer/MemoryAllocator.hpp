@@ -0,0 +1,142 @@
+#ifndef RENDERER_MEMORYALLOCATOR_HPP
+#define RENDERER_MEMORYALLOCATOR_HPP
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/TlsfAllocator.hpp"
+
+namespace st::renderer
+{
+
+	struct MemoryAllocation
+	{
+		enum class Kind : uint32_t
+		{
+			eNone,
+			eBlock,
+			eDedicated
+		};
+
+		vk::DeviceMemory memory;
+		vk::DeviceSize offset { 0 };
+		vk::DeviceSize size { 0 };
+		void* mappedData { nullptr };
+		uint32_t memoryType { 0 };
+
+		Kind kind { Kind::eNone };
+		uint32_t blockList { 0 };
+		uint32_t block { 0 };
+		TlsfAllocator::Allocation subAllocation;
+	};
+
+	struct MemoryStatistics
+	{
+		uint32_t deviceMemoryCount { 0 };
+		uint32_t blockCount { 0 };
+		uint32_t dedicatedAllocationCount { 0 };
+		uint32_t allocationCount { 0 };
+
+		vk::DeviceSize blockBytes { 0 };
+		vk::DeviceSize blockUsedBytes { 0 };
+		vk::DeviceSize dedicatedBytes { 0 };
+
+		// Summed over device local heaps, only reported with VK_EXT_memory_budget. Usage
+		// includes other processes, allocating past the budget risks eviction or failure.
+		vk::DeviceSize deviceLocalBudget { 0 };
+		vk::DeviceSize deviceLocalUsage { 0 };
+	};
+
+
+	// Sub-allocates buffers and images from large VkDeviceMemory blocks, one TLSF heap per block.
+	// Buffers and optimal tiled images never share a block, which keeps them bufferImageGranularity
+	// apart without padding every allocation.
+	class MemoryAllocator
+	{
+	public:
+		static constexpr vk::DeviceSize defaultBlockSize = 64ULL * 1024 * 1024;
+
+		MemoryAllocator() = default;
+		~MemoryAllocator();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+		// memoryBudget requires VK_EXT_memory_budget enabled on the device
+		void init(vk::PhysicalDevice physicalDevice,
+				  vk::Device device,
+				  bool memoryBudget = false,
+				  vk::DeviceSize blockSize = defaultBlockSize);
+		void shutdown();
+
+		MemoryAllocation allocateForBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties);
+		MemoryAllocation allocateForImage(vk::Image image, vk::MemoryPropertyFlags properties);
+		// For optimal tiled images sharing memory, the caller merges their requirements
+		MemoryAllocation allocateAliased(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties);
+
+		void free(MemoryAllocation& allocation);
+
+		// No-op for coherent memory
+		void flush(const MemoryAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) const;
+		bool isCoherent(const MemoryAllocation& allocation) const;
+
+		uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+
+		MemoryStatistics getStatistics() const;
+
+	private:
+		enum class ResourceKind : uint32_t
+		{
+			eLinear,
+			eOptimal,
+			eCount
+		};
+
+		struct Block
+		{
+			vk::DeviceMemory memory;
+			void* mappedData { nullptr };
+			TlsfAllocator allocator;
+		};
+
+		struct MemoryTypeBlocks
+		{
+			std::array<std::vector<std::unique_ptr<Block>>, static_cast<size_t>(ResourceKind::eCount)> blocks;
+		};
+
+		MemoryAllocation allocate(const vk::MemoryRequirements& requirements,
+								  vk::MemoryPropertyFlags properties,
+								  ResourceKind resourceKind,
+								  bool dedicated,
+								  vk::Buffer buffer,
+								  vk::Image image);
+
+		MemoryAllocation allocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memoryType, vk::Buffer buffer, vk::Image image);
+
+		vk::DeviceMemory allocateDeviceMemory(vk::DeviceSize size, uint32_t memoryType, const void* pNext, void*& mappedData);
+		void freeDeviceMemory(vk::DeviceMemory memory, void* mappedData);
+
+		vk::DeviceSize requiredAlignment(const vk::MemoryRequirements& requirements, uint32_t memoryType) const;
+		bool isHostVisible(uint32_t memoryType) const;
+
+		vk::PhysicalDevice m_physicalDevice;
+		vk::Device m_device;
+		vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+		vk::DeviceSize m_nonCoherentAtomSize { 1 };
+		vk::DeviceSize m_blockSize { defaultBlockSize };
+		bool m_memoryBudget { false };
+
+		mutable std::mutex m_mutex;
+		std::vector<MemoryTypeBlocks> m_memoryTypes;
+
+		uint32_t m_deviceMemoryCount { 0 };
+		uint32_t m_dedicatedAllocationCount { 0 };
+		vk::DeviceSize m_dedicatedBytes { 0 };
+	};
+
+};
+
+#endif // RENDERER_MEMORYALLOCATOR_HPP
@@ -0,0 +1,102 @@
+#ifndef RENDERER_MESH_HPP
+#define RENDERER_MESH_HPP
+
+#include <array>
+#include <ostream>
+#include <vulkan/vulkan.hpp>
+
+#include "StMath/StMath.hpp"
+
+namespace st::renderer
+{
+
+	struct Vertex
+	{
+		math::Vector3 m_pos;
+		math::Vector2 m_texCoord;
+		math::Vector3 m_color;
+		math::Vector3 m_normal;
+
+
+		static vk::VertexInputBindingDescription getBindingDescription();
+
+		static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions();
+
+		bool operator==(const Vertex&) const = default;
+		auto operator<=>(const Vertex&) const = default;
+
+
+		friend std::ostream& operator<<(std::ostream& os, const Vertex& vertex)
+		{
+			os << "\nVertex(\n";
+			os << "\tPos    {" << vertex.m_pos.X       << ", " << vertex.m_pos.Y      << ", " << vertex.m_pos.Z  << "}\n";
+			os << "\tUV     {" << vertex.m_texCoord.X  << ", " << vertex.m_texCoord.Y << "}\n";
+			os << "\tColor  {" << vertex.m_color.X     << ", " << vertex.m_color.Y    << ", " << vertex.m_color.Z  << "}\n";
+			os << "\tNormal {" << vertex.m_normal.X    << ", " << vertex.m_normal.Y   << ", " << vertex.m_normal.Z << "}\n";
+			os << ")\n";
+			return os;
+		}
+	};
+
+	// Per-instance data, fed to the vertex shader through the instance rate binding 1.
+	// The model matrix is row-major like every st::math matrix, the renderer transposes it on upload.
+	// Aligned so the stride matches the std430 array the cull shader reads it from.
+	struct alignas(16) InstanceData
+	{
+		math::Matrix4x4 m_model { math::Matrix4x4::indentityMatrix() };
+		math::Vector4 m_color { 1.0F, 1.0F, 1.0F, 1.0F };
+		uint32_t m_materialIndex { 0 };
+
+
+		static vk::VertexInputBindingDescription getBindingDescription();
+
+		static std::array<vk::VertexInputAttributeDescription, 6> getAttributeDescriptions();
+	};
+
+	using MeshHandle = uint32_t;
+
+	// Location of a mesh in the shared geometry heap
+	struct GeometryRange
+	{
+		uint32_t entry { 0 };
+		int32_t vertexOffset { 0 };
+		uint32_t firstIndex { 0 };
+		uint32_t indexCount { 0 };
+	};
+
+	struct GpuMesh
+	{
+		GeometryRange geometry;
+		// Object space, xyz is the center and w the radius
+		math::Vector4 boundingSphere;
+	};
+
+	// One instanced draw, its instances are a contiguous range of the frame instance buffer
+	struct MeshDraw
+	{
+		MeshHandle mesh;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	// Per-draw push constants of a single object, mirrors DrawConstants in VertexShaderObject.vert.
+	// Matrices stay row-major, the shader declares them row_major.
+	struct DrawConstants
+	{
+		math::Matrix4x4 m_modelViewProjection;
+		// Upper three rows of the model matrix, used for normals
+		float m_modelRows[12];
+		uint32_t m_materialIndex { 0 };
+	};
+
+	// A non-instanced draw, its model matrix is kept separately so the transforms of the frame can
+	// be premultiplied in one batch
+	struct ObjectDraw
+	{
+		MeshHandle mesh;
+		uint32_t materialIndex;
+	};
+
+};
+
+#endif // RENDERER_MESH_HPP
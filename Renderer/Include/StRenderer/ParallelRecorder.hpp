@@ -0,0 +1,69 @@
+#ifndef RENDERER_PARALLELRECORDER_HPP
+#define RENDERER_PARALLELRECORDER_HPP
+
+#include <functional>
+#include <memory_resource>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StCore/JobSystem.hpp"
+
+namespace st::renderer
+{
+
+	// Records a range of items into secondary command buffers on the job system's workers. Every
+	// range owns a command pool per frame slot, so recording takes no locks and a slot is reset with
+	// one call per pool instead of one per command buffer.
+	class ParallelRecorder
+	{
+	public:
+		// Records items [first, first + count) into commandBuffer, already begun inside the render
+		// pass of the inheritance info. worker indexes per range state and is below getWorkerCount(),
+		// no two calls with the same worker run at once.
+		using RecordCallback = std::function<void(vk::CommandBuffer commandBuffer, uint32_t worker, uint32_t first, uint32_t count)>;
+
+		ParallelRecorder() = default;
+		~ParallelRecorder();
+
+		ParallelRecorder(const ParallelRecorder&) = delete;
+		ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+		void init(vk::Device device, uint32_t queueFamilyIndex, uint32_t frameCount, st::core::JobSystem& jobSystem);
+		void shutdown();
+
+		// Resets every pool of the frame, its fence must have signaled
+		void beginFrame(uint32_t frameIndex);
+
+		// Splits the items into at most one range per worker and blocks until all are recorded. The
+		// calling thread records ranges too. Returns the secondaries in item order, at least one, in
+		// memory from the given resource.
+		std::pmr::vector<vk::CommandBuffer> record(uint32_t frameIndex,
+												   const vk::CommandBufferInheritanceInfo& inheritance,
+												   uint32_t itemCount,
+												   const RecordCallback& callback,
+												   std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+		// Of the job system, the calling thread included
+		uint32_t getWorkerCount() const;
+
+	private:
+		struct WorkerPool
+		{
+			vk::CommandPool commandPool;
+			// Allocated on demand and kept, the first `used` ones belong to the current frame
+			std::vector<vk::CommandBuffer> commandBuffers;
+			uint32_t used { 0 };
+		};
+
+		vk::CommandBuffer acquire(WorkerPool& pool);
+
+		vk::Device m_device;
+		st::core::JobSystem* m_jobSystem { nullptr };
+
+		// Indexed by frame slot, then range
+		std::vector<std::vector<WorkerPool>> m_pools;
+	};
+
+};
+
+#endif // RENDERER_PARALLELRECORDER_HPP
@@ -0,0 +1,171 @@
+#ifndef RENDERER_PIPELINEMANAGER_HPP
+#define RENDERER_PIPELINEMANAGER_HPP
+
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StCore/JobSystem.hpp"
+#include "StShader/ShaderPermutation.hpp"
+
+namespace st::renderer
+{
+
+	// Everything that makes two graphics pipelines different. Render pass and layout are
+	// referenced by the name they were registered under, so a recorded description stays
+	// valid between runs.
+	struct GraphicsPipelineDescription
+	{
+		std::string vertexShader;
+		std::string fragmentShader;
+
+		// Applied to both stages, ids a stage does not declare are ignored by the driver
+		std::vector<SpecializationConstant> specialization;
+
+		std::vector<vk::VertexInputBindingDescription> vertexBindings;
+		std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+
+		vk::PrimitiveTopology topology { vk::PrimitiveTopology::eTriangleList };
+		vk::PolygonMode polygonMode { vk::PolygonMode::eFill };
+		vk::CullModeFlags cullMode { vk::CullModeFlagBits::eBack };
+		vk::FrontFace frontFace { vk::FrontFace::eCounterClockwise };
+
+		bool depthTest { true };
+		bool depthWrite { true };
+		vk::CompareOp depthCompare { vk::CompareOp::eLess };
+
+		bool blendEnable { false };
+		vk::BlendFactor srcColorBlendFactor { vk::BlendFactor::eOne };
+		vk::BlendFactor dstColorBlendFactor { vk::BlendFactor::eZero };
+		vk::BlendOp colorBlendOp { vk::BlendOp::eAdd };
+		vk::BlendFactor srcAlphaBlendFactor { vk::BlendFactor::eOne };
+		vk::BlendFactor dstAlphaBlendFactor { vk::BlendFactor::eZero };
+		vk::BlendOp alphaBlendOp { vk::BlendOp::eAdd };
+
+		std::string renderPass;
+		uint32_t subpass { 0 };
+		std::string layout;
+
+		uint64_t hash() const;
+		bool operator==(const GraphicsPipelineDescription&) const = default;
+
+		void serialize(std::ostream& os) const;
+		static std::optional<GraphicsPipelineDescription> deserialize(std::istream& is);
+	};
+
+	struct ComputePipelineDescription
+	{
+		std::string computeShader;
+		std::vector<SpecializationConstant> specialization;
+		std::string layout;
+
+		uint64_t hash() const;
+		bool operator==(const ComputePipelineDescription&) const = default;
+
+		void serialize(std::ostream& os) const;
+		static std::optional<ComputePipelineDescription> deserialize(std::istream& is);
+	};
+
+	// The hash of the description, the next free value when another description already has it
+	using PipelineHandle = uint64_t;
+
+
+	class PipelineManager
+	{
+	public:
+		PipelineManager() = default;
+		~PipelineManager();
+
+		PipelineManager(const PipelineManager&) = delete;
+		PipelineManager& operator=(const PipelineManager&) = delete;
+
+		void init(vk::Device device, const std::string& cacheDirectory, st::core::JobSystem& jobSystem);
+		void shutdown();
+
+		void registerRenderPass(const std::string& name, vk::RenderPass renderPass);
+		void registerLayout(const std::string& name, vk::PipelineLayout layout);
+
+		// Compile the variant in the background of the job system, getPipeline returns the fallback until it is done
+		PipelineHandle request(const GraphicsPipelineDescription& description);
+		// Compile on the calling thread, used for pipelines that must exist before the first frame
+		PipelineHandle compileNow(const GraphicsPipelineDescription& description);
+
+		PipelineHandle request(const ComputePipelineDescription& description);
+		PipelineHandle compileNow(const ComputePipelineDescription& description);
+
+		// Pipeline returned for every variant of the render pass that is not ready yet
+		void setFallback(const std::string& renderPass, PipelineHandle handle);
+
+		vk::Pipeline getPipeline(PipelineHandle handle) const;
+		bool isReady(PipelineHandle handle) const;
+
+		// Request every variant recorded by previous runs
+		uint32_t prewarm();
+		void waitIdle();
+
+		vk::PipelineCache getPipelineCache() const;
+
+	private:
+		enum class VariantState : uint32_t
+		{
+			ePending,
+			eReady,
+			eFailed
+		};
+
+		using Description = std::variant<GraphicsPipelineDescription, ComputePipelineDescription>;
+
+		struct Variant
+		{
+			// The compile job only gets the variant
+			const PipelineManager* manager { nullptr };
+			Description description;
+			// Null for compute pipelines
+			vk::RenderPass renderPass;
+			vk::PipelineLayout layout;
+
+			std::atomic<VkPipeline> pipeline { VK_NULL_HANDLE };
+			std::atomic<VariantState> state { VariantState::ePending };
+		};
+
+		PipelineHandle requestVariant(const Description& description, PipelineHandle handle);
+		PipelineHandle compileVariantNow(const Description& description, PipelineHandle handle);
+
+		// Moves the handle past variants whose description only shares the hash
+		Variant* findOrInsert(const Description& description, PipelineHandle& handle, bool& inserted);
+		void compile(Variant& variant) const;
+		vk::Pipeline compileGraphics(const GraphicsPipelineDescription& description, vk::RenderPass renderPass, vk::PipelineLayout layout) const;
+		vk::Pipeline compileCompute(const ComputePipelineDescription& description, vk::PipelineLayout layout) const;
+
+		void loadPipelineCache();
+		void savePipelineCache() const;
+		void saveVariantList() const;
+
+		std::string pipelineCachePath() const;
+		std::string variantListPath() const;
+
+		vk::Device m_device;
+		vk::PipelineCache m_pipelineCache;
+		std::string m_cacheDirectory;
+
+		st::core::JobSystem* m_jobSystem { nullptr };
+		st::core::JobCounter m_pendingCompiles;
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<PipelineHandle, std::unique_ptr<Variant>> m_variants;
+		std::vector<PipelineHandle> m_requestOrder;
+		std::unordered_map<std::string, vk::RenderPass> m_renderPasses;
+		std::unordered_map<std::string, vk::PipelineLayout> m_layouts;
+		std::unordered_map<std::string, PipelineHandle> m_fallbacks;
+	};
+
+};
+
+#endif // RENDERER_PIPELINEMANAGER_HPP
@@ -0,0 +1,43 @@
+#ifndef RENDERER_PRESENTATIONPOLICY_HPP
+#define RENDERER_PRESENTATIONPOLICY_HPP
+
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace st::renderer
+{
+
+	enum class PresentationProfile
+	{
+		// One frame in flight, presents as soon as possible, tearing allowed
+		eLowLatency,
+		// Three frames in flight, mailbox keeps the GPU busy without blocking on vsync
+		eThroughput,
+		// Vsynced and capped, the GPU idles between frames
+		ePowerSaving
+	};
+
+	// How frames are paced and presented. The fields can be tuned after make(), the renderer
+	// falls back to FIFO when none of the preferred present modes is available and clamps the
+	// image count to what the surface supports.
+	struct PresentationPolicy
+	{
+		PresentationProfile profile { PresentationProfile::eThroughput };
+		uint32_t framesInFlight { 3 };
+		// Requested swapchain images, at least minImageCount of the surface
+		uint32_t imageCount { 3 };
+		// In order of preference
+		std::vector<vk::PresentModeKHR> presentModes;
+		// Frames per second, 0 leaves the rate to the present mode
+		float frameRateCap { 0.0F };
+
+		static PresentationPolicy make(PresentationProfile profile);
+
+		vk::PresentModeKHR choosePresentMode(std::span<const vk::PresentModeKHR> availablePresentModes) const;
+		uint32_t chooseImageCount(const vk::SurfaceCapabilitiesKHR& capabilities) const;
+	};
+
+};
+
+#endif // RENDERER_PRESENTATIONPOLICY_HPP
@@ -0,0 +1,284 @@
+#ifndef RENDERER_RENDERGRAPH_HPP
+#define RENDERER_RENDERGRAPH_HPP
+
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+
+namespace st::renderer
+{
+
+	// How a pass uses an image, each maps to a pipeline stage, an access mask and a layout
+	enum class ResourceAccess
+	{
+		eColorAttachment,
+		eDepthAttachment,
+		// Depth read by a compute shader in eDepthStencilReadOnlyOptimal
+		eDepthSampled,
+		eFragmentSampled,
+		eComputeSampled,
+		eComputeStorage,
+		eTransferSource
+	};
+
+	struct RenderGraphImage
+	{
+		vk::Format format { vk::Format::eUndefined };
+		vk::Extent2D extent;
+		vk::ImageUsageFlags usage;
+		// Of the view, barriers on depth stencil formats cover both aspects
+		vk::ImageAspectFlags aspect { vk::ImageAspectFlagBits::eColor };
+
+		bool operator==(const RenderGraphImage& other) const = default;
+	};
+
+	struct RenderGraphStatistics
+	{
+		uint32_t passCount { 0 };
+		uint32_t culledPassCount { 0 };
+		uint32_t barrierCount { 0 };
+		// Memory backing the transient images, and what they would take without aliasing
+		vk::DeviceSize transientBytes { 0 };
+		vk::DeviceSize unaliasedBytes { 0 };
+	};
+
+	// Frame graph declared every frame. Passes state which images they read and write, compile()
+	// culls the passes nothing depends on, derives the barriers and layout transitions between the
+	// remaining ones and backs transient images with memory shared by images whose lifetimes do not
+	// overlap. Raster passes get their render pass and framebuffer from the graph, attachments
+	// nobody reads later are not stored and transient ones are never loaded.
+	//
+	// Physical transient images are kept while the frame declares the same set. Replaced images and
+	// framebuffers are destroyed once the last submitted frame completed.
+	class RenderGraph
+	{
+	public:
+		using Resource = uint32_t;
+		using Pass = uint32_t;
+		using ExecuteCallback = std::function<void(vk::CommandBuffer)>;
+
+		RenderGraph() = default;
+		~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		void init(vk::Device device, MemoryAllocator& allocator, uint32_t frameCount);
+		void shutdown();
+
+		// Destroys what was retired into this frame, its fence must have signaled
+		void beginFrame(uint32_t frameIndex);
+
+		// Drops the declarations of the previous frame, physical resources stay for the next compile.
+		// The declarations and the scratch memory of compile come from frameMemory until the next reset.
+		void reset(std::pmr::memory_resource* frameMemory = std::pmr::get_default_resource());
+
+		// Earlier work leaves the image in initialLayout at initialStages, later work finds it in
+		// finalLayout and starts at finalStages
+		Resource importImage(vk::Image image,
+							 vk::ImageView view,
+							 const RenderGraphImage& description,
+							 vk::ImageLayout initialLayout,
+							 vk::PipelineStageFlags initialStages,
+							 vk::ImageLayout finalLayout,
+							 vk::PipelineStageFlags finalStages);
+		// Contents do not outlive the frame
+		Resource createImage(const RenderGraphImage& description);
+
+		// Passes execute in the order they were added
+		Pass addPass(ExecuteCallback execute);
+		void read(Pass pass, Resource resource, ResourceAccess access);
+		void write(Pass pass, Resource resource, ResourceAccess access);
+		// Makes it a raster pass, the callback runs inside its render pass
+		void setColorAttachment(Pass pass, Resource resource, vk::AttachmentLoadOp loadOp, vk::ClearColorValue clearValue = {});
+		void setDepthAttachment(Pass pass, Resource resource, vk::AttachmentLoadOp loadOp, vk::ClearDepthStencilValue clearValue = {});
+		// Never culled, for passes whose results leave the graph by other means
+		void setSideEffect(Pass pass);
+		// The callback of a raster pass only executes secondary command buffers
+		void setSecondaryCommandBuffers(Pass pass);
+
+		// Replaced transient images are retired into frameIndex, the slot of the last submitted frame
+		void compile(uint32_t frameIndex);
+		void execute(vk::CommandBuffer commandBuffer) const;
+
+		// Call before imported views are destroyed, cached framebuffers may reference them
+		void invalidateFramebuffers(uint32_t frameIndex);
+
+		// Valid after compile, null for transient images no remaining pass uses
+		vk::ImageView getImageView(Resource resource) const;
+		// Valid after compile, for secondaries recorded inside a raster pass
+		vk::CommandBufferInheritanceInfo getInheritance(Pass pass) const;
+		RenderGraphStatistics getStatistics() const;
+
+	private:
+		struct Use
+		{
+			Resource resource;
+			ResourceAccess access;
+			bool write;
+		};
+
+		struct Attachment
+		{
+			Resource resource;
+			vk::AttachmentLoadOp loadOp;
+			vk::ClearValue clearValue;
+			vk::AttachmentStoreOp storeOp { vk::AttachmentStoreOp::eStore };
+		};
+
+		struct PassData
+		{
+			explicit PassData(std::pmr::memory_resource* memory):
+				uses(memory),
+				barriers(memory)
+			{
+			}
+
+			ExecuteCallback execute;
+			std::pmr::vector<Use> uses;
+			std::optional<Attachment> color;
+			std::optional<Attachment> depth;
+			bool sideEffect { false };
+			bool secondaryCommandBuffers { false };
+
+			// Filled by compile
+			bool culled { false };
+			vk::PipelineStageFlags srcStages;
+			vk::PipelineStageFlags dstStages;
+			std::pmr::vector<vk::ImageMemoryBarrier> barriers;
+			vk::RenderPass renderPass;
+			vk::Framebuffer framebuffer;
+			vk::Extent2D extent;
+		};
+
+		struct ResourceData
+		{
+			RenderGraphImage description;
+			bool imported { false };
+			vk::Image image;
+			vk::ImageView view;
+			vk::ImageLayout initialLayout { vk::ImageLayout::eUndefined };
+			vk::PipelineStageFlags initialStages;
+			vk::ImageLayout finalLayout { vk::ImageLayout::eUndefined };
+			vk::PipelineStageFlags finalStages;
+
+			// Over the passes left after culling
+			std::optional<uint32_t> firstPass;
+			uint32_t lastPass { 0 };
+		};
+
+		// Synchronization state while walking the passes
+		struct ResourceState
+		{
+			vk::ImageLayout layout { vk::ImageLayout::eUndefined };
+			vk::PipelineStageFlags writeStages;
+			vk::AccessFlags writeAccess;
+			vk::PipelineStageFlags readStages;
+			// Stages the last write was made visible to
+			vk::PipelineStageFlags visibleStages;
+		};
+
+		struct TransientImage
+		{
+			RenderGraphImage description;
+			// Images of a group have disjoint lifetimes, they share a slot when their memory types allow
+			uint32_t aliasGroup { 0 };
+			uint32_t slot { 0 };
+			vk::Image image;
+			vk::ImageView view;
+		};
+
+		// Memory shared by transient images with disjoint lifetimes
+		struct MemorySlot
+		{
+			MemoryAllocation memory;
+			// Every use of the slot since it was created, a frame waits for the previous one through them
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags writeAccess;
+		};
+
+		struct RenderPassKey
+		{
+			vk::Format colorFormat { vk::Format::eUndefined };
+			vk::AttachmentLoadOp colorLoadOp { vk::AttachmentLoadOp::eDontCare };
+			vk::AttachmentStoreOp colorStoreOp { vk::AttachmentStoreOp::eDontCare };
+			vk::Format depthFormat { vk::Format::eUndefined };
+			vk::AttachmentLoadOp depthLoadOp { vk::AttachmentLoadOp::eDontCare };
+			vk::AttachmentStoreOp depthStoreOp { vk::AttachmentStoreOp::eDontCare };
+
+			bool operator==(const RenderPassKey& other) const = default;
+		};
+
+		struct RenderPassKeyHash
+		{
+			size_t operator()(const RenderPassKey& key) const;
+		};
+
+		struct FramebufferKey
+		{
+			vk::RenderPass renderPass;
+			vk::ImageView colorView;
+			vk::ImageView depthView;
+			vk::Extent2D extent;
+
+			bool operator==(const FramebufferKey& other) const = default;
+		};
+
+		struct FramebufferKeyHash
+		{
+			size_t operator()(const FramebufferKey& key) const;
+		};
+
+		struct Retired
+		{
+			std::vector<TransientImage> images;
+			std::vector<MemoryAllocation> memory;
+			std::vector<vk::Framebuffer> framebuffers;
+		};
+
+		void cullPasses();
+		void computeLifetimes();
+		void createTransients(uint32_t frameIndex);
+		void retireTransients(uint32_t frameIndex);
+		void buildBarriers();
+		void createRenderPasses();
+
+		void addBarrier(PassData& pass, Resource resource, ResourceAccess access, bool write);
+		void destroy(Retired& retired);
+
+		vk::RenderPass getRenderPass(const RenderPassKey& key);
+		vk::Framebuffer getFramebuffer(const FramebufferKey& key);
+
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+		std::pmr::memory_resource* m_frameMemory { std::pmr::get_default_resource() };
+
+		std::vector<PassData> m_passes;
+		std::vector<ResourceData> m_resources;
+		std::vector<ResourceState> m_states;
+		// Transitions of imported images to their final layout
+		std::vector<vk::ImageMemoryBarrier> m_finalBarriers;
+		vk::PipelineStageFlags m_finalSrcStages;
+		vk::PipelineStageFlags m_finalDstStages;
+
+		// Index into m_transients for every resource, transient or not
+		std::vector<std::optional<uint32_t>> m_physicalImages;
+		std::vector<TransientImage> m_transients;
+		std::vector<MemorySlot> m_slots;
+
+		std::unordered_map<RenderPassKey, vk::RenderPass, RenderPassKeyHash> m_renderPasses;
+		std::unordered_map<FramebufferKey, vk::Framebuffer, FramebufferKeyHash> m_framebuffers;
+
+		std::vector<Retired> m_retired;
+
+		RenderGraphStatistics m_statistics;
+	};
+
+};
+
+#endif // RENDERER_RENDERGRAPH_HPP
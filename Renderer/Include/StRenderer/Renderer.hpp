@@ -9,7 +9,29 @@
 #include <vector>
 #include <optional>
 #include <array>
+#include <chrono>
 #include <ostream>
+#include <span>
+#include <string>
+
+#include "StCore/FrameArena.hpp"
+#include "StCore/JobSystem.hpp"
+#include "StRenderer/BindlessTextures.hpp"
+#include "StRenderer/DescriptorAllocator.hpp"
+#include "StRenderer/DeviceSelection.hpp"
+#include "StRenderer/DrawList.hpp"
+#include "StRenderer/FrameCapture.hpp"
+#include "StRenderer/GeometryHeap.hpp"
+#include "StRenderer/GpuCulling.hpp"
+#include "StRenderer/MemoryAllocator.hpp"
+#include "StRenderer/Mesh.hpp"
+#include "StRenderer/ParallelRecorder.hpp"
+#include "StRenderer/PipelineManager.hpp"
+#include "StRenderer/PresentationPolicy.hpp"
+#include "StRenderer/RenderGraph.hpp"
+#include "StRenderer/TransferContext.hpp"
+#include "StRenderer/UniformRing.hpp"
+#include "StShader/ShaderPermutation.hpp"
 
 enum class VulkanRendererValidationLayerLevel
 {
@@ -21,6 +43,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // Only set when a family without graphics support exists
+    std::optional<uint32_t> transferFamily;
 
     [[nodiscard]] bool isComplete() const;
 
@@ -38,6 +62,16 @@ struct SwapChainSupportDetails
 };
 
 
+// CPU side frame timing in milliseconds
+struct FrameTimings
+{
+    // Between the starts of the last two frames
+    float frameTime { 0.0F };
+    // Blocked on the fence of the frame slot, the GPU is the bottleneck when it dominates frameTime
+    float fenceWaitTime { 0.0F };
+    // Exponential moving average of frameTime
+    float averageFrameTime { 0.0F };
+};
 
 struct Texture;
 
@@ -46,15 +80,42 @@ class VulkanRenderer
 {
 
 public:
+    // Per frame resources are created for this many slots, PresentationPolicy::framesInFlight
+    // selects how many of them rotate
+    constexpr static uint32_t MAX_FRAMES_IN_FLIGHT{3};
+
     Renderer_API void initRenderer(vk::Instance& instance,
                                    vk::SurfaceKHR& surface,
-                                   VulkanRendererValidationLayerLevel debugLevel);
+                                   VulkanRendererValidationLayerLevel debugLevel,
+                                   const st::renderer::PresentationPolicy& presentationPolicy =
+                                       st::renderer::PresentationPolicy::make(st::renderer::PresentationProfile::eThroughput));
+
+    // Renders into offscreen images instead of a swapchain, any device type is accepted. The frame
+    // loop is unchanged, the UI rendering calls are still required and record an empty pass.
+    Renderer_API void initHeadless(vk::Instance& instance,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   VulkanRendererValidationLayerLevel debugLevel,
+                                   const st::renderer::PresentationPolicy& presentationPolicy =
+                                       st::renderer::PresentationPolicy::make(st::renderer::PresentationProfile::eThroughput));
+    Renderer_API bool isHeadless() const;
+
+    // Headless only, the next frame is written to path once the GPU finished it
+    Renderer_API void captureFrame(const std::string& path);
+    Renderer_API void waitForCaptures();
 
     Renderer_API void setupSwapchain(uint32_t width, uint32_t height);
 
 
     Renderer_API void resizeFramebuffer(uint32_t width, uint32_t height);
 
+    // Call between frames. Only the swapchain is recreated and only when the present mode or the
+    // image count changes, a new frames in flight count waits for the frames already submitted.
+    Renderer_API void setPresentationPolicy(const st::renderer::PresentationPolicy& policy);
+    Renderer_API const st::renderer::PresentationPolicy& getPresentationPolicy() const;
+    // Image count the swapchain was last created with, changes when a new policy recreates it
+    Renderer_API uint32_t getMinImageCount() const;
+
     Renderer_API vk::Instance getInstance() const;
     Renderer_API vk::PhysicalDevice getPhysicalDevice() const;
     Renderer_API vk::Device getLogicalDevice() const;
@@ -67,6 +128,39 @@ public:
     Renderer_API void endSingleTimeCommands(vk::CommandBuffer commandBuffer);
 
 
+    // Switches the scene to another shader permutation, the current one is drawn until it compiles
+    Renderer_API void setMeshPermutation(const st::renderer::MeshShaderPermutation& permutation);
+
+    // Geometry is uploaded through the transfer context, the mesh can be drawn in the same frame
+    // Identical geometry is stored once
+    Renderer_API st::renderer::MeshHandle createMesh(std::span<const st::renderer::Vertex> vertices, std::span<const uint32_t> indices);
+    Renderer_API void destroyMesh(st::renderer::MeshHandle mesh);
+    // Queues one instanced draw for the frame finished by the next endFrame, instances are copied
+    Renderer_API void drawMeshInstanced(st::renderer::MeshHandle mesh, std::span<const st::renderer::InstanceData> instances);
+    // Single object, its transform is premultiplied on the CPU and pushed as a constant
+    Renderer_API void drawMesh(st::renderer::MeshHandle mesh, const st::math::Matrix4x4& model, uint32_t materialIndex = 0);
+
+    // RGBA8 sRGB, the handle goes into InstanceData::m_materialIndex. Without bindless support
+    // every handle refers to the default texture.
+    Renderer_API st::renderer::TextureHandle createTexture(uint32_t width, uint32_t height, std::span<const std::byte> rgbaPixels);
+    Renderer_API st::renderer::TextureHandle createTexture(const std::string& path);
+    Renderer_API bool isBindlessEnabled() const;
+
+    // Optional features enabled on the device, the renderer takes the fast path for each of them
+    Renderer_API const st::renderer::DeviceFeatures& getDeviceFeatures() const;
+
+    Renderer_API st::renderer::MemoryStatistics getMemoryStatistics() const;
+    // Draws and binds recorded for the last frame
+    Renderer_API st::renderer::DrawStatistics getDrawStatistics() const;
+    Renderer_API FrameTimings getFrameTimings() const;
+    // Passes, barriers and transient memory of the last compiled frame graph
+    Renderer_API st::renderer::RenderGraphStatistics getRenderGraphStatistics() const;
+    // Transient CPU memory of the last submitted frame, overflows are allocations that hit the heap
+    Renderer_API st::core::FrameArenaStatistics getFrameArenaStatistics() const;
+
+    // Replaces the built-in camera, takes effect at the next startFrame
+    Renderer_API void setViewMatrix(const st::math::Matrix4x4& view);
+
     Renderer_API void startFrame();
     Renderer_API vk::CommandBuffer beginUiRendering();
     Renderer_API void endUiRendering(vk::CommandBuffer& uiCommandBuffer );
@@ -74,6 +168,8 @@ public:
 
 
 
+    Renderer_API ~VulkanRenderer();
+
 private:
     void initVulkan();
     void cleanup();
@@ -85,9 +181,27 @@ private:
 
     void createLogicalDevice();
 
-    void createSwapChain();
+    // Everything sized by the swapchain extent
+    struct RetiredSwapChain
+    {
+        vk::SwapchainKHR swapChain;
+        std::vector<vk::Framebuffer> framebuffers;
+        std::vector<vk::ImageView> imageViews;
+        std::vector<vk::Image> offscreenImages;
+        std::vector<st::renderer::MemoryAllocation> offscreenImageMemory;
+    };
+
+    void createSwapChain(vk::SwapchainKHR oldSwapChain = nullptr);
+    void createOffscreenTargets();
+    vk::ImageLayout getFinalColorLayout() const;
+    std::vector<const char*> getRequiredDeviceExtensions() const;
+    void recreateSwapChain();
+    RetiredSwapChain retireSwapChain();
+    void destroySwapChain(RetiredSwapChain& retired);
+    void destroyRetiredSwapChains(uint32_t frameIndex);
+    // The device must be idle
+    void cleanupSwapChain();
     vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats) const;
-    vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) const;
     vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const;
 	void createSwapchainImageViews();
 
@@ -96,6 +210,8 @@ private:
     vk::Format findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features) const;
 
     void createGraphicsPipeline();
+    st::renderer::GraphicsPipelineDescription meshPipelineDescription(const st::renderer::MeshShaderPermutation& permutation) const;
+    st::renderer::GraphicsPipelineDescription objectPipelineDescription(const st::renderer::MeshShaderPermutation& permutation) const;
     void createTextureSampler();
     void createUniformBuffers();
     void createDescriptorPool();
@@ -108,23 +224,27 @@ private:
     void createCommandPool();
 
     void createFramebuffer();
-    void createDepthResources();
 
-    void createVertexBuffer();
-    void createIndexBuffer();
+    void createDescriptorSets();
     void createCommandBuffers();
     void createSyncObjects();
 
     void updateUniformBuffer(uint32_t currentImage);
-    void recordCommandBuffer(vk::CommandBuffer& commandBuffer, uint32_t imageIndex);
+    void updateInstanceBuffer(uint32_t currentImage);
+    // Declares the passes of the frame, compiled before the culling inputs are prepared since the
+    // depth pyramid follows the depth attachment the graph allocates
+    void buildRenderGraph(bool gpuCulling);
+    void recordCommandBuffer(vk::CommandBuffer& commandBuffer);
+    void recordScenePass(vk::CommandBuffer commandBuffer, bool gpuCulling);
+    // State is not inherited by secondaries, every command buffer drawing the scene binds it again
+    void bindSceneState(vk::CommandBuffer commandBuffer, st::renderer::CommandStateCache& stateCache);
+    void buildDrawList(bool gpuCulling, st::renderer::PipelineHandle objectPipeline);
 
     void createBuffer(vk::DeviceSize size,
                       vk::BufferUsageFlags usage,
                       vk::MemoryPropertyFlags properties,
                       vk::Buffer& buffer,
-                      vk::DeviceMemory& bufferMemory) const;
-                      
-    void copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size);
+                      st::renderer::MemoryAllocation& bufferMemory);
 
     void createImage(uint32_t width,
 				 uint32_t height,
@@ -133,21 +253,16 @@ private:
 				 vk::ImageUsageFlags usage,
 				 vk::MemoryPropertyFlags properties,
 				 vk::Image& image,
-				 vk::DeviceMemory& imageMemory) const;
+				 st::renderer::MemoryAllocation& imageMemory);
 
     vk::ImageView createImageView(vk::Image image,
                                   vk::Format format,
                                   vk::ImageAspectFlags aspectFlags) const;
 
-    void createTextureImage(Texture& texture, vk::Image& textureImage, vk::DeviceMemory& textureImageMemory);
+    void createTextureImage(Texture& texture, vk::Image& textureImage, st::renderer::MemoryAllocation& textureImageMemory);
     void createTextureImageView(vk::Image& textureImage, vk::ImageView& textureImageView);
-    void transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
 
 
-    uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
-
-
-    void copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height);
 
     VulkanRendererValidationLayerLevel m_enableValidationLayers;
 
@@ -155,10 +270,14 @@ private:
     vk::DebugUtilsMessengerEXT m_debugMessenger;
     vk::SurfaceKHR  m_surface;
     vk::PhysicalDevice m_physicalDevice;
+    st::renderer::DeviceFeatures m_deviceFeatures;
     
     vk::Device m_device;
+    st::renderer::MemoryAllocator m_memoryAllocator;
+    st::renderer::TransferContext m_transferContext;
     vk::Queue m_graphicsQueue;
 	vk::Queue m_presentQueue;
+    vk::Queue m_transferQueue;
 
     vk::SwapchainKHR m_swapChain;
     std::vector<vk::Image> m_swapChainImages;
@@ -168,61 +287,114 @@ private:
     uint32_t m_swapchainWidth;
     uint32_t m_swapchainHeight;
 
-    vk::RenderPass m_renderPass;
+    st::renderer::PresentationPolicy m_presentationPolicy;
+    uint32_t m_framesInFlight { 1 };
+    vk::PresentModeKHR m_presentMode { vk::PresentModeKHR::eFifo };
+    // As requested from the surface, the implementation may create more images
+    uint32_t m_requestedImageCount { 0 };
 
-    vk::Pipeline m_graphicsPipeline;
+    // Pipelines are created against it, the scene passes come from the render graph
+    vk::RenderPass m_renderPass;
+    vk::Format m_depthFormat { vk::Format::eUndefined };
+    // Transient CPU memory of each frame slot, reset once its fence signaled. Declared before the
+    // render graph, which keeps the containers of the last frame until its next reset.
+    std::array<st::core::FrameArena, MAX_FRAMES_IN_FLIGHT> m_frameArenas;
+    st::renderer::RenderGraph m_renderGraph;
+
+    // Shared by secondary recording, pipeline compiles and captures, which all finish their jobs
+    // before it is destroyed. Queue submissions stay on the thread that records the frame.
+    st::core::JobSystem m_jobSystem;
+
+    st::renderer::PipelineManager m_pipelineManager;
+    st::renderer::PipelineHandle m_graphicsPipeline;
+    st::renderer::PipelineHandle m_objectPipeline { 0 };
+    st::renderer::PipelineHandle m_defaultObjectPipeline { 0 };
     vk::PipelineLayout m_pipelineLayout;
-    vk::PipelineCache m_pipelineCache;
-    std::vector<vk::DynamicState> m_dynamicStateEnables;
-    vk::PipelineDynamicStateCreateInfo m_pipelineDynamicStateCreateInfo;
 
     //GraphicsPipeline
     vk::Sampler m_textureSampler;
-    std::vector<vk::Buffer> m_uniformBuffers;
-	std::vector<vk::DeviceMemory> m_uniformBuffersMemory;
-    vk::DescriptorPool m_primitiveDescriptorPool;
+    st::renderer::GpuCulling m_gpuCulling;
+    st::renderer::CullView m_cullView;
+
+    st::renderer::UniformRing m_uniformRing;
+    uint32_t m_sceneUniformOffset { 0 };
+    st::renderer::DescriptorAllocator m_descriptorAllocator;
+    st::renderer::DescriptorCache m_descriptorCache;
     vk::DescriptorSetLayout m_descriptorSetLayout;
-    std::vector<vk::DescriptorSet> m_descriptorSets;
+    vk::DescriptorSet m_sceneDescriptorSet;
 
     vk::Image m_textureImage;
-    vk::DeviceMemory textureImageMemory;
+    st::renderer::MemoryAllocation textureImageMemory;
     vk::ImageView m_textureImageView;
 
+    st::renderer::BindlessTextures m_bindlessTextures;
+    bool m_bindlessSupported { false };
+    std::vector<st::renderer::GpuTexture> m_textures;
+
 
 
     vk::CommandPool m_commandPool;
+    // Secondaries of the scene pass, recorded by worker threads from pools of their own
+    st::renderer::ParallelRecorder m_parallelRecorder;
+    st::renderer::RenderGraph::Pass m_scenePass { 0 };
 
-    std::vector<vk::Framebuffer> m_swapchainFramebuffers;
     std::vector<vk::Framebuffer> m_uiSwapchainFramebuffers;
 
-    vk::Image m_depthImage; 
-    vk::DeviceMemory m_depthImageMemory;
+    // Transient image of the render graph, the depth pyramid is rebuilt when it changes
     vk::ImageView m_depthImageView;
 
     constexpr static std::array m_deviceExtensions { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-    constexpr static uint32_t MAX_FRAMES_IN_FLIGHT{2};
+    constexpr static uint32_t MAX_UI_DESCRIPTOR_SETS{256};
 
+    // Reset once the fence of their frame signaled
+    std::array<st::renderer::DescriptorAllocator, MAX_FRAMES_IN_FLIGHT> m_frameDescriptorAllocators;
 
-    vk::Buffer m_planeVertexBuffer;
-	vk::DeviceMemory m_planeVertexBufferMemory;
-	vk::Buffer m_planeIndexBuffer;
-	vk::DeviceMemory m_planeIndexBufferMemory;
+
+    st::renderer::GeometryHeap m_geometryHeap;
+    std::vector<st::renderer::GpuMesh> m_meshes;
+    std::vector<st::renderer::MeshDraw> m_meshDraws;
+    std::vector<st::renderer::InstanceData> m_frameInstances;
+
+    std::vector<st::renderer::ObjectDraw> m_objectDraws;
+    std::vector<st::math::Matrix4x4> m_objectModels;
+    // Premultiplied with m_viewProjection at the end of the frame
+    std::vector<st::math::Matrix4x4> m_objectTransforms;
+    st::math::Matrix4x4 m_viewProjection;
+    // Set by the application, the built-in camera is used until then
+    std::optional<st::math::Matrix4x4> m_viewMatrix;
+
+    // Sorted by render state each frame, recording skips binds of state that is already bound
+    st::renderer::DrawList m_drawList;
+    st::renderer::DrawStatistics m_drawStatistics;
+
+    std::vector<vk::Buffer> m_instanceBuffers;
+	std::vector<st::renderer::MemoryAllocation> m_instanceBuffersMemory;
+    std::vector<vk::DeviceSize> m_instanceBufferCapacity;
 
     std::vector<vk::CommandBuffer> m_commandBuffers;
     std::vector<vk::CommandBuffer> m_uiCommandBuffers;
 
 
     std::vector<vk::Semaphore> m_imageAvailableSemaphores;
-    std::vector<vk::Semaphore> m_uiAvailableSemaphores;
     std::vector<vk::Semaphore> m_renderFinishedSemaphores;
     std::vector<vk::Fence> m_inFlightFences;
 
     uint32_t currentFrame = 0;
+    // Slot whose fence covers every submission so far, retired resources wait for it
+    uint32_t m_lastSubmittedFrame = 0;
+    std::array<std::vector<RetiredSwapChain>, MAX_FRAMES_IN_FLIGHT> m_retiredSwapChains;
     vk::Result currentFrameResult;
     uint32_t currentImageIndex = 0;
 
 
+    FrameTimings m_frameTimings;
+    std::chrono::steady_clock::time_point m_frameStart;
+
     bool m_framebufferResized = false;
+    // The surface had no area at the last recreation, the previous swapchain is kept meanwhile
+    bool m_swapChainDeferred = false;
+    // Nothing was acquired, the frame is recorded but never submitted
+    bool m_frameSkipped = false;
 
 
 
@@ -230,6 +402,9 @@ private:
     vk::DescriptorPool m_uiDescriptorPool;
     vk::RenderPass m_uiRenderPass;
     std::vector<vk::Image> m_uiSwapchainImages;
+    // Headless only, backs m_swapChainImages
+    std::vector<st::renderer::MemoryAllocation> m_offscreenImageMemory;
+    st::renderer::FrameCapture m_frameCapture;
     std::vector<vk::ImageView> m_uiSwapchainImageViews;
 
 
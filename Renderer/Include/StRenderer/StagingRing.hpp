@@ -0,0 +1,66 @@
+#ifndef RENDERER_STAGINGRING_HPP
+#define RENDERER_STAGINGRING_HPP
+
+#include <deque>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+
+namespace st::renderer
+{
+
+	struct StagingRegion
+	{
+		vk::Buffer buffer;
+		vk::DeviceSize offset { 0 };
+		vk::DeviceSize size { 0 };
+		std::byte* mappedData { nullptr };
+	};
+
+
+	// Persistently mapped upload buffer used as a ring. Every region is tagged with the submission
+	// that reads it and becomes reusable once that submission is retired.
+	class StagingRing
+	{
+	public:
+		StagingRing() = default;
+		~StagingRing();
+
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		void init(vk::Device device, MemoryAllocator& allocator, vk::DeviceSize size);
+		void shutdown();
+
+		// Empty when the ring has no contiguous space left until older submissions retire
+		std::optional<StagingRegion> allocate(vk::DeviceSize size, vk::DeviceSize alignment, uint64_t submission);
+		// Release every region of the submissions up to and including the given one
+		void retire(uint64_t completedSubmission);
+
+		vk::Buffer getBuffer() const;
+		vk::DeviceSize getSize() const;
+		vk::DeviceSize getUsedSize() const;
+
+	private:
+		struct Region
+		{
+			uint64_t submission;
+			vk::DeviceSize begin;
+			vk::DeviceSize end;
+		};
+
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+
+		vk::Buffer m_buffer;
+		MemoryAllocation m_memory;
+		vk::DeviceSize m_size { 0 };
+		vk::DeviceSize m_head { 0 };
+
+		std::deque<Region> m_regions;
+	};
+
+};
+
+#endif // RENDERER_STAGINGRING_HPP
@@ -0,0 +1,87 @@
+#ifndef RENDERER_TLSFALLOCATOR_HPP
+#define RENDERER_TLSFALLOCATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace st::renderer
+{
+
+	// Two-level segregated fit allocator over an abstract [0, size) range. It only hands out
+	// offsets, the owner decides what the range is (a VkDeviceMemory block, a buffer, ...).
+	// Allocation and free are O(1).
+	class TlsfAllocator
+	{
+	public:
+		static constexpr uint32_t invalidNode = std::numeric_limits<uint32_t>::max();
+
+		struct Allocation
+		{
+			uint64_t offset { 0 };
+			uint32_t node { invalidNode };
+
+			bool isValid() const
+			{
+				return node != invalidNode;
+			}
+		};
+
+		explicit TlsfAllocator(uint64_t size = 0);
+
+		void reset(uint64_t size);
+
+		Allocation allocate(uint64_t size, uint64_t alignment = 1);
+		void free(Allocation allocation);
+
+		uint64_t getAllocationSize(Allocation allocation) const;
+
+		uint64_t getSize() const;
+		uint64_t getUsedSize() const;
+		uint32_t getAllocationCount() const;
+		bool isEmpty() const;
+
+	private:
+		static constexpr uint32_t secondLevelBits = 4;
+		static constexpr uint32_t secondLevelCount = 1U << secondLevelBits;
+		static constexpr uint32_t firstLevelCount = 64;
+
+		struct Node
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t prevPhysical;
+			uint32_t nextPhysical;
+			uint32_t prevFree;
+			uint32_t nextFree;
+			bool used;
+		};
+
+		static void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+		static uint64_t roundUpToBucket(uint64_t size);
+
+		uint32_t findFreeNode(uint64_t size) const;
+		void insertFree(uint32_t node);
+		void removeFree(uint32_t node);
+
+		uint32_t createNode(uint64_t offset, uint64_t size);
+		void releaseNode(uint32_t node);
+
+		uint32_t splitFront(uint32_t node, uint64_t frontSize);
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_unusedNodes;
+
+		uint64_t m_firstLevelBitmap;
+		std::array<uint32_t, firstLevelCount> m_secondLevelBitmap;
+		std::array<uint32_t, firstLevelCount * secondLevelCount> m_freeHeads;
+
+		uint64_t m_size;
+		uint64_t m_usedSize;
+		uint32_t m_allocationCount;
+	};
+
+};
+
+#endif // RENDERER_TLSFALLOCATOR_HPP
@@ -0,0 +1,116 @@
+#ifndef RENDERER_TRANSFERCONTEXT_HPP
+#define RENDERER_TRANSFERCONTEXT_HPP
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+#include "StRenderer/StagingRing.hpp"
+
+namespace st::renderer
+{
+
+	// Records uploads into one command buffer until flush() submits them as a batch. Every batch
+	// signals its submission id on a timeline semaphore, staging memory from the StagingRing is
+	// reclaimed once the value is reached, the queue is never idled.
+	//
+	// When the transfer queue belongs to another family than the graphics queue, uploaded resources
+	// are released to the graphics family. The graphics side records the matching acquire barriers
+	// with recordAcquireBarriers() and waits for getLastSubmitted() on the timeline semaphore at
+	// consumerStages. Not thread safe, uploads are issued from the render thread.
+	class TransferContext
+	{
+	public:
+		static constexpr vk::DeviceSize defaultStagingSize = 32ULL * 1024 * 1024;
+
+		static constexpr vk::PipelineStageFlags consumerStages { vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput |
+																 vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader |
+																 vk::PipelineStageFlagBits::eComputeShader };
+
+		TransferContext() = default;
+		~TransferContext();
+
+		TransferContext(const TransferContext&) = delete;
+		TransferContext& operator=(const TransferContext&) = delete;
+
+		void init(vk::PhysicalDevice physicalDevice,
+				  vk::Device device,
+				  vk::Queue queue,
+				  uint32_t queueFamilyIndex,
+				  uint32_t graphicsQueueFamilyIndex,
+				  MemoryAllocator& allocator,
+				  vk::DeviceSize stagingSize = defaultStagingSize);
+		void shutdown();
+
+		void uploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, std::span<const std::byte> data);
+
+		// Whole mip 0 / layer 0 upload, the previous content of the image is discarded
+		void uploadImage(vk::Image dstImage,
+						 vk::Extent3D extent,
+						 std::span<const std::byte> data,
+						 vk::ImageLayout finalLayout,
+						 vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor);
+
+		// Submit everything recorded so far, returns the id of the last submitted batch
+		uint64_t flush();
+
+		// Acquire ownership of everything released by the flushed batches, graphics queue only
+		void recordAcquireBarriers(vk::CommandBuffer commandBuffer);
+
+		// Retire batches the timeline has passed, never blocks
+		void collect();
+		bool isComplete(uint64_t submission);
+		void wait(uint64_t submission);
+		void waitIdle();
+
+		vk::Semaphore getTimelineSemaphore() const;
+		uint64_t getLastSubmitted() const;
+		bool hasOwnershipTransfer() const;
+
+	private:
+		struct Batch
+		{
+			vk::CommandBuffer commandBuffer;
+			uint64_t submission { 0 };
+
+			// Uploads larger than the ring get their own staging buffer, released with the batch
+			std::vector<std::pair<vk::Buffer, MemoryAllocation>> oversizedStaging;
+
+			std::vector<vk::BufferMemoryBarrier> bufferAcquires;
+			std::vector<vk::ImageMemoryBarrier> imageAcquires;
+		};
+
+		vk::CommandBuffer recordingCommandBuffer();
+		StagingRegion acquireStaging(vk::DeviceSize size, std::span<const std::byte> data);
+		void retire(Batch& batch);
+
+		vk::Device m_device;
+		vk::Queue m_queue;
+		uint32_t m_queueFamilyIndex { 0 };
+		uint32_t m_graphicsQueueFamilyIndex { 0 };
+		MemoryAllocator* m_allocator { nullptr };
+		vk::DeviceSize m_copyAlignment { 16 };
+
+		vk::CommandPool m_commandPool;
+		vk::Semaphore m_timeline;
+		StagingRing m_stagingRing;
+
+		std::optional<Batch> m_recording;
+		std::deque<Batch> m_inFlight;
+		std::vector<Batch> m_freeBatches;
+
+		std::vector<vk::BufferMemoryBarrier> m_pendingBufferAcquires;
+		std::vector<vk::ImageMemoryBarrier> m_pendingImageAcquires;
+
+		uint64_t m_nextSubmission { 1 };
+		uint64_t m_lastSubmitted { 0 };
+		uint64_t m_lastCompleted { 0 };
+	};
+
+};
+
+#endif // RENDERER_TRANSFERCONTEXT_HPP
@@ -0,0 +1,67 @@
+#ifndef RENDERER_UNIFORMRING_HPP
+#define RENDERER_UNIFORMRING_HPP
+
+#include <cstring>
+#include <vulkan/vulkan.hpp>
+
+#include "StRenderer/MemoryAllocator.hpp"
+
+namespace st::renderer
+{
+
+	// One persistently mapped uniform buffer split into a region per frame in flight. Per-draw data
+	// is appended linearly and bound through a dynamic uniform buffer descriptor with the offset
+	// returned by push(), so neither map calls nor extra descriptor sets are needed per draw.
+	class UniformRing
+	{
+	public:
+		static constexpr vk::DeviceSize defaultFrameSize = 1024ULL * 1024;
+
+		UniformRing() = default;
+		~UniformRing();
+
+		UniformRing(const UniformRing&) = delete;
+		UniformRing& operator=(const UniformRing&) = delete;
+
+		void init(vk::PhysicalDevice physicalDevice,
+				  vk::Device device,
+				  MemoryAllocator& allocator,
+				  uint32_t frameCount,
+				  vk::DeviceSize frameSize = defaultFrameSize);
+		void shutdown();
+
+		// Start writing into the region of the frame, the GPU must be done with its previous use
+		void beginFrame(uint32_t frameIndex);
+
+		// Returns the dynamic offset of the written data
+		uint32_t push(const void* data, vk::DeviceSize size);
+
+		template<typename T>
+		uint32_t push(const T& data)
+		{
+			return push(&data, sizeof(T));
+		}
+
+		// Single flush of everything pushed this frame, no-op on coherent memory
+		void flush();
+
+		vk::Buffer getBuffer() const;
+		vk::DeviceSize getAlignment() const;
+
+	private:
+		vk::Device m_device;
+		MemoryAllocator* m_allocator { nullptr };
+
+		vk::Buffer m_buffer;
+		MemoryAllocation m_memory;
+
+		vk::DeviceSize m_alignment { 256 };
+		vk::DeviceSize m_frameSize { 0 };
+		vk::DeviceSize m_frameBegin { 0 };
+		vk::DeviceSize m_head { 0 };
+		vk::DeviceSize m_flushedHead { 0 };
+	};
+
+};
+
+#endif // RENDERER_UNIFORMRING_HPP
@@ -0,0 +1,116 @@
+#ifndef RENDERER_SHADERS_SHADERPERMUTATION_HPP
+#define RENDERER_SHADERS_SHADERPERMUTATION_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace st::renderer
+{
+	// Value of one `layout(constant_id = N)` constant, bools are 32 bit in SPIR-V
+	struct SpecializationConstant
+	{
+		uint32_t constantId;
+		uint32_t value;
+
+		bool operator==(const SpecializationConstant&) const = default;
+	};
+
+	struct PermutationKey
+	{
+		uint32_t constantId;
+		std::string_view name;
+		bool defaultValue;
+	};
+
+
+	// Keys of VertexShader.vert / FragShader.frag, constant ids must match the GLSL declarations
+	struct MeshPermutationKeys
+	{
+		enum Feature : uint32_t
+		{
+			eTexture,
+			eVertexColor,
+			eNormal,
+			eAlphaTest,
+			eCount
+		};
+
+		static constexpr std::array<PermutationKey, eCount> keys {{
+			{ 0, "USE_TEXTURE",      true  },
+			{ 1, "USE_VERTEX_COLOR", false },
+			{ 2, "USE_NORMAL",       false },
+			{ 3, "ALPHA_TEST",       false }
+		}};
+	};
+
+
+	// Set of feature switches for one shader family. The driver folds the branches of disabled
+	// features away when the pipeline is created, so one SPIR-V module serves every permutation.
+	template<typename Keys>
+	class ShaderPermutation
+	{
+	public:
+		using Feature = typename Keys::Feature;
+		static constexpr size_t keyCount = Keys::keys.size();
+
+		static_assert(keyCount <= 32, "permutation mask holds at most 32 keys");
+
+		constexpr ShaderPermutation() noexcept:
+			m_mask(defaultMask())
+		{
+		}
+
+		constexpr ShaderPermutation& set(Feature feature, bool enabled) noexcept
+		{
+			const uint32_t bit = 1U << static_cast<uint32_t>(feature);
+			m_mask = enabled ? (m_mask | bit) : (m_mask & ~bit);
+			return *this;
+		}
+
+		constexpr bool isEnabled(Feature feature) const noexcept
+		{
+			return (m_mask >> static_cast<uint32_t>(feature)) & 1U;
+		}
+
+		constexpr uint32_t mask() const noexcept
+		{
+			return m_mask;
+		}
+
+		std::vector<SpecializationConstant> specializationConstants() const
+		{
+			std::vector<SpecializationConstant> constants;
+			constants.reserve(keyCount);
+
+			for (size_t i = 0; i < keyCount; ++i)
+			{
+				constants.push_back({ Keys::keys[i].constantId, (m_mask >> i) & 1U });
+			}
+
+			return constants;
+		}
+
+		constexpr bool operator==(const ShaderPermutation&) const = default;
+
+	private:
+		static constexpr uint32_t defaultMask() noexcept
+		{
+			uint32_t mask = 0;
+			for (size_t i = 0; i < keyCount; ++i)
+			{
+				mask |= Keys::keys[i].defaultValue ? (1U << i) : 0U;
+			}
+			return mask;
+		}
+
+		uint32_t m_mask;
+	};
+
+	using MeshShaderPermutation = ShaderPermutation<MeshPermutationKeys>;
+
+};
+
+#endif // RENDERER_SHADERS_SHADERPERMUTATION_HPP
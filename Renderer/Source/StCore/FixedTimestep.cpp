@@ -0,0 +1,44 @@
+#include "FixedTimestep.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace st::core
+{
+	FixedTimestep::FixedTimestep(double tickSeconds, uint32_t maxTicksPerFrame):
+		m_tickSeconds(tickSeconds),
+		m_maxTicksPerFrame(std::max(maxTicksPerFrame, 1U))
+	{
+	}
+
+	uint32_t FixedTimestep::advance(double elapsedSeconds)
+	{
+		m_accumulator += std::max(elapsedSeconds, 0.0);
+
+		uint32_t ticks = 0;
+		while (m_accumulator >= m_tickSeconds && ticks < m_maxTicksPerFrame)
+		{
+			m_accumulator -= m_tickSeconds;
+			++ticks;
+		}
+
+		// Behind by more than the cap, keep only the partial tick
+		if (m_accumulator >= m_tickSeconds)
+		{
+			m_accumulator = std::fmod(m_accumulator, m_tickSeconds);
+		}
+
+		return ticks;
+	}
+
+	float FixedTimestep::getAlpha() const
+	{
+		return static_cast<float>(m_accumulator / m_tickSeconds);
+	}
+
+	double FixedTimestep::getTickSeconds() const
+	{
+		return m_tickSeconds;
+	}
+
+}
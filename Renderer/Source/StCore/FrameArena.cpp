@@ -0,0 +1,118 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace st::core
+{
+	namespace
+	{
+		size_t alignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	FrameArena::FrameArena():
+		FrameArena(defaultCapacity)
+	{
+	}
+
+	FrameArena::FrameArena(size_t capacity, std::pmr::memory_resource* upstream):
+		m_upstream(upstream),
+		m_capacity(capacity)
+	{
+		if (m_capacity != 0)
+		{
+			m_block = static_cast<std::byte*>(m_upstream->allocate(m_capacity, alignof(std::max_align_t)));
+		}
+		m_statistics.capacity = m_capacity;
+	}
+
+	FrameArena::~FrameArena()
+	{
+		releaseOverflows();
+		if (m_block != nullptr)
+		{
+			m_upstream->deallocate(m_block, m_capacity, alignof(std::max_align_t));
+		}
+	}
+
+	void FrameArena::reset()
+	{
+		const size_t peak = m_offset + m_overflowBytes;
+		releaseOverflows();
+
+		// Room for the whole frame in the block, with headroom for one that uses a little more
+		if (peak > m_capacity)
+		{
+			const size_t capacity = alignUp(std::max(peak + peak / 2, 2 * m_capacity), alignof(std::max_align_t));
+			if (m_block != nullptr)
+			{
+				m_upstream->deallocate(m_block, m_capacity, alignof(std::max_align_t));
+			}
+			m_block = static_cast<std::byte*>(m_upstream->allocate(capacity, alignof(std::max_align_t)));
+			m_capacity = capacity;
+		}
+
+		m_offset = 0;
+		m_statistics = FrameArenaStatistics {};
+		m_statistics.capacity = m_capacity;
+	}
+
+	FrameArenaStatistics FrameArena::getStatistics() const
+	{
+		FrameArenaStatistics statistics = m_statistics;
+		statistics.bytesUsed = m_offset + m_overflowBytes;
+		return statistics;
+	}
+
+	void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+	{
+		++m_statistics.allocationCount;
+
+		// Aligned on the address, the block itself is only aligned to max_align_t
+		if (m_block != nullptr)
+		{
+			const uintptr_t base = reinterpret_cast<uintptr_t>(m_block);
+			const size_t offset = alignUp(base + m_offset, alignment) - base;
+			if (offset + bytes <= m_capacity)
+			{
+				m_offset = offset + bytes;
+				return m_block + offset;
+			}
+		}
+
+		const size_t overflowAlignment = std::max(alignment, alignof(Overflow));
+		const size_t headerSize = alignUp(sizeof(Overflow), overflowAlignment);
+		void* memory = m_upstream->allocate(headerSize + bytes, overflowAlignment);
+
+		m_overflows = ::new (memory) Overflow { m_overflows, headerSize + bytes, overflowAlignment };
+		m_overflowBytes += bytes;
+		++m_statistics.overflowCount;
+
+		return static_cast<std::byte*>(memory) + headerSize;
+	}
+
+	void FrameArena::do_deallocate(void* /*pointer*/, size_t /*bytes*/, size_t /*alignment*/)
+	{
+		// Released all at once by reset
+	}
+
+	bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+	{
+		return this == &other;
+	}
+
+	void FrameArena::releaseOverflows()
+	{
+		while (m_overflows != nullptr)
+		{
+			Overflow* const overflow = m_overflows;
+			m_overflows = overflow->next;
+			m_upstream->deallocate(overflow, overflow->size, overflow->alignment);
+		}
+		m_overflowBytes = 0;
+	}
+
+}
@@ -0,0 +1,373 @@
+#include "JobSystem.hpp"
+
+namespace st::core
+{
+	namespace
+	{
+		thread_local const JobSystem* t_jobSystem = nullptr;
+		thread_local uint32_t t_workerIndex = 0;
+	}
+
+	JobSystem::JobSystem(uint32_t workerCount):
+		m_mainThread(std::this_thread::get_id())
+	{
+		workerCount = std::max(workerCount, 1U);
+
+		m_deques.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			m_deques.push_back(std::make_unique<WorkStealingDeque>());
+		}
+
+		t_jobSystem = this;
+		t_workerIndex = 0;
+
+		m_threads.reserve(workerCount - 1);
+		for (uint32_t i = 1; i < workerCount; ++i)
+		{
+			m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::scoped_lock lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_jobAvailable.notify_all();
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+
+		if (t_jobSystem == this)
+		{
+			t_jobSystem = nullptr;
+		}
+	}
+
+	void JobSystem::schedule(const Job& job)
+	{
+		if (job.counter)
+		{
+			job.counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		enqueue(job);
+	}
+
+	void JobSystem::scheduleAfter(JobCounter& dependency, const Job& job)
+	{
+		if (job.counter)
+		{
+			job.counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		{
+			std::scoped_lock lock(dependency.m_mutex);
+			if (dependency.m_value.load(std::memory_order_acquire) != 0)
+			{
+				dependency.m_continuations.push_back(job);
+				return;
+			}
+		}
+
+		enqueue(job);
+	}
+
+	void JobSystem::scheduleOnMainThread(const Job& job)
+	{
+		if (job.counter)
+		{
+			job.counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		{
+			std::scoped_lock lock(m_mainThreadMutex);
+			m_mainThreadJobs.push_back(job);
+		}
+
+		m_queuedMainThreadJobs.fetch_add(1, std::memory_order_seq_cst);
+		wakeAll();
+	}
+
+	void JobSystem::scheduleBackground(const Job& job)
+	{
+		if (job.counter)
+		{
+			job.counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (m_threads.empty())
+		{
+			run(job);
+			return;
+		}
+
+		{
+			std::scoped_lock lock(m_backgroundMutex);
+			m_backgroundJobs.push_back(job);
+		}
+
+		m_queuedBackgroundJobs.fetch_add(1, std::memory_order_seq_cst);
+		wakeAll();
+	}
+
+	void JobSystem::wait(JobCounter& counter)
+	{
+		const std::optional<uint32_t> worker = currentWorker();
+		const bool mainThread = isMainThread();
+
+		while (!counter.isDone())
+		{
+			std::optional<Job> job = mainThread ? popMainThreadJob() : std::nullopt;
+			if (!job)
+			{
+				job = findJob(worker);
+			}
+
+			if (job)
+			{
+				run(*job);
+				continue;
+			}
+
+			// The remaining jobs run elsewhere, or in the background for a long time
+			std::unique_lock lock(m_sleepMutex);
+			m_sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+			m_jobAvailable.wait(lock, [&] {
+				return counter.m_value.load(std::memory_order_seq_cst) == 0 || m_queuedJobs.load(std::memory_order_seq_cst) > 0 ||
+					   (mainThread && m_queuedMainThreadJobs.load(std::memory_order_seq_cst) > 0);
+			});
+			m_sleepingThreads.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+		// The last finish() may still hold the lock, the counter must not be destroyed before
+		std::scoped_lock lock(counter.m_mutex);
+	}
+
+	void JobSystem::runMainThreadJobs()
+	{
+		if (!isMainThread())
+		{
+			return;
+		}
+
+		// Jobs queued while these run wait for the next call
+		std::deque<Job> jobs;
+		{
+			std::scoped_lock lock(m_mainThreadMutex);
+			jobs.swap(m_mainThreadJobs);
+		}
+		m_queuedMainThreadJobs.fetch_sub(static_cast<int64_t>(jobs.size()), std::memory_order_seq_cst);
+
+		for (const auto& job : jobs)
+		{
+			run(job);
+		}
+	}
+
+	uint32_t JobSystem::getWorkerCount() const
+	{
+		return static_cast<uint32_t>(m_deques.size());
+	}
+
+	bool JobSystem::isMainThread() const
+	{
+		return std::this_thread::get_id() == m_mainThread;
+	}
+
+	uint32_t JobSystem::defaultWorkerCount()
+	{
+		return std::max(std::thread::hardware_concurrency(), 1U);
+	}
+
+	void JobSystem::workerLoop(uint32_t workerIndex)
+	{
+		t_jobSystem = this;
+		t_workerIndex = workerIndex;
+
+		while (true)
+		{
+			std::optional<Job> job = findJob(workerIndex);
+			if (!job)
+			{
+				job = popBackgroundJob();
+			}
+
+			if (job)
+			{
+				run(*job);
+				continue;
+			}
+
+			std::unique_lock lock(m_sleepMutex);
+			m_sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+			m_jobAvailable.wait(lock, [this] {
+				return m_stopping || m_queuedJobs.load(std::memory_order_seq_cst) > 0 || m_queuedBackgroundJobs.load(std::memory_order_seq_cst) > 0;
+			});
+			m_sleepingThreads.fetch_sub(1, std::memory_order_seq_cst);
+
+			if (m_stopping && m_queuedJobs.load(std::memory_order_seq_cst) <= 0 && m_queuedBackgroundJobs.load(std::memory_order_seq_cst) <= 0)
+			{
+				return;
+			}
+		}
+	}
+
+	void JobSystem::enqueue(const Job& job)
+	{
+		const std::optional<uint32_t> worker = currentWorker();
+		if (!worker || !m_deques[*worker]->push(job))
+		{
+			std::scoped_lock lock(m_injectedMutex);
+			m_injected.push_back(job);
+		}
+
+		// After the push, a worker woken by the count finds the job
+		m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+		wake();
+	}
+
+	std::optional<Job> JobSystem::findJob(std::optional<uint32_t> workerIndex)
+	{
+		std::optional<Job> job;
+		if (workerIndex)
+		{
+			job = m_deques[*workerIndex]->pop();
+		}
+
+		// Victims in order after the thief, so workers spread over different deques
+		const uint32_t workerCount = getWorkerCount();
+		const uint32_t first = workerIndex.value_or(0);
+		for (uint32_t i = 1; !job && i <= workerCount; ++i)
+		{
+			const uint32_t victim = (first + i) % workerCount;
+			if (victim != workerIndex)
+			{
+				job = m_deques[victim]->steal();
+			}
+		}
+
+		if (!job)
+		{
+			std::scoped_lock lock(m_injectedMutex);
+			if (!m_injected.empty())
+			{
+				job = m_injected.front();
+				m_injected.pop_front();
+			}
+		}
+
+		if (job)
+		{
+			m_queuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+		return job;
+	}
+
+	std::optional<Job> JobSystem::popMainThreadJob()
+	{
+		std::scoped_lock lock(m_mainThreadMutex);
+		if (m_mainThreadJobs.empty())
+		{
+			return std::nullopt;
+		}
+
+		const Job job = m_mainThreadJobs.front();
+		m_mainThreadJobs.pop_front();
+		m_queuedMainThreadJobs.fetch_sub(1, std::memory_order_seq_cst);
+		return job;
+	}
+
+	std::optional<Job> JobSystem::popBackgroundJob()
+	{
+		std::scoped_lock lock(m_backgroundMutex);
+		if (m_backgroundJobs.empty())
+		{
+			return std::nullopt;
+		}
+
+		const Job job = m_backgroundJobs.front();
+		m_backgroundJobs.pop_front();
+		m_queuedBackgroundJobs.fetch_sub(1, std::memory_order_seq_cst);
+		return job;
+	}
+
+	void JobSystem::run(const Job& job)
+	{
+		job.function(job.data);
+
+		if (job.counter)
+		{
+			finish(*job.counter);
+		}
+	}
+
+	void JobSystem::finish(JobCounter& counter)
+	{
+		std::vector<Job> continuations;
+		bool done = false;
+		{
+			std::scoped_lock lock(counter.m_mutex);
+			if (counter.m_value.fetch_sub(1, std::memory_order_seq_cst) == 1)
+			{
+				continuations.swap(counter.m_continuations);
+				done = true;
+			}
+		}
+
+		// Their counters were raised when they were scheduled
+		for (const auto& job : continuations)
+		{
+			enqueue(job);
+		}
+
+		// The counter may be gone once a waiter sees zero, only the system is touched from here
+		if (done)
+		{
+			wakeAll();
+		}
+	}
+
+	void JobSystem::wake()
+	{
+		if (m_sleepingThreads.load(std::memory_order_seq_cst) == 0)
+		{
+			return;
+		}
+
+		// A thread between its count check and the wait holds the lock, it cannot miss the notify
+		{
+			std::scoped_lock lock(m_sleepMutex);
+		}
+		m_jobAvailable.notify_one();
+	}
+
+	void JobSystem::wakeAll()
+	{
+		if (m_sleepingThreads.load(std::memory_order_seq_cst) == 0)
+		{
+			return;
+		}
+
+		{
+			std::scoped_lock lock(m_sleepMutex);
+		}
+		m_jobAvailable.notify_all();
+	}
+
+	std::optional<uint32_t> JobSystem::currentWorker() const
+	{
+		if (t_jobSystem != this)
+		{
+			return std::nullopt;
+		}
+
+		return t_workerIndex;
+	}
+
+}
@@ -0,0 +1,71 @@
+#include "WorkStealingDeque.hpp"
+
+namespace st::core
+{
+	// Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen,
+	// Zappa Nardelli). The slot a thief reads is never written concurrently since a push fails
+	// before the ring wraps onto the top.
+
+	bool WorkStealingDeque::push(const Job& job)
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		const int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<int64_t>(capacity))
+		{
+			return false;
+		}
+
+		m_jobs[bottom & mask] = job;
+		m_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::optional<Job> WorkStealingDeque::pop()
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+
+		const Job job = m_jobs[bottom & mask];
+		if (top == bottom)
+		{
+			// Last job, a thief may be taking it at the same time
+			const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			if (!won)
+			{
+				return std::nullopt;
+			}
+		}
+
+		return job;
+	}
+
+	std::optional<Job> WorkStealingDeque::steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return std::nullopt;
+		}
+
+		const Job job = m_jobs[top & mask];
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return std::nullopt;
+		}
+
+		return job;
+	}
+
+}
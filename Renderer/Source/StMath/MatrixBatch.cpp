@@ -0,0 +1,77 @@
+#include "MatrixBatch.hpp"
+
+#include <cassert>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ST_MATH_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ST_MATH_NEON
+#endif
+
+namespace st::math
+{
+	void multiplyBatch(const Matrix4x4& lhs, std::span<const Matrix4x4> rhs, std::span<Matrix4x4> result)
+	{
+		assert(result.size() >= rhs.size());
+
+		// Row i of the product is the sum of the rows of rhs weighted by row i of lhs
+#if defined(ST_MATH_SSE)
+		__m128 weights[16];
+		for (size_t i = 0; i < 16; ++i)
+		{
+			weights[i] = _mm_set1_ps(lhs[i]);
+		}
+
+		for (size_t index = 0; index < rhs.size(); ++index)
+		{
+			const float* source = &rhs[index][0];
+			const __m128 row0 = _mm_loadu_ps(source);
+			const __m128 row1 = _mm_loadu_ps(source + 4);
+			const __m128 row2 = _mm_loadu_ps(source + 8);
+			const __m128 row3 = _mm_loadu_ps(source + 12);
+
+			float* destination = &result[index][0];
+			for (size_t row = 0; row < 4; ++row)
+			{
+				__m128 sum = _mm_mul_ps(weights[row * 4], row0);
+				sum = _mm_add_ps(sum, _mm_mul_ps(weights[row * 4 + 1], row1));
+				sum = _mm_add_ps(sum, _mm_mul_ps(weights[row * 4 + 2], row2));
+				sum = _mm_add_ps(sum, _mm_mul_ps(weights[row * 4 + 3], row3));
+				_mm_storeu_ps(destination + row * 4, sum);
+			}
+		}
+#elif defined(ST_MATH_NEON)
+		float32x4_t weights[4];
+		for (size_t i = 0; i < 4; ++i)
+		{
+			weights[i] = vld1q_f32(&lhs[i * 4]);
+		}
+
+		for (size_t index = 0; index < rhs.size(); ++index)
+		{
+			const float* source = &rhs[index][0];
+			const float32x4_t row0 = vld1q_f32(source);
+			const float32x4_t row1 = vld1q_f32(source + 4);
+			const float32x4_t row2 = vld1q_f32(source + 8);
+			const float32x4_t row3 = vld1q_f32(source + 12);
+
+			float* destination = &result[index][0];
+			for (size_t row = 0; row < 4; ++row)
+			{
+				float32x4_t sum = vmulq_lane_f32(row0, vget_low_f32(weights[row]), 0);
+				sum = vmlaq_lane_f32(sum, row1, vget_low_f32(weights[row]), 1);
+				sum = vmlaq_lane_f32(sum, row2, vget_high_f32(weights[row]), 0);
+				sum = vmlaq_lane_f32(sum, row3, vget_high_f32(weights[row]), 1);
+				vst1q_f32(destination + row * 4, sum);
+			}
+		}
+#else
+		for (size_t index = 0; index < rhs.size(); ++index)
+		{
+			result[index] = lhs * rhs[index];
+		}
+#endif
+	}
+}
@@ -0,0 +1,112 @@
+#include "TransformBuffer.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace st::math
+{
+	void TransformStream::resize(size_t count)
+	{
+		positionX.resize(count, 0.0F);
+		positionY.resize(count, 0.0F);
+		positionZ.resize(count, 0.0F);
+
+		rotationX.resize(count, 0.0F);
+		rotationY.resize(count, 0.0F);
+		rotationZ.resize(count, 0.0F);
+		rotationW.resize(count, 1.0F);
+
+		scale.resize(count, 1.0F);
+	}
+
+	size_t TransformStream::size() const
+	{
+		return positionX.size();
+	}
+
+	void TransformBuffer::resize(size_t count)
+	{
+		m_previous.resize(count);
+		m_current.resize(count);
+	}
+
+	size_t TransformBuffer::size() const
+	{
+		return m_current.size();
+	}
+
+	void TransformBuffer::beginTick()
+	{
+		// Copied rather than swapped, a tick only writes what moved
+		m_previous = m_current;
+	}
+
+	TransformStream& TransformBuffer::current()
+	{
+		return m_current;
+	}
+
+	const TransformStream& TransformBuffer::current() const
+	{
+		return m_current;
+	}
+
+	const TransformStream& TransformBuffer::previous() const
+	{
+		return m_previous;
+	}
+
+	void TransformBuffer::interpolate(float alpha, std::span<Matrix4x4> models) const
+	{
+		assert(models.size() >= size());
+
+		const float beta = 1.0F - alpha;
+		for (size_t i = 0; i < size(); ++i)
+		{
+			const float x = m_previous.positionX[i] * beta + m_current.positionX[i] * alpha;
+			const float y = m_previous.positionY[i] * beta + m_current.positionY[i] * alpha;
+			const float z = m_previous.positionZ[i] * beta + m_current.positionZ[i] * alpha;
+			const float s = m_previous.scale[i] * beta + m_current.scale[i] * alpha;
+
+			// The shorter arc, q and -q are the same rotation
+			const float dot = m_previous.rotationX[i] * m_current.rotationX[i] + m_previous.rotationY[i] * m_current.rotationY[i] +
+							  m_previous.rotationZ[i] * m_current.rotationZ[i] + m_previous.rotationW[i] * m_current.rotationW[i];
+			const float currentWeight = dot < 0.0F ? -alpha : alpha;
+
+			float qx = m_previous.rotationX[i] * beta + m_current.rotationX[i] * currentWeight;
+			float qy = m_previous.rotationY[i] * beta + m_current.rotationY[i] * currentWeight;
+			float qz = m_previous.rotationZ[i] * beta + m_current.rotationZ[i] * currentWeight;
+			float qw = m_previous.rotationW[i] * beta + m_current.rotationW[i] * currentWeight;
+
+			const float length = std::sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+			const float inverseLength = length > 0.0F ? 1.0F / length : 0.0F;
+			qx *= inverseLength;
+			qy *= inverseLength;
+			qz *= inverseLength;
+			qw *= inverseLength;
+
+			// Translation * rotation * scale, rows as written by Matrix4x4::translate
+			Matrix4x4& model = models[i];
+			model[0] = (1.0F - 2.0F * (qy * qy + qz * qz)) * s;
+			model[1] = 2.0F * (qx * qy - qw * qz) * s;
+			model[2] = 2.0F * (qx * qz + qw * qy) * s;
+			model[3] = x;
+
+			model[4] = 2.0F * (qx * qy + qw * qz) * s;
+			model[5] = (1.0F - 2.0F * (qx * qx + qz * qz)) * s;
+			model[6] = 2.0F * (qy * qz - qw * qx) * s;
+			model[7] = y;
+
+			model[8] = 2.0F * (qx * qz - qw * qy) * s;
+			model[9] = 2.0F * (qy * qz + qw * qx) * s;
+			model[10] = (1.0F - 2.0F * (qx * qx + qy * qy)) * s;
+			model[11] = z;
+
+			model[12] = 0.0F;
+			model[13] = 0.0F;
+			model[14] = 0.0F;
+			model[15] = 1.0F;
+		}
+	}
+
+}
@@ -0,0 +1,110 @@
+#include "BindlessTextures.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace st::renderer
+{
+
+	BindlessTextures::~BindlessTextures()
+	{
+		shutdown();
+	}
+
+	bool BindlessTextures::isSupported(const vk::PhysicalDeviceVulkan12Features& features)
+	{
+		return features.descriptorIndexing && features.runtimeDescriptorArray && features.shaderSampledImageArrayNonUniformIndexing &&
+			   features.descriptorBindingSampledImageUpdateAfterBind && features.descriptorBindingPartiallyBound &&
+			   features.descriptorBindingVariableDescriptorCount;
+	}
+
+	void BindlessTextures::enableFeatures(vk::PhysicalDeviceVulkan12Features& features)
+	{
+		features.descriptorIndexing = true;
+		features.runtimeDescriptorArray = true;
+		features.shaderSampledImageArrayNonUniformIndexing = true;
+		features.descriptorBindingSampledImageUpdateAfterBind = true;
+		features.descriptorBindingPartiallyBound = true;
+		features.descriptorBindingVariableDescriptorCount = true;
+	}
+
+	void BindlessTextures::init(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t capacity)
+	{
+		m_device = device;
+
+		// Combined image samplers count against both the sampler and the sampled image limits
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+		const auto& limits = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+		m_capacity = std::min({ capacity,
+								limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+								limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+								limits.maxDescriptorSetUpdateAfterBindSamplers,
+								limits.maxDescriptorSetUpdateAfterBindSampledImages });
+		m_count = 0;
+
+		// Unwritten slots are legal as long as the shader never indexes them
+		const vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::ePartiallyBound |
+														vk::DescriptorBindingFlagBits::eVariableDescriptorCount;
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo { bindingFlags };
+
+		vk::DescriptorSetLayoutBinding binding { 0, vk::DescriptorType::eCombinedImageSampler, m_capacity, vk::ShaderStageFlagBits::eFragment };
+		vk::DescriptorSetLayoutCreateInfo layoutInfo { vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool, binding };
+		layoutInfo.setPNext(&bindingFlagsInfo);
+		m_setLayout = m_device.createDescriptorSetLayout(layoutInfo);
+
+		vk::DescriptorPoolSize poolSize { vk::DescriptorType::eCombinedImageSampler, m_capacity };
+		m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo { vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, poolSize });
+
+		vk::DescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo { m_capacity };
+		vk::DescriptorSetAllocateInfo allocateInfo { m_descriptorPool, m_setLayout };
+		allocateInfo.setPNext(&variableCountInfo);
+		m_descriptorSet = m_device.allocateDescriptorSets(allocateInfo).front();
+	}
+
+	void BindlessTextures::shutdown()
+	{
+		if (!m_setLayout)
+		{
+			return;
+		}
+
+		m_device.destroyDescriptorPool(m_descriptorPool);
+		m_device.destroyDescriptorSetLayout(m_setLayout);
+		m_descriptorPool = nullptr;
+		m_setLayout = nullptr;
+		m_descriptorSet = nullptr;
+		m_capacity = 0;
+		m_count = 0;
+	}
+
+	bool BindlessTextures::isEnabled() const
+	{
+		return static_cast<bool>(m_setLayout);
+	}
+
+	TextureHandle BindlessTextures::add(vk::ImageView view, vk::Sampler sampler)
+	{
+		if (m_count == m_capacity)
+		{
+			throw std::runtime_error("bindless texture array is full!");
+		}
+
+		// Update-after-bind, the set may be bound by frames in flight that never read this slot
+		vk::DescriptorImageInfo imageInfo { sampler, view, vk::ImageLayout::eShaderReadOnlyOptimal };
+		vk::WriteDescriptorSet write { m_descriptorSet, 0, m_count, vk::DescriptorType::eCombinedImageSampler, imageInfo, {}, {} };
+		m_device.updateDescriptorSets(write, {});
+
+		return m_count++;
+	}
+
+	vk::DescriptorSetLayout BindlessTextures::getSetLayout() const
+	{
+		return m_setLayout;
+	}
+
+	vk::DescriptorSet BindlessTextures::getDescriptorSet() const
+	{
+		return m_descriptorSet;
+	}
+
+}
@@ -227,6 +227,21 @@ namespace st::renderer
 		return m_matrix;
 	}
 
+	math::Vector3 Camera::getEye() const
+	{
+		return m_eye;
+	}
+
+	math::Vector3 Camera::getCenter() const
+	{
+		return m_center;
+	}
+
+	math::Vector3 Camera::getUp() const
+	{
+		return m_up;
+	}
+
 	math::Matrix4x4 Camera::lookAt(const math::Vector3& eye, const math::Vector3& center, const math::Vector3& up)
 	{
 		using namespace math;
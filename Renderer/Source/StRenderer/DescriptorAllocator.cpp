@@ -0,0 +1,201 @@
+#include "DescriptorAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "StCore/Hash.hpp"
+
+namespace st::renderer
+{
+	namespace
+	{
+		constexpr std::array<DescriptorPoolRatio, 6> defaultRatios { DescriptorPoolRatio { vk::DescriptorType::eUniformBufferDynamic, 1.0F },
+																	 DescriptorPoolRatio { vk::DescriptorType::eUniformBuffer, 1.0F },
+																	 DescriptorPoolRatio { vk::DescriptorType::eCombinedImageSampler, 2.0F },
+																	 DescriptorPoolRatio { vk::DescriptorType::eStorageBuffer, 4.0F },
+																	 DescriptorPoolRatio { vk::DescriptorType::eStorageImage, 1.0F },
+																	 DescriptorPoolRatio { vk::DescriptorType::eUniformTexelBuffer, 0.5F } };
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		shutdown();
+	}
+
+	void DescriptorAllocator::init(vk::Device device, uint32_t setsPerPool)
+	{
+		init(device, setsPerPool, defaultRatios);
+	}
+
+	void DescriptorAllocator::init(vk::Device device, uint32_t setsPerPool, std::span<const DescriptorPoolRatio> ratios)
+	{
+		m_device = device;
+		m_ratios.assign(ratios.begin(), ratios.end());
+		m_setsPerPool = std::clamp(setsPerPool, 1U, maxSetsPerPool);
+
+		m_currentPool = createPool(m_setsPerPool);
+	}
+
+	void DescriptorAllocator::shutdown()
+	{
+		if (!m_currentPool)
+		{
+			return;
+		}
+
+		reset();
+		for (auto pool : m_readyPools)
+		{
+			m_device.destroyDescriptorPool(pool);
+		}
+		m_readyPools.clear();
+
+		m_device.destroyDescriptorPool(m_currentPool);
+		m_currentPool = nullptr;
+	}
+
+	vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout)
+	{
+		// Into a handle on the stack, the overload returning a vector allocates on every call
+		vk::DescriptorSet descriptorSet;
+		vk::DescriptorSetAllocateInfo allocateInfo { m_currentPool, layout };
+		vk::Result result = m_device.allocateDescriptorSets(&allocateInfo, &descriptorSet);
+
+		if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+		{
+			// The current pool is exhausted, a fresh one always has room for a single set
+			m_fullPools.push_back(m_currentPool);
+			m_currentPool = nextPool();
+
+			allocateInfo.descriptorPool = m_currentPool;
+			result = m_device.allocateDescriptorSets(&allocateInfo, &descriptorSet);
+		}
+
+		if (result != vk::Result::eSuccess)
+		{
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}
+
+		return descriptorSet;
+	}
+
+	void DescriptorAllocator::reset()
+	{
+		m_device.resetDescriptorPool(m_currentPool);
+		for (auto pool : m_fullPools)
+		{
+			m_device.resetDescriptorPool(pool);
+			m_readyPools.push_back(pool);
+		}
+		m_fullPools.clear();
+	}
+
+	uint32_t DescriptorAllocator::getPoolCount() const
+	{
+		return static_cast<uint32_t>(m_fullPools.size() + m_readyPools.size()) + (m_currentPool ? 1 : 0);
+	}
+
+	vk::DescriptorPool DescriptorAllocator::createPool(uint32_t setCount) const
+	{
+		std::vector<vk::DescriptorPoolSize> poolSizes;
+		for (const auto& ratio : m_ratios)
+		{
+			const auto count = static_cast<uint32_t>(std::ceil(ratio.ratio * static_cast<float>(setCount)));
+			poolSizes.push_back(vk::DescriptorPoolSize { ratio.type, std::max(count, 1U) });
+		}
+
+		return m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo { {}, setCount, poolSizes });
+	}
+
+	vk::DescriptorPool DescriptorAllocator::nextPool()
+	{
+		if (!m_readyPools.empty())
+		{
+			const vk::DescriptorPool pool = m_readyPools.back();
+			m_readyPools.pop_back();
+			return pool;
+		}
+
+		// Each new pool is larger, the chain stays short as the set count grows
+		m_setsPerPool = std::min(m_setsPerPool * 2, maxSetsPerPool);
+		return createPool(m_setsPerPool);
+	}
+
+	void DescriptorCache::init(vk::Device device, DescriptorAllocator& allocator)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_sets.clear();
+	}
+
+	vk::DescriptorSet DescriptorCache::get(vk::DescriptorSetLayout layout, std::span<const DescriptorBinding> bindings)
+	{
+		Key key { layout, { bindings.begin(), bindings.end() } };
+
+		const auto it = m_sets.find(key);
+		if (it != m_sets.end())
+		{
+			return it->second;
+		}
+
+		const vk::DescriptorSet descriptorSet = m_allocator->allocate(layout);
+
+		std::vector<vk::WriteDescriptorSet> writes;
+		writes.reserve(bindings.size());
+		for (const auto& binding : bindings)
+		{
+			vk::WriteDescriptorSet write { descriptorSet, binding.binding, 0, 1, binding.type };
+			switch (binding.type)
+			{
+			case vk::DescriptorType::eSampler:
+			case vk::DescriptorType::eCombinedImageSampler:
+			case vk::DescriptorType::eSampledImage:
+			case vk::DescriptorType::eStorageImage:
+			case vk::DescriptorType::eInputAttachment:
+				write.pImageInfo = &binding.image;
+				break;
+			default:
+				write.pBufferInfo = &binding.buffer;
+				break;
+			}
+			writes.push_back(write);
+		}
+		m_device.updateDescriptorSets(writes, {});
+
+		m_sets.emplace(std::move(key), descriptorSet);
+		return descriptorSet;
+	}
+
+	void DescriptorCache::clear()
+	{
+		m_sets.clear();
+	}
+
+	size_t DescriptorCache::size() const
+	{
+		return m_sets.size();
+	}
+
+	size_t DescriptorCache::KeyHash::operator()(const Key& key) const
+	{
+		uint64_t hash = st::core::fnv1aOffsetBasis;
+		st::core::hashValue(hash, st::core::handleValue(key.layout));
+
+		for (const auto& binding : key.bindings)
+		{
+			st::core::hashValue(hash, binding.binding);
+			st::core::hashValue(hash, static_cast<uint64_t>(binding.type));
+			st::core::hashValue(hash, st::core::handleValue(binding.buffer.buffer));
+			st::core::hashValue(hash, binding.buffer.offset);
+			st::core::hashValue(hash, binding.buffer.range);
+			st::core::hashValue(hash, st::core::handleValue(binding.image.sampler));
+			st::core::hashValue(hash, st::core::handleValue(binding.image.imageView));
+			st::core::hashValue(hash, static_cast<uint64_t>(binding.image.imageLayout));
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
+}
@@ -0,0 +1,99 @@
+#include "DeviceSelection.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "BindlessTextures.hpp"
+
+namespace st::renderer
+{
+	namespace
+	{
+		// Every lower term adds up to less than one step, so a better type always wins
+		constexpr uint64_t typeWeight = 1'000'000;
+
+		uint64_t typeRank(vk::PhysicalDeviceType type)
+		{
+			switch (type)
+			{
+			case vk::PhysicalDeviceType::eDiscreteGpu:
+				return 4;
+			case vk::PhysicalDeviceType::eIntegratedGpu:
+				return 3;
+			case vk::PhysicalDeviceType::eVirtualGpu:
+				return 2;
+			case vk::PhysicalDeviceType::eCpu:
+				return 1;
+			default:
+				return 0;
+			}
+		}
+
+		bool hasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name)
+		{
+			return std::any_of(extensions.begin(), extensions.end(), [name](const vk::ExtensionProperties& extension) {
+				return std::strcmp(extension.extensionName, name) == 0;
+			});
+		}
+	}
+
+	DeviceProfile DeviceProfile::query(vk::PhysicalDevice physicalDevice)
+	{
+		DeviceProfile profile;
+		profile.physicalDevice = physicalDevice;
+
+		const vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+		profile.name = properties.deviceName.data();
+		profile.type = properties.deviceType;
+
+		const vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+		{
+			if (memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+			{
+				profile.deviceLocalMemory = std::max(profile.deviceLocalMemory, memoryProperties.memoryHeaps[i].size);
+			}
+		}
+
+		for (const auto& queueFamily : physicalDevice.getQueueFamilyProperties())
+		{
+			if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+			{
+				continue;
+			}
+
+			profile.features.dedicatedTransferQueue |= static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eTransfer);
+			profile.features.asyncComputeQueue |= static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eCompute);
+		}
+
+		const auto supportedFeatures = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		const auto& vulkan12Features = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+		profile.features.descriptorIndexing = BindlessTextures::isSupported(vulkan12Features);
+		profile.features.timelineSemaphore = vulkan12Features.timelineSemaphore;
+		profile.features.drawIndirectCount = vulkan12Features.drawIndirectCount;
+		profile.features.multiDrawIndirect = supportedFeatures.get<vk::PhysicalDeviceFeatures2>().features.multiDrawIndirect;
+
+		profile.features.memoryBudget = hasExtension(physicalDevice.enumerateDeviceExtensionProperties(), VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		return profile;
+	}
+
+	uint64_t DeviceProfile::score() const
+	{
+		uint64_t score = typeRank(type) * typeWeight;
+
+		// One point per 64 MiB, capped at 256 GiB
+		score += std::min<uint64_t>(deviceLocalMemory / (64ULL * 1024 * 1024), 4096);
+
+		// Weighted by how much of the frame each path saves
+		score += features.dedicatedTransferQueue ? 20'000 : 0;
+		score += features.asyncComputeQueue ? 5'000 : 0;
+		score += features.descriptorIndexing ? 40'000 : 0;
+		score += features.drawIndirectCount ? 30'000 : 0;
+		score += features.multiDrawIndirect ? 20'000 : 0;
+		score += features.memoryBudget ? 5'000 : 0;
+
+		return score;
+	}
+
+}
@@ -0,0 +1,164 @@
+#include "DrawList.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace st::renderer
+{
+	namespace
+	{
+		constexpr uint64_t fieldMask(uint32_t bits)
+		{
+			return (uint64_t { 1 } << bits) - 1;
+		}
+
+		constexpr uint32_t depthShift = 0;
+		constexpr uint32_t meshShift = depthShift + DrawKey::depthBits;
+		constexpr uint32_t materialShift = meshShift + DrawKey::meshBits;
+		constexpr uint32_t pipelineShift = materialShift + DrawKey::materialBits;
+		constexpr uint32_t passShift = pipelineShift + DrawKey::pipelineBits;
+
+		static_assert(passShift + DrawKey::passBits == 64, "draw key fields must fill 64 bits");
+
+		constexpr uint32_t radixBits = 8;
+		constexpr uint32_t radixSize = 1 << radixBits;
+		constexpr uint32_t radixPasses = 64 / radixBits;
+	}
+
+	uint64_t DrawKey::make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+	{
+		return ((pass & fieldMask(passBits)) << passShift) | ((pipeline & fieldMask(pipelineBits)) << pipelineShift) |
+			   ((material & fieldMask(materialBits)) << materialShift) | ((mesh & fieldMask(meshBits)) << meshShift) |
+			   ((depth & fieldMask(depthBits)) << depthShift);
+	}
+
+	uint32_t DrawKey::quantizeDepth(float distance, float farPlane)
+	{
+		const float normalized = std::clamp(distance / farPlane, 0.0F, 1.0F);
+		return static_cast<uint32_t>(normalized * static_cast<float>(fieldMask(depthBits)));
+	}
+
+	uint32_t DrawKey::pass(uint64_t key)
+	{
+		return static_cast<uint32_t>((key >> passShift) & fieldMask(passBits));
+	}
+
+	void DrawList::clear()
+	{
+		m_packets.clear();
+	}
+
+	void DrawList::add(uint64_t key, uint32_t payload)
+	{
+		m_packets.push_back(DrawPacket { key, payload });
+	}
+
+	void DrawList::sort()
+	{
+		if (m_packets.size() < 2)
+		{
+			return;
+		}
+
+		// Histograms of every byte in a single read of the keys
+		std::array<std::array<uint32_t, radixSize>, radixPasses> histograms {};
+		for (const auto& packet : m_packets)
+		{
+			for (uint32_t pass = 0; pass < radixPasses; ++pass)
+			{
+				++histograms[pass][(packet.key >> (pass * radixBits)) & (radixSize - 1)];
+			}
+		}
+
+		m_scratch.resize(m_packets.size());
+		const auto count = static_cast<uint32_t>(m_packets.size());
+
+		for (uint32_t pass = 0; pass < radixPasses; ++pass)
+		{
+			auto& histogram = histograms[pass];
+
+			// All keys share this byte, the pass would not move anything
+			if (std::find(histogram.begin(), histogram.end(), count) != histogram.end())
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				const uint32_t size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for (const auto& packet : m_packets)
+			{
+				m_scratch[histogram[(packet.key >> (pass * radixBits)) & (radixSize - 1)]++] = packet;
+			}
+			m_packets.swap(m_scratch);
+		}
+	}
+
+	std::span<const DrawPacket> DrawList::getPackets() const
+	{
+		return m_packets;
+	}
+
+	bool DrawList::empty() const
+	{
+		return m_packets.empty();
+	}
+
+	CommandStateCache::CommandStateCache(vk::CommandBuffer commandBuffer, DrawStatistics& statistics)
+		: m_commandBuffer(commandBuffer),
+		  m_statistics(&statistics)
+	{
+	}
+
+	void CommandStateCache::bindPipeline(vk::Pipeline pipeline)
+	{
+		if (pipeline == m_pipeline)
+		{
+			++m_statistics->bindsSaved;
+			return;
+		}
+
+		m_commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+		m_pipeline = pipeline;
+		++m_statistics->pipelineBinds;
+	}
+
+	void CommandStateCache::bindVertexBuffer(uint32_t binding, vk::Buffer buffer)
+	{
+		if (buffer == m_vertexBuffers[binding])
+		{
+			++m_statistics->bindsSaved;
+			return;
+		}
+
+		m_commandBuffer.bindVertexBuffers(binding, buffer, vk::DeviceSize { 0 });
+		m_vertexBuffers[binding] = buffer;
+		++m_statistics->bufferBinds;
+	}
+
+	void CommandStateCache::bindIndexBuffer(vk::Buffer buffer)
+	{
+		if (buffer == m_indexBuffer)
+		{
+			++m_statistics->bindsSaved;
+			return;
+		}
+
+		m_commandBuffer.bindIndexBuffer(buffer, 0, vk::IndexType::eUint32);
+		m_indexBuffer = buffer;
+		++m_statistics->bufferBinds;
+	}
+
+	void CommandStateCache::invalidate()
+	{
+		m_pipeline = nullptr;
+		std::fill(std::begin(m_vertexBuffers), std::end(m_vertexBuffers), vk::Buffer {});
+		m_indexBuffer = nullptr;
+	}
+
+}
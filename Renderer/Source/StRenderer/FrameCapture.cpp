@@ -0,0 +1,209 @@
+#include "FrameCapture.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+namespace st::renderer
+{
+	namespace
+	{
+		constexpr uint32_t bytesPerPixel = 4;
+
+		bool endsWith(const std::string& value, const std::string& suffix)
+		{
+			return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		shutdown();
+	}
+
+	void FrameCapture::init(vk::Device device, MemoryAllocator& allocator, vk::CommandPool commandPool, uint32_t frameCount, st::core::JobSystem& jobSystem)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_commandPool = commandPool;
+		m_jobSystem = &jobSystem;
+
+		const std::vector<vk::CommandBuffer> commandBuffers =
+			m_device.allocateCommandBuffers(vk::CommandBufferAllocateInfo { m_commandPool, vk::CommandBufferLevel::ePrimary, frameCount });
+
+		m_frames.resize(frameCount);
+		for (uint32_t i = 0; i < frameCount; ++i)
+		{
+			m_frames[i].commandBuffer = commandBuffers[i];
+		}
+	}
+
+	void FrameCapture::shutdown()
+	{
+		if (m_frames.empty())
+		{
+			return;
+		}
+
+		// Finishes the files already queued
+		waitIdle();
+		m_jobSystem = nullptr;
+
+		for (auto& frame : m_frames)
+		{
+			m_device.freeCommandBuffers(m_commandPool, frame.commandBuffer);
+			if (frame.buffer)
+			{
+				m_device.destroyBuffer(frame.buffer);
+				m_allocator->free(frame.memory);
+			}
+		}
+		m_frames.clear();
+	}
+
+	void FrameCapture::request(const std::string& path)
+	{
+		m_requestedPath = path;
+	}
+
+	vk::CommandBuffer FrameCapture::record(uint32_t frameIndex, vk::Image image, vk::Format format, vk::Extent2D extent)
+	{
+		if (m_requestedPath.empty())
+		{
+			return nullptr;
+		}
+
+		Frame& frame = m_frames.at(frameIndex);
+
+		const vk::DeviceSize size = static_cast<vk::DeviceSize>(extent.width) * extent.height * bytesPerPixel;
+		if (frame.capacity < size)
+		{
+			// The fence of the frame was waited on, its buffer is no longer read
+			if (frame.buffer)
+			{
+				m_device.destroyBuffer(frame.buffer);
+				m_allocator->free(frame.memory);
+			}
+
+			frame.buffer = m_device.createBuffer(vk::BufferCreateInfo { {}, size, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive });
+			frame.memory = m_allocator->allocateForBuffer(frame.buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+			m_device.bindBufferMemory(frame.buffer, frame.memory.memory, frame.memory.offset);
+			frame.capacity = size;
+		}
+
+		frame.path = std::move(m_requestedPath);
+		m_requestedPath.clear();
+		frame.extent = extent;
+		frame.bgra = format == vk::Format::eB8G8R8A8Srgb || format == vk::Format::eB8G8R8A8Unorm;
+
+		vk::CommandBuffer commandBuffer = frame.commandBuffer;
+		commandBuffer.reset(vk::CommandBufferResetFlags {});
+		commandBuffer.begin(vk::CommandBufferBeginInfo { vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+		// The render pass already left the image in eTransferSrcOptimal, only its writes need to be waited for
+		const vk::ImageMemoryBarrier imageBarrier { vk::AccessFlagBits::eColorAttachmentWrite,
+													vk::AccessFlagBits::eTransferRead,
+													vk::ImageLayout::eTransferSrcOptimal,
+													vk::ImageLayout::eTransferSrcOptimal,
+													VK_QUEUE_FAMILY_IGNORED,
+													VK_QUEUE_FAMILY_IGNORED,
+													image,
+													{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, imageBarrier);
+
+		const vk::BufferImageCopy region { 0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, { 0, 0, 0 }, { extent.width, extent.height, 1 } };
+		commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, frame.buffer, region);
+
+		const vk::BufferMemoryBarrier bufferBarrier { vk::AccessFlagBits::eTransferWrite,
+													  vk::AccessFlagBits::eHostRead,
+													  VK_QUEUE_FAMILY_IGNORED,
+													  VK_QUEUE_FAMILY_IGNORED,
+													  frame.buffer,
+													  0,
+													  size };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, bufferBarrier, {});
+
+		commandBuffer.end();
+		return commandBuffer;
+	}
+
+	void FrameCapture::collect(uint32_t frameIndex)
+	{
+		Frame& frame = m_frames.at(frameIndex);
+		if (frame.path.empty())
+		{
+			return;
+		}
+
+		// One copy out of the mapped buffer, the slot is reused by the next frame
+		const size_t size = static_cast<size_t>(frame.extent.width) * frame.extent.height * bytesPerPixel;
+		std::vector<uint8_t> pixels(size);
+		std::memcpy(pixels.data(), frame.memory.mappedData, size);
+
+		if (frame.bgra)
+		{
+			for (size_t i = 0; i < size; i += bytesPerPixel)
+			{
+				std::swap(pixels[i], pixels[i + 2]);
+			}
+		}
+
+		// Encoding a PNG takes longer than a frame, it never runs on the thread that waits for one
+		const st::core::JobFunction writeJob = [](void* data) {
+			const std::unique_ptr<PendingWrite> pending(static_cast<PendingWrite*>(data));
+			write(pending->path, pending->extent, pending->rgba);
+		};
+		auto* pending = new PendingWrite { std::move(frame.path), frame.extent, std::move(pixels) };
+		m_jobSystem->scheduleBackground(st::core::Job { writeJob, pending, &m_pendingWrites });
+		frame.path.clear();
+	}
+
+	void FrameCapture::waitIdle()
+	{
+		if (m_jobSystem)
+		{
+			m_jobSystem->wait(m_pendingWrites);
+		}
+	}
+
+	void FrameCapture::write(const std::string& path, vk::Extent2D extent, const std::vector<uint8_t>& rgba)
+	{
+		const auto width = static_cast<int>(extent.width);
+		const auto height = static_cast<int>(extent.height);
+
+		// Runs on a worker, a failed capture is reported without taking the renderer down
+		if (endsWith(path, ".png"))
+		{
+			if (stbi_write_png(path.c_str(), width, height, bytesPerPixel, rgba.data(), width * bytesPerPixel) == 0)
+			{
+				std::cerr << "Frame capture: failed to write " << path << std::endl;
+			}
+			return;
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Frame capture: failed to open " << path << std::endl;
+			return;
+		}
+
+		file << "P6\n" << width << " " << height << "\n255\n";
+		for (size_t i = 0; i < rgba.size(); i += bytesPerPixel)
+		{
+			file.write(reinterpret_cast<const char*>(&rgba[i]), 3);
+		}
+
+		file.close();
+		if (!file)
+		{
+			std::cerr << "Frame capture: failed to write " << path << std::endl;
+		}
+	}
+
+}
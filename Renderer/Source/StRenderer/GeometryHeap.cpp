@@ -0,0 +1,224 @@
+#include "GeometryHeap.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "StCore/Hash.hpp"
+
+namespace st::renderer
+{
+	GeometryHeap::~GeometryHeap()
+	{
+		shutdown();
+	}
+
+	void GeometryHeap::init(vk::Device device,
+							MemoryAllocator& allocator,
+							TransferContext& transferContext,
+							uint32_t frameCount,
+							uint32_t vertexCapacity,
+							uint32_t indexCapacity)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_transferContext = &transferContext;
+
+		m_vertexBuffer = m_device.createBuffer(vk::BufferCreateInfo { {},
+																	  vertexCapacity * sizeof(Vertex),
+																	  vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+																	  vk::SharingMode::eExclusive });
+		m_vertexMemory = m_allocator->allocateForBuffer(m_vertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		m_device.bindBufferMemory(m_vertexBuffer, m_vertexMemory.memory, m_vertexMemory.offset);
+
+		m_indexBuffer = m_device.createBuffer(vk::BufferCreateInfo { {},
+																	 indexCapacity * sizeof(uint32_t),
+																	 vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+																	 vk::SharingMode::eExclusive });
+		m_indexMemory = m_allocator->allocateForBuffer(m_indexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		m_device.bindBufferMemory(m_indexBuffer, m_indexMemory.memory, m_indexMemory.offset);
+
+		// Both allocators count elements, not bytes
+		m_vertexAllocator.reset(vertexCapacity);
+		m_indexAllocator.reset(indexCapacity);
+
+		m_pendingFrees.assign(frameCount, {});
+		m_frameIndex = 0;
+	}
+
+	void GeometryHeap::shutdown()
+	{
+		if (!m_vertexBuffer)
+		{
+			return;
+		}
+
+		m_entries.clear();
+		m_unusedEntries.clear();
+		m_entriesByHash.clear();
+		m_pendingFrees.clear();
+
+		m_device.destroyBuffer(m_vertexBuffer);
+		m_allocator->free(m_vertexMemory);
+		m_device.destroyBuffer(m_indexBuffer);
+		m_allocator->free(m_indexMemory);
+		m_vertexBuffer = nullptr;
+		m_indexBuffer = nullptr;
+	}
+
+	GeometryRange GeometryHeap::add(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+	{
+		if (vertices.empty() || indices.empty())
+		{
+			throw std::invalid_argument("geometry without vertices or indices!");
+		}
+
+		const uint64_t contentHash = hashGeometry(vertices, indices);
+
+		// Different geometry can share a hash, on a mismatch it gets its own range and takes over
+		// the hash slot
+		uint32_t entryIndex = 0;
+		const auto found = m_entriesByHash.find(contentHash);
+		if (found != m_entriesByHash.end() && std::ranges::equal(m_entries[found->second].vertexData, vertices) &&
+			std::ranges::equal(m_entries[found->second].indexData, indices))
+		{
+			entryIndex = found->second;
+		}
+		else
+		{
+			const TlsfAllocator::Allocation vertexRange = m_vertexAllocator.allocate(vertices.size());
+			const TlsfAllocator::Allocation indexRange = m_indexAllocator.allocate(indices.size());
+			if (!vertexRange.isValid() || !indexRange.isValid())
+			{
+				if (vertexRange.isValid())
+				{
+					m_vertexAllocator.free(vertexRange);
+				}
+				if (indexRange.isValid())
+				{
+					m_indexAllocator.free(indexRange);
+				}
+				throw std::runtime_error("geometry heap is full!");
+			}
+
+			if (m_unusedEntries.empty())
+			{
+				entryIndex = static_cast<uint32_t>(m_entries.size());
+				m_entries.emplace_back();
+			}
+			else
+			{
+				entryIndex = m_unusedEntries.back();
+				m_unusedEntries.pop_back();
+			}
+
+			m_entries[entryIndex] = Entry { contentHash,
+											vertexRange,
+											indexRange,
+											static_cast<uint32_t>(vertices.size()),
+											static_cast<uint32_t>(indices.size()),
+											0,
+											std::vector<Vertex>(vertices.begin(), vertices.end()),
+											std::vector<uint32_t>(indices.begin(), indices.end()) };
+			m_entriesByHash[contentHash] = entryIndex;
+
+			m_transferContext->uploadBuffer(m_vertexBuffer, vertexRange.offset * sizeof(Vertex), std::as_bytes(vertices));
+			m_transferContext->uploadBuffer(m_indexBuffer, indexRange.offset * sizeof(uint32_t), std::as_bytes(indices));
+		}
+
+		Entry& entry = m_entries[entryIndex];
+		++entry.references;
+
+		return GeometryRange { entryIndex,
+							   static_cast<int32_t>(entry.vertices.offset),
+							   static_cast<uint32_t>(entry.indices.offset),
+							   entry.indexCount };
+	}
+
+	void GeometryHeap::release(const GeometryRange& range)
+	{
+		Entry& entry = m_entries.at(range.entry);
+		if (--entry.references > 0)
+		{
+			return;
+		}
+
+		// No new reference may find it, the ranges are freed once the GPU is done with them
+		const auto found = m_entriesByHash.find(entry.contentHash);
+		if (found != m_entriesByHash.end() && found->second == range.entry)
+		{
+			m_entriesByHash.erase(found);
+		}
+
+		m_pendingFrees[m_frameIndex].push_back(range.entry);
+	}
+
+	void GeometryHeap::beginFrame(uint32_t frameIndex)
+	{
+		m_frameIndex = frameIndex;
+
+		for (uint32_t entry : m_pendingFrees[frameIndex])
+		{
+			free(entry);
+		}
+		m_pendingFrees[frameIndex].clear();
+	}
+
+	void GeometryHeap::bind(vk::CommandBuffer commandBuffer) const
+	{
+		commandBuffer.bindVertexBuffers(0, m_vertexBuffer, vk::DeviceSize { 0 });
+		commandBuffer.bindIndexBuffer(m_indexBuffer, 0, vk::IndexType::eUint32);
+	}
+
+	vk::Buffer GeometryHeap::getVertexBuffer() const
+	{
+		return m_vertexBuffer;
+	}
+
+	vk::Buffer GeometryHeap::getIndexBuffer() const
+	{
+		return m_indexBuffer;
+	}
+
+	uint32_t GeometryHeap::getUsedVertices() const
+	{
+		return static_cast<uint32_t>(m_vertexAllocator.getUsedSize());
+	}
+
+	uint32_t GeometryHeap::getUsedIndices() const
+	{
+		return static_cast<uint32_t>(m_indexAllocator.getUsedSize());
+	}
+
+	uint64_t GeometryHeap::hashGeometry(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+	{
+		uint64_t hash = st::core::fnv1aOffsetBasis;
+
+		// Member by member, Vertex has padding with unspecified contents
+		for (const auto& vertex : vertices)
+		{
+			st::core::hashFloat(hash, vertex.m_pos.X);
+			st::core::hashFloat(hash, vertex.m_pos.Y);
+			st::core::hashFloat(hash, vertex.m_pos.Z);
+			st::core::hashFloat(hash, vertex.m_texCoord.X);
+			st::core::hashFloat(hash, vertex.m_texCoord.Y);
+			st::core::hashFloat(hash, vertex.m_color.X);
+			st::core::hashFloat(hash, vertex.m_color.Y);
+			st::core::hashFloat(hash, vertex.m_color.Z);
+			st::core::hashFloat(hash, vertex.m_normal.X);
+			st::core::hashFloat(hash, vertex.m_normal.Y);
+			st::core::hashFloat(hash, vertex.m_normal.Z);
+		}
+
+		st::core::hashBytes(hash, indices.data(), indices.size_bytes());
+		return hash;
+	}
+
+	void GeometryHeap::free(uint32_t entry)
+	{
+		m_vertexAllocator.free(m_entries[entry].vertices);
+		m_indexAllocator.free(m_entries[entry].indices);
+		m_entries[entry] = Entry {};
+		m_unusedEntries.push_back(entry);
+	}
+
+}
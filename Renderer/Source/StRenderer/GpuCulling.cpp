@@ -0,0 +1,591 @@
+#include "GpuCulling.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace st::renderer
+{
+	namespace
+	{
+		constexpr const char* cullLayoutName = "cull";
+		constexpr const char* cullShaderPath = "Assets/Shaders/cull.spv";
+		constexpr const char* reduceLayoutName = "depthReduce";
+		constexpr const char* reduceShaderPath = "Assets/Shaders/depth_reduce.spv";
+
+		constexpr vk::DeviceSize drawCommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+		constexpr vk::Format pyramidFormat = vk::Format::eR32Sfloat;
+
+		math::Vector4 normalizePlane(const math::Vector4& plane)
+		{
+			const float length = std::sqrt(plane.X * plane.X + plane.Y * plane.Y + plane.Z * plane.Z);
+			return plane * (1.0F / length);
+		}
+	}
+
+	FrustumPlanes extractFrustumPlanes(const math::Matrix4x4& viewProjection)
+	{
+		const auto row = [&viewProjection](size_t index)
+		{
+			return math::Vector4 { viewProjection[index * 4],
+								   viewProjection[index * 4 + 1],
+								   viewProjection[index * 4 + 2],
+								   viewProjection[index * 4 + 3] };
+		};
+
+		const math::Vector4 x = row(0);
+		const math::Vector4 y = row(1);
+		const math::Vector4 z = row(2);
+		const math::Vector4 w = row(3);
+
+		// Gribb-Hartmann, the near plane is z alone because clip space depth starts at 0
+		return FrustumPlanes { normalizePlane(w + x),
+							   normalizePlane(w - x),
+							   normalizePlane(w + y),
+							   normalizePlane(w - y),
+							   normalizePlane(z),
+							   normalizePlane(w - z) };
+	}
+
+	CullView makeCullView(const math::Matrix4x4& view, const math::Matrix4x4& projection)
+	{
+		CullView cullView;
+		cullView.view = view;
+		cullView.view.convertToColumnMajor();
+		cullView.frustumPlanes = extractFrustumPlanes(projection * view);
+
+		cullView.projection[0] = projection[0];
+		cullView.projection[1] = projection[5];
+		cullView.projection[2] = projection[10];
+		cullView.projection[3] = projection[11];
+
+		// P22 = -f / (f - n) and P23 = f * n / (n - f)
+		cullView.nearPlane = projection[11] / projection[10];
+
+		cullView.pyramidWidth = 0;
+		cullView.pyramidHeight = 0;
+		cullView.pyramidLevels = 0;
+
+		return cullView;
+	}
+
+	GpuCulling::~GpuCulling()
+	{
+		shutdown();
+	}
+
+	void GpuCulling::init(vk::Device device,
+						  MemoryAllocator& allocator,
+						  PipelineManager& pipelineManager,
+						  UniformRing& uniformRing,
+						  uint32_t frameCount,
+						  Features features)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_pipelineManager = &pipelineManager;
+		m_uniformRing = &uniformRing;
+		m_features = features;
+
+		createCullResources(frameCount);
+		createPyramidResources();
+
+		m_pipelineManager->registerLayout(cullLayoutName, m_cullLayout);
+		m_pipelineManager->registerLayout(reduceLayoutName, m_reduceLayout);
+		m_cullPipeline = m_pipelineManager->request(ComputePipelineDescription { cullShaderPath, {}, cullLayoutName });
+		m_reducePipeline = m_pipelineManager->request(ComputePipelineDescription { reduceShaderPath, {}, reduceLayoutName });
+	}
+
+	void GpuCulling::shutdown()
+	{
+		if (!m_cullSetLayout)
+		{
+			return;
+		}
+
+		RetiredPyramid pyramid = retirePyramid();
+		destroy(pyramid);
+
+		for (auto& frame : m_frames)
+		{
+			for (auto& retiredPyramid : frame.retiredPyramids)
+			{
+				destroy(retiredPyramid);
+			}
+			destroy(frame.batches);
+			destroy(frame.commands);
+			destroy(frame.counts);
+			destroy(frame.visibility);
+			destroy(frame.retiredVisibility);
+		}
+		m_frames.clear();
+		m_historyFrame.reset();
+
+		m_device.destroySampler(m_pyramidSampler);
+
+		m_device.destroyPipelineLayout(m_reduceLayout);
+		m_device.destroyDescriptorPool(m_reduceDescriptorPool);
+		m_device.destroyDescriptorSetLayout(m_reduceSetLayout);
+
+		m_device.destroyPipelineLayout(m_cullLayout);
+		m_device.destroyDescriptorSetLayout(m_cullSetLayout);
+		m_cullSetLayout = nullptr;
+	}
+
+	void GpuCulling::resize(vk::ImageView depthView, vk::Extent2D extent, uint32_t frameIndex)
+	{
+		if (extent.width == 0 || extent.height == 0)
+		{
+			throw std::invalid_argument("depth pyramid needs a non-zero extent!");
+		}
+
+		// Frames still in flight reduce into the old pyramid
+		if (m_pyramidImage)
+		{
+			m_frames.at(frameIndex).retiredPyramids.push_back(retirePyramid());
+		}
+
+		m_depthView = depthView;
+		m_depthExtent = extent;
+
+		// Power of two levels keep every reduction after the first an exact 2x2 footprint
+		const vk::Extent2D pyramidExtent { std::bit_floor(extent.width), std::bit_floor(extent.height) };
+		const uint32_t levelCount = std::min(static_cast<uint32_t>(std::bit_width(std::max(pyramidExtent.width, pyramidExtent.height))), maxPyramidLevels);
+
+		const vk::ImageCreateInfo imageInfo { {},
+											  vk::ImageType::e2D,
+											  pyramidFormat,
+											  { pyramidExtent.width, pyramidExtent.height, 1 },
+											  levelCount,
+											  1,
+											  vk::SampleCountFlagBits::e1,
+											  vk::ImageTiling::eOptimal,
+											  vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+											  vk::SharingMode::eExclusive,
+											  {},
+											  vk::ImageLayout::eUndefined };
+
+		m_pyramidImage = m_device.createImage(imageInfo);
+		m_pyramidMemory = m_allocator->allocateForImage(m_pyramidImage, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		m_device.bindImageMemory(m_pyramidImage, m_pyramidMemory.memory, m_pyramidMemory.offset);
+
+		m_pyramidView = m_device.createImageView(vk::ImageViewCreateInfo { {},
+																		   m_pyramidImage,
+																		   vk::ImageViewType::e2D,
+																		   pyramidFormat,
+																		   {},
+																		   { vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1 } });
+
+		const std::vector<vk::DescriptorSetLayout> layouts(levelCount, m_reduceSetLayout);
+		const std::vector<vk::DescriptorSet> descriptorSets = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo { m_reduceDescriptorPool, layouts });
+
+		m_pyramidLevels.reserve(levelCount);
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			PyramidLevel& pyramidLevel = m_pyramidLevels.emplace_back();
+			pyramidLevel.descriptorSet = descriptorSets[level];
+			pyramidLevel.extent = vk::Extent2D { std::max(pyramidExtent.width >> level, 1U), std::max(pyramidExtent.height >> level, 1U) };
+			pyramidLevel.view = m_device.createImageView(vk::ImageViewCreateInfo { {},
+																				   m_pyramidImage,
+																				   vk::ImageViewType::e2D,
+																				   pyramidFormat,
+																				   {},
+																				   { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 } });
+
+			// Level 0 reduces the depth attachment, every other level the one above it
+			const vk::DescriptorImageInfo sourceInfo = level == 0
+														   ? vk::DescriptorImageInfo { m_pyramidSampler, m_depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal }
+														   : vk::DescriptorImageInfo { m_pyramidSampler, m_pyramidLevels[level - 1].view, vk::ImageLayout::eGeneral };
+			const vk::DescriptorImageInfo destinationInfo { {}, pyramidLevel.view, vk::ImageLayout::eGeneral };
+
+			const std::array<vk::WriteDescriptorSet, 2> writes {
+				vk::WriteDescriptorSet { pyramidLevel.descriptorSet, 0, 0, vk::DescriptorType::eCombinedImageSampler, sourceInfo, {}, {} },
+				vk::WriteDescriptorSet { pyramidLevel.descriptorSet, 1, 0, vk::DescriptorType::eStorageImage, destinationInfo, {}, {} }
+			};
+
+			m_device.updateDescriptorSets(writes, {});
+		}
+
+		// History was culled against a different pyramid
+		m_historyFrame.reset();
+	}
+
+	void GpuCulling::beginFrame(uint32_t frameIndex)
+	{
+		for (auto& pyramid : m_frames.at(frameIndex).retiredPyramids)
+		{
+			destroy(pyramid);
+		}
+		m_frames.at(frameIndex).retiredPyramids.clear();
+	}
+
+	bool GpuCulling::isReady() const
+	{
+		return m_pipelineManager != nullptr && m_pyramidImage && m_pipelineManager->isReady(m_cullPipeline) &&
+			   m_pipelineManager->isReady(m_reducePipeline);
+	}
+
+	void GpuCulling::prepare(uint32_t frameIndex,
+							 vk::Buffer instanceBuffer,
+							 std::span<const MeshDraw> draws,
+							 std::span<const GpuMesh> meshes,
+							 uint32_t instanceCount,
+							 DescriptorAllocator& frameDescriptors,
+							 CullView view)
+	{
+		Frame& frame = m_frames.at(frameIndex);
+		frame.instanceCount = instanceCount;
+		frame.drawCount = static_cast<uint32_t>(draws.size());
+
+		// The frame that read it as history has completed, its fence was waited on
+		destroy(frame.retiredVisibility);
+
+		if (draws.empty())
+		{
+			return;
+		}
+
+		const vk::BufferUsageFlags indirectUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+												   vk::BufferUsageFlagBits::eTransferDst;
+
+		ensureCapacity(frame.batches, draws.size() * sizeof(CullBatch), vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible);
+		ensureCapacity(frame.commands, 2 * instanceCount * drawCommandStride, indirectUsage, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		ensureCapacity(frame.counts, 2 * draws.size() * sizeof(uint32_t), indirectUsage, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+		if (frame.visibility.capacity < instanceCount * sizeof(uint32_t))
+		{
+			frame.retiredVisibility = frame.visibility;
+			frame.visibility = FrameBuffer {};
+			ensureCapacity(frame.visibility, instanceCount * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		}
+
+		auto* batches = static_cast<CullBatch*>(frame.batches.memory.mappedData);
+		for (const auto& draw : draws)
+		{
+			const GpuMesh& mesh = meshes[draw.mesh];
+			*batches++ = CullBatch { mesh.boundingSphere,
+									 mesh.geometry.indexCount,
+									 draw.firstInstance,
+									 draw.instanceCount,
+									 mesh.geometry.firstIndex,
+									 mesh.geometry.vertexOffset };
+		}
+		m_allocator->flush(frame.batches.memory, 0, draws.size() * sizeof(CullBatch));
+
+		if (!m_pyramidLevels.empty())
+		{
+			view.pyramidWidth = m_pyramidLevels.front().extent.width;
+			view.pyramidHeight = m_pyramidLevels.front().extent.height;
+			view.pyramidLevels = static_cast<uint32_t>(m_pyramidLevels.size());
+		}
+
+		frame.viewOffset = m_uniformRing->push(view);
+		m_uniformRing->flush();
+
+		// Without a history every instance goes through the late phase. With a single slot in
+		// rotation the history is the slot's own visibility, its fence was waited on and each
+		// instance reads its entry before the late phase overwrites it. A buffer replaced above
+		// still holds it until the next prepare of the slot.
+		vk::Buffer historyBuffer;
+		if (m_historyFrame && *m_historyFrame == frameIndex)
+		{
+			historyBuffer = frame.retiredVisibility.buffer ? frame.retiredVisibility.buffer : frame.visibility.buffer;
+		}
+		else if (m_historyFrame)
+		{
+			historyBuffer = m_frames.at(*m_historyFrame).visibility.buffer;
+		}
+		frame.historyCount = historyBuffer ? std::min(m_historyInstanceCount, instanceCount) : 0;
+		if (!historyBuffer)
+		{
+			historyBuffer = frame.visibility.buffer;
+		}
+
+		// Buffers may have been reallocated, a fresh transient set is cheaper than tracking it
+		frame.descriptorSet = frameDescriptors.allocate(m_cullSetLayout);
+
+		const std::array<vk::DescriptorBufferInfo, 6> bufferInfos { vk::DescriptorBufferInfo { instanceBuffer, 0, VK_WHOLE_SIZE },
+																	vk::DescriptorBufferInfo { frame.batches.buffer, 0, VK_WHOLE_SIZE },
+																	vk::DescriptorBufferInfo { frame.commands.buffer, 0, VK_WHOLE_SIZE },
+																	vk::DescriptorBufferInfo { frame.counts.buffer, 0, VK_WHOLE_SIZE },
+																	vk::DescriptorBufferInfo { historyBuffer, 0, VK_WHOLE_SIZE },
+																	vk::DescriptorBufferInfo { frame.visibility.buffer, 0, VK_WHOLE_SIZE } };
+
+		const vk::DescriptorBufferInfo viewInfo { m_uniformRing->getBuffer(), 0, sizeof(CullView) };
+		const vk::DescriptorImageInfo pyramidInfo { m_pyramidSampler, m_pyramidView, vk::ImageLayout::eGeneral };
+
+		// The storage buffers, the view and the pyramid, rewritten every frame
+		std::array<vk::WriteDescriptorSet, 8> writes;
+		uint32_t writeCount = 0;
+		for (uint32_t binding = 0; binding < bufferInfos.size(); ++binding)
+		{
+			writes[writeCount++] = vk::WriteDescriptorSet { frame.descriptorSet, binding, 0, vk::DescriptorType::eStorageBuffer, {}, bufferInfos[binding], {} };
+		}
+		writes[writeCount++] = vk::WriteDescriptorSet { frame.descriptorSet, 6, 0, vk::DescriptorType::eUniformBufferDynamic, {}, viewInfo, {} };
+		if (m_pyramidView)
+		{
+			writes[writeCount++] = vk::WriteDescriptorSet { frame.descriptorSet, 7, 0, vk::DescriptorType::eCombinedImageSampler, pyramidInfo, {}, {} };
+		}
+
+		m_device.updateDescriptorSets(vk::ArrayProxy<const vk::WriteDescriptorSet> { writeCount, writes.data() }, {});
+	}
+
+	void GpuCulling::recordCulling(vk::CommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase)
+	{
+		const Frame& frame = m_frames.at(frameIndex);
+		if (frame.drawCount == 0)
+		{
+			return;
+		}
+
+		if (phase == CullPhase::eEarly)
+		{
+			commandBuffer.fillBuffer(frame.counts.buffer, 0, 2 * frame.drawCount * sizeof(uint32_t), 0);
+			if (!m_features.drawIndirectCount)
+			{
+				// Without a count buffer every slot of a draw is consumed, culled slots draw zero instances
+				commandBuffer.fillBuffer(frame.commands.buffer, 0, 2 * frame.instanceCount * drawCommandStride, 0);
+			}
+
+			// Also orders the history reads after the late phase of the previous frame
+			const vk::MemoryBarrier clearBarrier { vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite,
+												   vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+										  vk::PipelineStageFlagBits::eComputeShader,
+										  {},
+										  clearBarrier,
+										  {},
+										  {});
+		}
+
+		const CullConstants constants { frame.instanceCount, frame.drawCount, frame.historyCount, phase };
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipelineManager->getPipeline(m_cullPipeline));
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_cullLayout, 0, frame.descriptorSet, frame.viewOffset);
+		commandBuffer.pushConstants(m_cullLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullConstants), &constants);
+		commandBuffer.dispatch((frame.instanceCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+		const vk::MemoryBarrier cullBarrier { vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, cullBarrier, {}, {});
+
+		if (phase == CullPhase::eLate)
+		{
+			m_historyFrame = frameIndex;
+			m_historyInstanceCount = frame.instanceCount;
+		}
+	}
+
+	void GpuCulling::recordDepthPyramid(vk::CommandBuffer commandBuffer) const
+	{
+		const uint32_t levelCount = static_cast<uint32_t>(m_pyramidLevels.size());
+
+		// Contents are rebuilt, the previous frame's late phase only has to be done reading them
+		const vk::ImageMemoryBarrier toGeneral { {},
+												 vk::AccessFlagBits::eShaderWrite,
+												 vk::ImageLayout::eUndefined,
+												 vk::ImageLayout::eGeneral,
+												 VK_QUEUE_FAMILY_IGNORED,
+												 VK_QUEUE_FAMILY_IGNORED,
+												 m_pyramidImage,
+												 { vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1 } };
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, toGeneral);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipelineManager->getPipeline(m_reducePipeline));
+
+		vk::Extent2D sourceExtent = m_depthExtent;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			const PyramidLevel& pyramidLevel = m_pyramidLevels[level];
+
+			const ReduceConstants constants { static_cast<int32_t>(sourceExtent.width),
+											  static_cast<int32_t>(sourceExtent.height),
+											  static_cast<int32_t>(pyramidLevel.extent.width),
+											  static_cast<int32_t>(pyramidLevel.extent.height) };
+
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_reduceLayout, 0, pyramidLevel.descriptorSet, {});
+			commandBuffer.pushConstants(m_reduceLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(ReduceConstants), &constants);
+			commandBuffer.dispatch((pyramidLevel.extent.width + reduceWorkgroupSize - 1) / reduceWorkgroupSize,
+								   (pyramidLevel.extent.height + reduceWorkgroupSize - 1) / reduceWorkgroupSize,
+								   1);
+
+			// Next level and the late phase read what was just written
+			const vk::ImageMemoryBarrier levelBarrier { vk::AccessFlagBits::eShaderWrite,
+													   vk::AccessFlagBits::eShaderRead,
+													   vk::ImageLayout::eGeneral,
+													   vk::ImageLayout::eGeneral,
+													   VK_QUEUE_FAMILY_IGNORED,
+													   VK_QUEUE_FAMILY_IGNORED,
+													   m_pyramidImage,
+													   { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 } };
+
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, levelBarrier);
+
+			sourceExtent = pyramidLevel.extent;
+		}
+	}
+
+	void GpuCulling::recordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase, std::span<const MeshDraw> draws) const
+	{
+		const Frame& frame = m_frames.at(frameIndex);
+
+		// The commands carry the geometry heap offsets of their mesh, nothing is bound per draw
+		for (uint32_t drawIndex = 0; drawIndex < draws.size(); ++drawIndex)
+		{
+			const MeshDraw& draw = draws[drawIndex];
+
+			const vk::DeviceSize commandOffset = commandBase(frame, phase) + draw.firstInstance * drawCommandStride;
+
+			if (m_features.drawIndirectCount)
+			{
+				commandBuffer.drawIndexedIndirectCount(frame.commands.buffer,
+													   commandOffset,
+													   frame.counts.buffer,
+													   countBase(frame, phase) + drawIndex * sizeof(uint32_t),
+													   draw.instanceCount,
+													   drawCommandStride);
+			}
+			else if (m_features.multiDrawIndirect)
+			{
+				commandBuffer.drawIndexedIndirect(frame.commands.buffer, commandOffset, draw.instanceCount, drawCommandStride);
+			}
+			else
+			{
+				// drawCount is limited to 1, the CPU pays per instance on these devices only
+				for (uint32_t slot = 0; slot < draw.instanceCount; ++slot)
+				{
+					commandBuffer.drawIndexedIndirect(frame.commands.buffer, commandOffset + slot * drawCommandStride, 1, drawCommandStride);
+				}
+			}
+		}
+	}
+
+	void GpuCulling::createCullResources(uint32_t frameCount)
+	{
+		// 0 instances, 1 batches, 2 commands, 3 counts, 4 history, 5 visibility, 6 view, 7 depth pyramid
+		std::array<vk::DescriptorSetLayoutBinding, 8> bindings;
+		for (uint32_t binding = 0; binding < 6; ++binding)
+		{
+			bindings[binding] = vk::DescriptorSetLayoutBinding { binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute };
+		}
+		bindings[6] = vk::DescriptorSetLayoutBinding { 6, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eCompute };
+		bindings[7] = vk::DescriptorSetLayoutBinding { 7, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute };
+
+		m_cullSetLayout = m_device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo { {}, bindings });
+
+		const vk::PushConstantRange pushConstantRange { vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullConstants) };
+		m_cullLayout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo { {}, m_cullSetLayout, pushConstantRange });
+
+		m_frames.resize(frameCount);
+	}
+
+	void GpuCulling::createPyramidResources()
+	{
+		const std::array<vk::DescriptorSetLayoutBinding, 2> bindings {
+			vk::DescriptorSetLayoutBinding { 0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute },
+			vk::DescriptorSetLayoutBinding { 1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute }
+		};
+
+		m_reduceSetLayout = m_device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo { {}, bindings });
+
+		// Room for the live pyramid and two retired ones per frame, a resize at acquire and one at present
+		const uint32_t maxSets = maxPyramidLevels * (2 * static_cast<uint32_t>(m_frames.size()) + 1);
+		const std::array<vk::DescriptorPoolSize, 2> poolSizes { vk::DescriptorPoolSize { vk::DescriptorType::eCombinedImageSampler, maxSets },
+																vk::DescriptorPoolSize { vk::DescriptorType::eStorageImage, maxSets } };
+		m_reduceDescriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo { vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+																							  maxSets,
+																							  poolSizes });
+
+		const vk::PushConstantRange pushConstantRange { vk::ShaderStageFlagBits::eCompute, 0, sizeof(ReduceConstants) };
+		m_reduceLayout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo { {}, m_reduceSetLayout, pushConstantRange });
+
+		// Texels are fetched explicitly, the sampler only has to exist
+		m_pyramidSampler = m_device.createSampler(vk::SamplerCreateInfo { {},
+																		  vk::Filter::eNearest,
+																		  vk::Filter::eNearest,
+																		  vk::SamplerMipmapMode::eNearest,
+																		  vk::SamplerAddressMode::eClampToEdge,
+																		  vk::SamplerAddressMode::eClampToEdge,
+																		  vk::SamplerAddressMode::eClampToEdge,
+																		  0.0F,
+																		  VK_FALSE,
+																		  1.0F,
+																		  VK_FALSE,
+																		  vk::CompareOp::eNever,
+																		  0.0F,
+																		  VK_LOD_CLAMP_NONE });
+	}
+
+	GpuCulling::RetiredPyramid GpuCulling::retirePyramid()
+	{
+		RetiredPyramid pyramid { m_pyramidImage, m_pyramidMemory, m_pyramidView, std::move(m_pyramidLevels) };
+		m_pyramidLevels.clear();
+		m_pyramidImage = nullptr;
+		m_pyramidMemory = MemoryAllocation {};
+		m_pyramidView = nullptr;
+		return pyramid;
+	}
+
+	void GpuCulling::destroy(RetiredPyramid& pyramid)
+	{
+		if (!pyramid.image)
+		{
+			return;
+		}
+
+		for (auto& level : pyramid.levels)
+		{
+			m_device.destroyImageView(level.view);
+			m_device.freeDescriptorSets(m_reduceDescriptorPool, level.descriptorSet);
+		}
+		pyramid.levels.clear();
+
+		m_device.destroyImageView(pyramid.view);
+		m_device.destroyImage(pyramid.image);
+		m_allocator->free(pyramid.memory);
+		pyramid.view = nullptr;
+		pyramid.image = nullptr;
+	}
+
+	void GpuCulling::ensureCapacity(FrameBuffer& frameBuffer, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties)
+	{
+		if (frameBuffer.capacity >= size)
+		{
+			return;
+		}
+
+		// The fence of the frame was waited on, its buffers can be replaced
+		destroy(frameBuffer);
+
+		frameBuffer.capacity = std::max(size, 2 * frameBuffer.capacity);
+		frameBuffer.buffer = m_device.createBuffer(vk::BufferCreateInfo { {}, frameBuffer.capacity, usage, vk::SharingMode::eExclusive });
+		frameBuffer.memory = m_allocator->allocateForBuffer(frameBuffer.buffer, properties);
+		m_device.bindBufferMemory(frameBuffer.buffer, frameBuffer.memory.memory, frameBuffer.memory.offset);
+	}
+
+	void GpuCulling::destroy(FrameBuffer& frameBuffer)
+	{
+		if (!frameBuffer.buffer)
+		{
+			return;
+		}
+
+		m_device.destroyBuffer(frameBuffer.buffer);
+		m_allocator->free(frameBuffer.memory);
+		frameBuffer.buffer = nullptr;
+		frameBuffer.capacity = 0;
+	}
+
+	vk::DeviceSize GpuCulling::commandBase(const Frame& frame, CullPhase phase) const
+	{
+		return phase == CullPhase::eLate ? frame.instanceCount * drawCommandStride : 0;
+	}
+
+	vk::DeviceSize GpuCulling::countBase(const Frame& frame, CullPhase phase) const
+	{
+		return phase == CullPhase::eLate ? frame.drawCount * sizeof(uint32_t) : 0;
+	}
+
+}
@@ -0,0 +1,362 @@
+#include "MemoryAllocator.hpp"
+
+#include <algorithm>
+
+namespace st::renderer
+{
+	namespace
+	{
+		vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		vk::DeviceSize alignDown(vk::DeviceSize value, vk::DeviceSize alignment)
+		{
+			return value & ~(alignment - 1);
+		}
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		shutdown();
+	}
+
+	void MemoryAllocator::init(vk::PhysicalDevice physicalDevice, vk::Device device, bool memoryBudget, vk::DeviceSize blockSize)
+	{
+		m_physicalDevice = physicalDevice;
+		m_device = device;
+		m_blockSize = blockSize;
+		m_memoryBudget = memoryBudget;
+
+		m_memoryProperties = m_physicalDevice.getMemoryProperties();
+		m_nonCoherentAtomSize = std::max<vk::DeviceSize>(m_physicalDevice.getProperties().limits.nonCoherentAtomSize, 1);
+
+		m_memoryTypes.resize(m_memoryProperties.memoryTypeCount);
+	}
+
+	void MemoryAllocator::shutdown()
+	{
+		if (!m_device)
+		{
+			return;
+		}
+
+		std::scoped_lock lock(m_mutex);
+
+		for (auto& memoryType : m_memoryTypes)
+		{
+			for (auto& blocks : memoryType.blocks)
+			{
+				for (auto& block : blocks)
+				{
+					if (block)
+					{
+						freeDeviceMemory(block->memory, block->mappedData);
+					}
+				}
+				blocks.clear();
+			}
+		}
+
+		m_memoryTypes.clear();
+		m_device = nullptr;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateForBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties)
+	{
+		const auto requirements = m_device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::BufferMemoryRequirementsInfo2 { buffer });
+		const auto& dedicatedRequirements = requirements.get<vk::MemoryDedicatedRequirements>();
+
+		return allocate(requirements.get<vk::MemoryRequirements2>().memoryRequirements,
+						properties,
+						ResourceKind::eLinear,
+						dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation,
+						buffer,
+						{});
+	}
+
+	MemoryAllocation MemoryAllocator::allocateForImage(vk::Image image, vk::MemoryPropertyFlags properties)
+	{
+		const auto requirements = m_device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::ImageMemoryRequirementsInfo2 { image });
+		const auto& dedicatedRequirements = requirements.get<vk::MemoryDedicatedRequirements>();
+
+		// Only optimal tiled images are created by the renderer
+		return allocate(requirements.get<vk::MemoryRequirements2>().memoryRequirements,
+						properties,
+						ResourceKind::eOptimal,
+						dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation,
+						{},
+						image);
+	}
+
+	MemoryAllocation MemoryAllocator::allocateAliased(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties)
+	{
+		// Never dedicated, the memory is bound to more than one image
+		return allocate(requirements, properties, ResourceKind::eOptimal, false, {}, {});
+	}
+
+	void MemoryAllocator::free(MemoryAllocation& allocation)
+	{
+		switch (allocation.kind)
+		{
+		case MemoryAllocation::Kind::eBlock:
+		{
+			std::scoped_lock lock(m_mutex);
+
+			auto& blocks = m_memoryTypes.at(allocation.memoryType).blocks.at(allocation.blockList);
+			auto& block = blocks.at(allocation.block);
+			block->allocator.free(allocation.subAllocation);
+
+			if (block->allocator.isEmpty())
+			{
+				// Keep one empty block per list so a free/allocate pattern does not thrash vkAllocateMemory
+				const auto liveBlocks = std::count_if(blocks.begin(), blocks.end(), [](const auto& b) { return b != nullptr; });
+				if (liveBlocks > 1)
+				{
+					freeDeviceMemory(block->memory, block->mappedData);
+					block.reset();
+				}
+			}
+			break;
+		}
+		case MemoryAllocation::Kind::eDedicated:
+		{
+			std::scoped_lock lock(m_mutex);
+
+			freeDeviceMemory(allocation.memory, allocation.mappedData);
+			--m_dedicatedAllocationCount;
+			m_dedicatedBytes -= allocation.size;
+			break;
+		}
+		case MemoryAllocation::Kind::eNone:
+			break;
+		}
+
+		allocation = MemoryAllocation {};
+	}
+
+	void MemoryAllocator::flush(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+	{
+		if (isCoherent(allocation))
+		{
+			return;
+		}
+
+		// Allocations in non-coherent memory start and end on an atom boundary, dedicated ones
+		// included, so the rounded range never leaves them
+		const vk::DeviceSize end = size == VK_WHOLE_SIZE ? allocation.size : std::min(offset + size, allocation.size);
+		const vk::DeviceSize rangeBegin = alignDown(allocation.offset + offset, m_nonCoherentAtomSize);
+		const vk::DeviceSize rangeEnd = alignUp(allocation.offset + end, m_nonCoherentAtomSize);
+
+		m_device.flushMappedMemoryRanges(vk::MappedMemoryRange { allocation.memory, rangeBegin, rangeEnd - rangeBegin });
+	}
+
+	bool MemoryAllocator::isCoherent(const MemoryAllocation& allocation) const
+	{
+		return static_cast<bool>(m_memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+	}
+
+	uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	MemoryStatistics MemoryAllocator::getStatistics() const
+	{
+		std::scoped_lock lock(m_mutex);
+
+		MemoryStatistics statistics;
+		statistics.deviceMemoryCount = m_deviceMemoryCount;
+		statistics.dedicatedAllocationCount = m_dedicatedAllocationCount;
+		statistics.dedicatedBytes = m_dedicatedBytes;
+		statistics.allocationCount = m_dedicatedAllocationCount;
+
+		for (const auto& memoryType : m_memoryTypes)
+		{
+			for (const auto& blocks : memoryType.blocks)
+			{
+				for (const auto& block : blocks)
+				{
+					if (block)
+					{
+						++statistics.blockCount;
+						statistics.blockBytes += block->allocator.getSize();
+						statistics.blockUsedBytes += block->allocator.getUsedSize();
+						statistics.allocationCount += block->allocator.getAllocationCount();
+					}
+				}
+			}
+		}
+
+		if (m_memoryBudget)
+		{
+			const auto memoryProperties =
+				m_physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+			const auto& budget = memoryProperties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+			for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; ++i)
+			{
+				if (m_memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+				{
+					statistics.deviceLocalBudget += budget.heapBudget[i];
+					statistics.deviceLocalUsage += budget.heapUsage[i];
+				}
+			}
+		}
+
+		return statistics;
+	}
+
+	MemoryAllocation MemoryAllocator::allocate(const vk::MemoryRequirements& requirements,
+											   vk::MemoryPropertyFlags properties,
+											   ResourceKind resourceKind,
+											   bool dedicated,
+											   vk::Buffer buffer,
+											   vk::Image image)
+	{
+		const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+
+		// Small heaps (integrated and mobile GPUs) get smaller blocks
+		const vk::DeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex].size;
+		const vk::DeviceSize blockSize = std::min(m_blockSize, std::max<vk::DeviceSize>(heapSize / 8, 1024 * 1024));
+
+		if (dedicated || requirements.size > blockSize / 2)
+		{
+			return allocateDedicated(requirements, memoryType, buffer, image);
+		}
+
+		const vk::DeviceSize alignment = requiredAlignment(requirements, memoryType);
+		const vk::DeviceSize size = alignUp(requirements.size, alignment);
+		const uint32_t blockList = static_cast<uint32_t>(resourceKind);
+
+		std::scoped_lock lock(m_mutex);
+
+		auto& blocks = m_memoryTypes.at(memoryType).blocks.at(blockList);
+
+		MemoryAllocation allocation;
+		allocation.memoryType = memoryType;
+		allocation.kind = MemoryAllocation::Kind::eBlock;
+		allocation.blockList = blockList;
+
+		for (uint32_t i = 0; i < blocks.size(); ++i)
+		{
+			if (!blocks[i])
+			{
+				continue;
+			}
+
+			const TlsfAllocator::Allocation subAllocation = blocks[i]->allocator.allocate(size, alignment);
+			if (subAllocation.isValid())
+			{
+				allocation.memory = blocks[i]->memory;
+				allocation.offset = subAllocation.offset;
+				allocation.size = size;
+				allocation.mappedData = blocks[i]->mappedData ? static_cast<std::byte*>(blocks[i]->mappedData) + subAllocation.offset : nullptr;
+				allocation.block = i;
+				allocation.subAllocation = subAllocation;
+				return allocation;
+			}
+		}
+
+		auto block = std::make_unique<Block>();
+		block->memory = allocateDeviceMemory(blockSize, memoryType, nullptr, block->mappedData);
+		block->allocator.reset(blockSize);
+
+		const TlsfAllocator::Allocation subAllocation = block->allocator.allocate(size, alignment);
+
+		allocation.memory = block->memory;
+		allocation.offset = subAllocation.offset;
+		allocation.size = size;
+		allocation.mappedData = block->mappedData ? static_cast<std::byte*>(block->mappedData) + subAllocation.offset : nullptr;
+		allocation.subAllocation = subAllocation;
+
+		const auto freeSlot = std::find(blocks.begin(), blocks.end(), nullptr);
+		allocation.block = static_cast<uint32_t>(std::distance(blocks.begin(), freeSlot));
+		if (freeSlot != blocks.end())
+		{
+			*freeSlot = std::move(block);
+		}
+		else
+		{
+			blocks.push_back(std::move(block));
+		}
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memoryType, vk::Buffer buffer, vk::Image image)
+	{
+		vk::MemoryDedicatedAllocateInfo dedicatedInfo { image, buffer };
+
+		// Rounded like block allocations, a flush of the last bytes must not pass the end of the memory
+		const vk::DeviceSize size = alignUp(requirements.size, requiredAlignment(requirements, memoryType));
+
+		std::scoped_lock lock(m_mutex);
+
+		MemoryAllocation allocation;
+		allocation.memory = allocateDeviceMemory(size, memoryType, &dedicatedInfo, allocation.mappedData);
+		allocation.offset = 0;
+		allocation.size = size;
+		allocation.memoryType = memoryType;
+		allocation.kind = MemoryAllocation::Kind::eDedicated;
+
+		++m_dedicatedAllocationCount;
+		m_dedicatedBytes += allocation.size;
+
+		return allocation;
+	}
+
+	vk::DeviceMemory MemoryAllocator::allocateDeviceMemory(vk::DeviceSize size, uint32_t memoryType, const void* pNext, void*& mappedData)
+	{
+		vk::MemoryAllocateInfo allocInfo { size, memoryType };
+		allocInfo.setPNext(pNext);
+
+		vk::DeviceMemory memory = m_device.allocateMemory(allocInfo);
+		++m_deviceMemoryCount;
+
+		// Host visible memory stays mapped for its whole lifetime
+		mappedData = isHostVisible(memoryType) ? m_device.mapMemory(memory, 0, VK_WHOLE_SIZE) : nullptr;
+
+		return memory;
+	}
+
+	void MemoryAllocator::freeDeviceMemory(vk::DeviceMemory memory, void* mappedData)
+	{
+		if (mappedData)
+		{
+			m_device.unmapMemory(memory);
+		}
+
+		m_device.freeMemory(memory);
+		--m_deviceMemoryCount;
+	}
+
+	vk::DeviceSize MemoryAllocator::requiredAlignment(const vk::MemoryRequirements& requirements, uint32_t memoryType) const
+	{
+		vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+
+		const vk::MemoryPropertyFlags flags = m_memoryProperties.memoryTypes[memoryType].propertyFlags;
+		if ((flags & vk::MemoryPropertyFlagBits::eHostVisible) && !(flags & vk::MemoryPropertyFlagBits::eHostCoherent))
+		{
+			// Flushed ranges are rounded to the atom size and must not spill into a neighbour
+			alignment = std::max(alignment, m_nonCoherentAtomSize);
+		}
+
+		return alignment;
+	}
+
+	bool MemoryAllocator::isHostVisible(uint32_t memoryType) const
+	{
+		return static_cast<bool>(m_memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+	}
+
+}
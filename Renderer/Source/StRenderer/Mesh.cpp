@@ -0,0 +1,92 @@
+#include "Mesh.hpp"
+
+namespace st::renderer
+{
+	vk::VertexInputBindingDescription Vertex::getBindingDescription()
+	{
+		vk::VertexInputBindingDescription bindingDescription{
+			0,
+			sizeof(Vertex),
+			vk::VertexInputRate::eVertex};
+
+		return bindingDescription;
+	}
+
+	std::array<vk::VertexInputAttributeDescription, 4> Vertex::getAttributeDescriptions()
+	{
+		std::array<vk::VertexInputAttributeDescription, 4> attributeDescriptions{
+			vk::VertexInputAttributeDescription{
+				0,
+				0,
+				vk::Format::eR32G32B32Sfloat,
+				static_cast<uint32_t>(offsetof(Vertex, m_pos))},
+			vk::VertexInputAttributeDescription{
+				1,
+				0,
+				vk::Format::eR32G32Sfloat,
+				static_cast<uint32_t>(offsetof(Vertex, m_texCoord))},
+			vk::VertexInputAttributeDescription{
+				2,
+				0,
+				vk::Format::eR32G32B32Sfloat,
+				static_cast<uint32_t>(offsetof(Vertex, m_color))},
+			vk::VertexInputAttributeDescription{
+				3,
+				0,
+				vk::Format::eR32G32B32Sfloat,
+				static_cast<uint32_t>(offsetof(Vertex, m_normal))}};
+
+		return attributeDescriptions;
+	}
+
+	vk::VertexInputBindingDescription InstanceData::getBindingDescription()
+	{
+		vk::VertexInputBindingDescription bindingDescription{
+			1,
+			sizeof(InstanceData),
+			vk::VertexInputRate::eInstance};
+
+		return bindingDescription;
+	}
+
+	std::array<vk::VertexInputAttributeDescription, 6> InstanceData::getAttributeDescriptions()
+	{
+		// A mat4 attribute takes four consecutive locations, one per column
+		constexpr uint32_t columnSize = 4 * sizeof(float);
+
+		std::array<vk::VertexInputAttributeDescription, 6> attributeDescriptions{
+			vk::VertexInputAttributeDescription{
+				4,
+				1,
+				vk::Format::eR32G32B32A32Sfloat,
+				static_cast<uint32_t>(offsetof(InstanceData, m_model))},
+			vk::VertexInputAttributeDescription{
+				5,
+				1,
+				vk::Format::eR32G32B32A32Sfloat,
+				static_cast<uint32_t>(offsetof(InstanceData, m_model)) + columnSize},
+			vk::VertexInputAttributeDescription{
+				6,
+				1,
+				vk::Format::eR32G32B32A32Sfloat,
+				static_cast<uint32_t>(offsetof(InstanceData, m_model)) + 2 * columnSize},
+			vk::VertexInputAttributeDescription{
+				7,
+				1,
+				vk::Format::eR32G32B32A32Sfloat,
+				static_cast<uint32_t>(offsetof(InstanceData, m_model)) + 3 * columnSize},
+			vk::VertexInputAttributeDescription{
+				8,
+				1,
+				vk::Format::eR32G32B32A32Sfloat,
+				static_cast<uint32_t>(offsetof(InstanceData, m_color))},
+			vk::VertexInputAttributeDescription{
+				9,
+				1,
+				vk::Format::eR32Uint,
+				static_cast<uint32_t>(offsetof(InstanceData, m_materialIndex))}};
+
+		return attributeDescriptions;
+	}
+
+}
@@ -0,0 +1,141 @@
+#include "ParallelRecorder.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
+namespace st::renderer
+{
+	namespace
+	{
+		// Below this a worker spends more time waking up and beginning its buffer than recording
+		constexpr uint32_t minItemsPerRange = 128;
+	}
+
+	ParallelRecorder::~ParallelRecorder()
+	{
+		shutdown();
+	}
+
+	void ParallelRecorder::init(vk::Device device, uint32_t queueFamilyIndex, uint32_t frameCount, st::core::JobSystem& jobSystem)
+	{
+		m_device = device;
+		m_jobSystem = &jobSystem;
+
+		// Buffers are never reset one by one, the pools do without eResetCommandBuffer
+		const vk::CommandPoolCreateInfo poolInfo { vk::CommandPoolCreateFlagBits::eTransient, queueFamilyIndex };
+
+		m_pools.resize(frameCount);
+		for (auto& framePools : m_pools)
+		{
+			framePools.resize(getWorkerCount());
+			for (auto& pool : framePools)
+			{
+				pool.commandPool = m_device.createCommandPool(poolInfo);
+			}
+		}
+	}
+
+	void ParallelRecorder::shutdown()
+	{
+		if (!m_jobSystem)
+		{
+			return;
+		}
+
+		m_jobSystem = nullptr;
+
+		// Destroying a pool frees its command buffers
+		for (auto& framePools : m_pools)
+		{
+			for (auto& pool : framePools)
+			{
+				m_device.destroyCommandPool(pool.commandPool);
+			}
+		}
+		m_pools.clear();
+	}
+
+	void ParallelRecorder::beginFrame(uint32_t frameIndex)
+	{
+		for (auto& pool : m_pools.at(frameIndex))
+		{
+			if (pool.used != 0)
+			{
+				m_device.resetCommandPool(pool.commandPool);
+				pool.used = 0;
+			}
+		}
+	}
+
+	std::pmr::vector<vk::CommandBuffer> ParallelRecorder::record(uint32_t frameIndex,
+																 const vk::CommandBufferInheritanceInfo& inheritance,
+																 uint32_t itemCount,
+																 const RecordCallback& callback,
+																 std::pmr::memory_resource* memory)
+	{
+		auto& framePools = m_pools.at(frameIndex);
+
+		const uint32_t rangeCount = std::clamp((itemCount + minItemsPerRange - 1) / minItemsPerRange, 1U, getWorkerCount());
+		std::pmr::vector<vk::CommandBuffer> commandBuffers(rangeCount, memory);
+
+		const vk::CommandBufferBeginInfo beginInfo { vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+													 &inheritance };
+
+		// A job must not throw, the first error is rethrown once every range has finished
+		std::mutex errorMutex;
+		std::exception_ptr error;
+
+		// Range i only touches pool i and element i, the workers share nothing else
+		m_jobSystem->parallelFor(rangeCount, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t range = begin; range < end; ++range)
+			{
+				const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * range / rangeCount);
+				const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * (range + 1) / rangeCount);
+
+				try
+				{
+					const vk::CommandBuffer commandBuffer = acquire(framePools[range]);
+					commandBuffer.begin(beginInfo);
+					callback(commandBuffer, range, first, last - first);
+					commandBuffer.end();
+
+					commandBuffers[range] = commandBuffer;
+				}
+				catch (...)
+				{
+					std::scoped_lock lock(errorMutex);
+					if (!error)
+					{
+						error = std::current_exception();
+					}
+				}
+			}
+		});
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+
+		return commandBuffers;
+	}
+
+	uint32_t ParallelRecorder::getWorkerCount() const
+	{
+		return m_jobSystem->getWorkerCount();
+	}
+
+	vk::CommandBuffer ParallelRecorder::acquire(WorkerPool& pool)
+	{
+		if (pool.used == pool.commandBuffers.size())
+		{
+			const auto allocated =
+				m_device.allocateCommandBuffers(vk::CommandBufferAllocateInfo { pool.commandPool, vk::CommandBufferLevel::eSecondary, 1 });
+			pool.commandBuffers.push_back(allocated.front());
+		}
+
+		return pool.commandBuffers[pool.used++];
+	}
+
+}
@@ -0,0 +1,723 @@
+#include "PipelineManager.hpp"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <variant>
+
+#include "StCore/Hash.hpp"
+#include "StShader/Shader.hpp"
+
+namespace st::renderer
+{
+	namespace
+	{
+		constexpr const char* pipelineCacheFileName = "PipelineCache.bin";
+		constexpr const char* variantListFileName = "PipelineVariants.txt";
+		constexpr const char* computeVariantKeyword = "compute";
+
+		template<typename T>
+		uint32_t toInt(T value)
+		{
+			return static_cast<uint32_t>(value);
+		}
+
+		// Packs the constants as tightly laid out uint32 values, info() stays valid while this lives
+		class SpecializationData
+		{
+		public:
+			explicit SpecializationData(const std::vector<SpecializationConstant>& constants)
+			{
+				for (const auto& constant : constants)
+				{
+					m_entries.emplace_back(constant.constantId, static_cast<uint32_t>(m_data.size() * sizeof(uint32_t)), sizeof(uint32_t));
+					m_data.push_back(constant.value);
+				}
+
+				m_info = vk::SpecializationInfo { static_cast<uint32_t>(m_entries.size()),
+												  m_entries.data(),
+												  m_data.size() * sizeof(uint32_t),
+												  m_data.data() };
+			}
+
+			const vk::SpecializationInfo* info() const
+			{
+				return m_entries.empty() ? nullptr : &m_info;
+			}
+
+		private:
+			std::vector<vk::SpecializationMapEntry> m_entries;
+			std::vector<uint32_t> m_data;
+			vk::SpecializationInfo m_info;
+		};
+
+		void destroyModules(vk::Device device, std::initializer_list<vk::ShaderModule> modules)
+		{
+			for (const vk::ShaderModule module : modules)
+			{
+				if (module)
+				{
+					device.destroy(module);
+				}
+			}
+		}
+
+		std::string shaderNames(const GraphicsPipelineDescription& description)
+		{
+			return description.vertexShader + " / " + description.fragmentShader;
+		}
+
+		std::string shaderNames(const ComputePipelineDescription& description)
+		{
+			return description.computeShader;
+		}
+	}
+
+	/*--------------------------------------------------------------------------------*/
+	/*--------------------------GraphicsPipelineDescription---------------------------*/
+	/*--------------------------------------------------------------------------------*/
+
+	uint64_t GraphicsPipelineDescription::hash() const
+	{
+		std::ostringstream stream;
+		serialize(stream);
+		return st::core::hashString(stream.str());
+	}
+
+	void GraphicsPipelineDescription::serialize(std::ostream& os) const
+	{
+		os << std::quoted(vertexShader) << ' ' << std::quoted(fragmentShader) << ' ';
+
+		os << specialization.size() << ' ';
+		for (const auto& constant : specialization)
+		{
+			os << constant.constantId << ' ' << constant.value << ' ';
+		}
+
+		os << vertexBindings.size() << ' ';
+		for (const auto& binding : vertexBindings)
+		{
+			os << binding.binding << ' ' << binding.stride << ' ' << toInt(binding.inputRate) << ' ';
+		}
+
+		os << vertexAttributes.size() << ' ';
+		for (const auto& attribute : vertexAttributes)
+		{
+			os << attribute.location << ' ' << attribute.binding << ' ' << toInt(attribute.format) << ' ' << attribute.offset << ' ';
+		}
+
+		os << toInt(topology) << ' ' << toInt(polygonMode) << ' ' << toInt(cullMode) << ' ' << toInt(frontFace) << ' ';
+		os << depthTest << ' ' << depthWrite << ' ' << toInt(depthCompare) << ' ';
+		os << blendEnable << ' '
+		   << toInt(srcColorBlendFactor) << ' ' << toInt(dstColorBlendFactor) << ' ' << toInt(colorBlendOp) << ' '
+		   << toInt(srcAlphaBlendFactor) << ' ' << toInt(dstAlphaBlendFactor) << ' ' << toInt(alphaBlendOp) << ' ';
+		os << std::quoted(renderPass) << ' ' << subpass << ' ' << std::quoted(layout);
+	}
+
+	std::optional<GraphicsPipelineDescription> GraphicsPipelineDescription::deserialize(std::istream& is)
+	{
+		GraphicsPipelineDescription description;
+		uint32_t value[6] {};
+
+		is >> std::quoted(description.vertexShader) >> std::quoted(description.fragmentShader);
+
+		size_t constantCount = 0;
+		is >> constantCount;
+		for (size_t i = 0; i < constantCount && is; ++i)
+		{
+			is >> value[0] >> value[1];
+			description.specialization.push_back({ value[0], value[1] });
+		}
+
+		size_t bindingCount = 0;
+		is >> bindingCount;
+		for (size_t i = 0; i < bindingCount && is; ++i)
+		{
+			is >> value[0] >> value[1] >> value[2];
+			description.vertexBindings.emplace_back(value[0], value[1], static_cast<vk::VertexInputRate>(value[2]));
+		}
+
+		size_t attributeCount = 0;
+		is >> attributeCount;
+		for (size_t i = 0; i < attributeCount && is; ++i)
+		{
+			is >> value[0] >> value[1] >> value[2] >> value[3];
+			description.vertexAttributes.emplace_back(value[0], value[1], static_cast<vk::Format>(value[2]), value[3]);
+		}
+
+		is >> value[0] >> value[1] >> value[2] >> value[3];
+		description.topology = static_cast<vk::PrimitiveTopology>(value[0]);
+		description.polygonMode = static_cast<vk::PolygonMode>(value[1]);
+		description.cullMode = vk::CullModeFlags(value[2]);
+		description.frontFace = static_cast<vk::FrontFace>(value[3]);
+
+		is >> description.depthTest >> description.depthWrite >> value[0];
+		description.depthCompare = static_cast<vk::CompareOp>(value[0]);
+
+		is >> description.blendEnable >> value[0] >> value[1] >> value[2] >> value[3] >> value[4] >> value[5];
+		description.srcColorBlendFactor = static_cast<vk::BlendFactor>(value[0]);
+		description.dstColorBlendFactor = static_cast<vk::BlendFactor>(value[1]);
+		description.colorBlendOp = static_cast<vk::BlendOp>(value[2]);
+		description.srcAlphaBlendFactor = static_cast<vk::BlendFactor>(value[3]);
+		description.dstAlphaBlendFactor = static_cast<vk::BlendFactor>(value[4]);
+		description.alphaBlendOp = static_cast<vk::BlendOp>(value[5]);
+
+		is >> std::quoted(description.renderPass) >> description.subpass >> std::quoted(description.layout);
+
+		if (!is)
+		{
+			return std::nullopt;
+		}
+
+		return description;
+	}
+
+	/*--------------------------------------------------------------------------------*/
+	/*--------------------------ComputePipelineDescription----------------------------*/
+	/*--------------------------------------------------------------------------------*/
+
+	uint64_t ComputePipelineDescription::hash() const
+	{
+		std::ostringstream stream;
+		serialize(stream);
+		return st::core::hashString(stream.str());
+	}
+
+	void ComputePipelineDescription::serialize(std::ostream& os) const
+	{
+		// The keyword keeps compute lines apart from graphics lines in the variant list
+		os << computeVariantKeyword << ' ' << std::quoted(computeShader) << ' ';
+
+		os << specialization.size() << ' ';
+		for (const auto& constant : specialization)
+		{
+			os << constant.constantId << ' ' << constant.value << ' ';
+		}
+
+		os << std::quoted(layout);
+	}
+
+	std::optional<ComputePipelineDescription> ComputePipelineDescription::deserialize(std::istream& is)
+	{
+		ComputePipelineDescription description;
+
+		std::string keyword;
+		is >> keyword;
+		if (keyword != computeVariantKeyword)
+		{
+			return std::nullopt;
+		}
+
+		is >> std::quoted(description.computeShader);
+
+		size_t constantCount = 0;
+		is >> constantCount;
+		for (size_t i = 0; i < constantCount && is; ++i)
+		{
+			uint32_t constantId = 0;
+			uint32_t value = 0;
+			is >> constantId >> value;
+			description.specialization.push_back({ constantId, value });
+		}
+
+		is >> std::quoted(description.layout);
+
+		if (!is)
+		{
+			return std::nullopt;
+		}
+
+		return description;
+	}
+
+	/*--------------------------------------------------------------------------------*/
+	/*--------------------------PipelineManager---------------------------------------*/
+	/*--------------------------------------------------------------------------------*/
+
+	PipelineManager::~PipelineManager()
+	{
+		shutdown();
+	}
+
+	void PipelineManager::init(vk::Device device, const std::string& cacheDirectory, st::core::JobSystem& jobSystem)
+	{
+		m_device = device;
+		m_cacheDirectory = cacheDirectory;
+		m_jobSystem = &jobSystem;
+
+		loadPipelineCache();
+	}
+
+	void PipelineManager::shutdown()
+	{
+		if (!m_device)
+		{
+			return;
+		}
+
+		// Nothing can touch the variants once the queued compiles finished
+		waitIdle();
+		m_jobSystem = nullptr;
+
+		saveVariantList();
+		savePipelineCache();
+
+		for (auto& [handle, variant] : m_variants)
+		{
+			if (variant->pipeline.load() != VK_NULL_HANDLE)
+			{
+				m_device.destroyPipeline(vk::Pipeline(variant->pipeline.load()));
+			}
+		}
+
+		m_variants.clear();
+		m_requestOrder.clear();
+		m_fallbacks.clear();
+
+		m_device.destroyPipelineCache(m_pipelineCache);
+		m_pipelineCache = nullptr;
+		m_device = nullptr;
+	}
+
+	void PipelineManager::registerRenderPass(const std::string& name, vk::RenderPass renderPass)
+	{
+		std::scoped_lock lock(m_mutex);
+		m_renderPasses[name] = renderPass;
+	}
+
+	void PipelineManager::registerLayout(const std::string& name, vk::PipelineLayout layout)
+	{
+		std::scoped_lock lock(m_mutex);
+		m_layouts[name] = layout;
+	}
+
+	PipelineHandle PipelineManager::request(const GraphicsPipelineDescription& description)
+	{
+		return requestVariant(description, description.hash());
+	}
+
+	PipelineHandle PipelineManager::compileNow(const GraphicsPipelineDescription& description)
+	{
+		return compileVariantNow(description, description.hash());
+	}
+
+	PipelineHandle PipelineManager::request(const ComputePipelineDescription& description)
+	{
+		return requestVariant(description, description.hash());
+	}
+
+	PipelineHandle PipelineManager::compileNow(const ComputePipelineDescription& description)
+	{
+		return compileVariantNow(description, description.hash());
+	}
+
+	PipelineHandle PipelineManager::requestVariant(const Description& description, PipelineHandle handle)
+	{
+		bool inserted = false;
+		Variant* variant = findOrInsert(description, handle, inserted);
+
+		if (inserted)
+		{
+			const st::core::JobFunction compileJob = [](void* data) {
+				Variant& variant = *static_cast<Variant*>(data);
+				variant.manager->compile(variant);
+			};
+			m_jobSystem->scheduleBackground(st::core::Job { compileJob, variant, &m_pendingCompiles });
+		}
+
+		return handle;
+	}
+
+	PipelineHandle PipelineManager::compileVariantNow(const Description& description, PipelineHandle handle)
+	{
+		bool inserted = false;
+		Variant* variant = findOrInsert(description, handle, inserted);
+
+		if (inserted)
+		{
+			compile(*variant);
+		}
+		else
+		{
+			// Already queued in the background, sleeps until compile() publishes the state
+			variant->state.wait(VariantState::ePending, std::memory_order_acquire);
+		}
+
+		if (variant->state.load() == VariantState::eFailed)
+		{
+			throw std::runtime_error("failed to create pipeline!");
+		}
+
+		return handle;
+	}
+
+	void PipelineManager::setFallback(const std::string& renderPass, PipelineHandle handle)
+	{
+		std::scoped_lock lock(m_mutex);
+		m_fallbacks[renderPass] = handle;
+	}
+
+	vk::Pipeline PipelineManager::getPipeline(PipelineHandle handle) const
+	{
+		std::scoped_lock lock(m_mutex);
+
+		const auto it = m_variants.find(handle);
+		if (it == m_variants.end())
+		{
+			return nullptr;
+		}
+
+		const Variant& variant = *it->second;
+		if (variant.state.load(std::memory_order_acquire) == VariantState::eReady)
+		{
+			return vk::Pipeline(variant.pipeline.load(std::memory_order_relaxed));
+		}
+
+		// Compute pipelines have no render pass and therefore no fallback
+		const auto* graphicsDescription = std::get_if<GraphicsPipelineDescription>(&variant.description);
+		if (graphicsDescription == nullptr)
+		{
+			return nullptr;
+		}
+
+		const auto fallback = m_fallbacks.find(graphicsDescription->renderPass);
+		if (fallback == m_fallbacks.end() || fallback->second == handle)
+		{
+			return nullptr;
+		}
+
+		const auto fallbackVariant = m_variants.find(fallback->second);
+		if (fallbackVariant == m_variants.end() || fallbackVariant->second->state.load(std::memory_order_acquire) != VariantState::eReady)
+		{
+			return nullptr;
+		}
+
+		return vk::Pipeline(fallbackVariant->second->pipeline.load(std::memory_order_relaxed));
+	}
+
+	bool PipelineManager::isReady(PipelineHandle handle) const
+	{
+		std::scoped_lock lock(m_mutex);
+
+		const auto it = m_variants.find(handle);
+		return it != m_variants.end() && it->second->state.load(std::memory_order_acquire) == VariantState::eReady;
+	}
+
+	uint32_t PipelineManager::prewarm()
+	{
+		std::ifstream file(variantListPath());
+		if (!file.is_open())
+		{
+			return 0;
+		}
+
+		uint32_t requested = 0;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream lineStream(line);
+
+			if (line.starts_with(computeVariantKeyword))
+			{
+				std::optional<ComputePipelineDescription> description = ComputePipelineDescription::deserialize(lineStream);
+				if (!description)
+				{
+					continue;
+				}
+
+				{
+					std::scoped_lock lock(m_mutex);
+					if (!m_layouts.contains(description->layout))
+					{
+						continue;
+					}
+				}
+
+				request(*description);
+				++requested;
+				continue;
+			}
+
+			std::optional<GraphicsPipelineDescription> description = GraphicsPipelineDescription::deserialize(lineStream);
+			if (!description)
+			{
+				continue;
+			}
+
+			{
+				// Variants of passes or layouts this run does not create are skipped
+				std::scoped_lock lock(m_mutex);
+				if (!m_renderPasses.contains(description->renderPass) || !m_layouts.contains(description->layout))
+				{
+					continue;
+				}
+			}
+
+			request(*description);
+			++requested;
+		}
+
+		return requested;
+	}
+
+	void PipelineManager::waitIdle()
+	{
+		if (m_jobSystem)
+		{
+			m_jobSystem->wait(m_pendingCompiles);
+		}
+	}
+
+	vk::PipelineCache PipelineManager::getPipelineCache() const
+	{
+		return m_pipelineCache;
+	}
+
+	PipelineManager::Variant* PipelineManager::findOrInsert(const Description& description, PipelineHandle& handle, bool& inserted)
+	{
+		std::scoped_lock lock(m_mutex);
+
+		for (auto it = m_variants.find(handle); it != m_variants.end(); it = m_variants.find(++handle))
+		{
+			if (it->second->description == description)
+			{
+				inserted = false;
+				return it->second.get();
+			}
+		}
+
+		auto variant = std::make_unique<Variant>();
+		variant->manager = this;
+		variant->description = description;
+
+		if (const auto* graphicsDescription = std::get_if<GraphicsPipelineDescription>(&description))
+		{
+			const auto renderPass = m_renderPasses.find(graphicsDescription->renderPass);
+			const auto layout = m_layouts.find(graphicsDescription->layout);
+			if (renderPass == m_renderPasses.end() || layout == m_layouts.end())
+			{
+				throw std::invalid_argument("pipeline description references unregistered render pass or layout!");
+			}
+
+			variant->renderPass = renderPass->second;
+			variant->layout = layout->second;
+		}
+		else
+		{
+			const auto layout = m_layouts.find(std::get<ComputePipelineDescription>(description).layout);
+			if (layout == m_layouts.end())
+			{
+				throw std::invalid_argument("pipeline description references unregistered layout!");
+			}
+
+			variant->layout = layout->second;
+		}
+
+		Variant* result = variant.get();
+		m_variants.emplace(handle, std::move(variant));
+		m_requestOrder.push_back(handle);
+
+		inserted = true;
+		return result;
+	}
+
+	void PipelineManager::compile(Variant& variant) const
+	{
+		try
+		{
+			vk::Pipeline pipeline;
+			if (const auto* graphicsDescription = std::get_if<GraphicsPipelineDescription>(&variant.description))
+			{
+				pipeline = compileGraphics(*graphicsDescription, variant.renderPass, variant.layout);
+			}
+			else
+			{
+				pipeline = compileCompute(std::get<ComputePipelineDescription>(variant.description), variant.layout);
+			}
+
+			variant.pipeline.store(static_cast<VkPipeline>(pipeline), std::memory_order_relaxed);
+			variant.state.store(VariantState::eReady, std::memory_order_release);
+			variant.state.notify_all();
+		}
+		catch (std::exception const& exc)
+		{
+			std::visit([&exc](const auto& description) { std::cerr << "Pipeline variant " << shaderNames(description) << ": " << exc.what() << std::endl; },
+					   variant.description);
+			variant.state.store(VariantState::eFailed, std::memory_order_release);
+			variant.state.notify_all();
+		}
+	}
+
+	vk::Pipeline PipelineManager::compileGraphics(const GraphicsPipelineDescription& description, vk::RenderPass renderPass, vk::PipelineLayout layout) const
+	{
+		vk::ShaderModule vertShaderModule;
+		vk::ShaderModule fragShaderModule;
+		vk::Pipeline pipeline;
+
+		try
+		{
+			vertShaderModule = Shader::createShaderModule(m_device, Shader::readFile(description.vertexShader));
+			fragShaderModule = Shader::createShaderModule(m_device, Shader::readFile(description.fragmentShader));
+
+			SpecializationData specialization(description.specialization);
+			const vk::SpecializationInfo* pSpecializationInfo = specialization.info();
+
+			std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages {
+				vk::PipelineShaderStageCreateInfo { {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main", pSpecializationInfo },
+				vk::PipelineShaderStageCreateInfo { {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main", pSpecializationInfo }
+			};
+
+			vk::PipelineVertexInputStateCreateInfo vertexInputInfo { {}, description.vertexBindings, description.vertexAttributes };
+
+			vk::PipelineInputAssemblyStateCreateInfo inputAssembly { {}, description.topology, VK_FALSE };
+
+			vk::PipelineViewportStateCreateInfo viewportState { {}, 1, {}, 1, {} };
+
+			vk::PipelineRasterizationStateCreateInfo rasterizer { {},
+																  VK_FALSE,
+																  VK_FALSE,
+																  description.polygonMode,
+																  description.cullMode,
+																  description.frontFace,
+																  VK_FALSE,
+																  0.0F,
+																  0.0F,
+																  0.0F,
+																  1.0F };
+
+			vk::PipelineMultisampleStateCreateInfo multisampling { {}, vk::SampleCountFlagBits::e1, VK_FALSE };
+
+			vk::PipelineDepthStencilStateCreateInfo depthStencil { {}, description.depthTest, description.depthWrite, description.depthCompare, false, false };
+
+			vk::PipelineColorBlendAttachmentState colorBlendAttachment { description.blendEnable,
+																		 description.srcColorBlendFactor,
+																		 description.dstColorBlendFactor,
+																		 description.colorBlendOp,
+																		 description.srcAlphaBlendFactor,
+																		 description.dstAlphaBlendFactor,
+																		 description.alphaBlendOp,
+																		 vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+																			 vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA };
+
+			vk::PipelineColorBlendStateCreateInfo colorBlending { {}, VK_FALSE, vk::LogicOp::eCopy, colorBlendAttachment, { 0.0F, 0.0F, 0.0F, 0.0F } };
+
+			std::array<vk::DynamicState, 2> dynamicStates { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+			vk::PipelineDynamicStateCreateInfo dynamicState { {}, dynamicStates };
+
+			vk::GraphicsPipelineCreateInfo pipelineInfo { {},
+														  shaderStages,
+														  &vertexInputInfo,
+														  &inputAssembly,
+														  {},
+														  &viewportState,
+														  &rasterizer,
+														  &multisampling,
+														  &depthStencil,
+														  &colorBlending,
+														  &dynamicState,
+														  layout,
+														  renderPass,
+														  description.subpass };
+
+			// VkPipelineCache is internally synchronized, workers can share it
+			pipeline = m_device.createGraphicsPipeline(m_pipelineCache, pipelineInfo).value;
+		}
+		catch (...)
+		{
+			destroyModules(m_device, { vertShaderModule, fragShaderModule });
+			throw;
+		}
+
+		// Modules are baked into the pipeline and are not needed after creation
+		destroyModules(m_device, { vertShaderModule, fragShaderModule });
+		return pipeline;
+	}
+
+	vk::Pipeline PipelineManager::compileCompute(const ComputePipelineDescription& description, vk::PipelineLayout layout) const
+	{
+		vk::ShaderModule computeShaderModule = Shader::createShaderModule(m_device, Shader::readFile(description.computeShader));
+		vk::Pipeline pipeline;
+
+		try
+		{
+			SpecializationData specialization(description.specialization);
+
+			const vk::ComputePipelineCreateInfo pipelineInfo {
+				{},
+				vk::PipelineShaderStageCreateInfo { {}, vk::ShaderStageFlagBits::eCompute, computeShaderModule, "main", specialization.info() },
+				layout
+			};
+
+			pipeline = m_device.createComputePipeline(m_pipelineCache, pipelineInfo).value;
+		}
+		catch (...)
+		{
+			destroyModules(m_device, { computeShaderModule });
+			throw;
+		}
+
+		destroyModules(m_device, { computeShaderModule });
+		return pipeline;
+	}
+
+	void PipelineManager::loadPipelineCache()
+	{
+		std::vector<char> cacheData;
+
+		std::ifstream file(pipelineCachePath(), std::ios::ate | std::ios::binary);
+		if (file.is_open())
+		{
+			cacheData.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(cacheData.data(), static_cast<std::streamsize>(cacheData.size()));
+		}
+
+		// The driver validates the header and starts empty when the blob does not match the device
+		m_pipelineCache = m_device.createPipelineCache(vk::PipelineCacheCreateInfo { {}, cacheData.size(), cacheData.data() });
+	}
+
+	void PipelineManager::savePipelineCache() const
+	{
+		const std::vector<uint8_t> cacheData = m_device.getPipelineCacheData(m_pipelineCache);
+
+		std::ofstream file(pipelineCachePath(), std::ios::binary | std::ios::trunc);
+		if (file.is_open())
+		{
+			file.write(reinterpret_cast<const char*>(cacheData.data()), static_cast<std::streamsize>(cacheData.size()));
+		}
+	}
+
+	void PipelineManager::saveVariantList() const
+	{
+		std::ofstream file(variantListPath(), std::ios::trunc);
+		if (!file.is_open())
+		{
+			return;
+		}
+
+		for (const PipelineHandle handle : m_requestOrder)
+		{
+			const Variant& variant = *m_variants.at(handle);
+			if (variant.state.load() == VariantState::eReady)
+			{
+				std::visit([&file](const auto& description) { description.serialize(file); }, variant.description);
+				file << '\n';
+			}
+		}
+	}
+
+	std::string PipelineManager::pipelineCachePath() const
+	{
+		return (std::filesystem::path(m_cacheDirectory) / pipelineCacheFileName).string();
+	}
+
+	std::string PipelineManager::variantListPath() const
+	{
+		return (std::filesystem::path(m_cacheDirectory) / variantListFileName).string();
+	}
+
+}
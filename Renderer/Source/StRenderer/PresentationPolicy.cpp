@@ -0,0 +1,60 @@
+#include "PresentationPolicy.hpp"
+
+#include <algorithm>
+
+namespace st::renderer
+{
+
+	PresentationPolicy PresentationPolicy::make(PresentationProfile profile)
+	{
+		PresentationPolicy policy;
+		policy.profile = profile;
+
+		switch (profile)
+		{
+		case PresentationProfile::eLowLatency:
+			policy.framesInFlight = 1;
+			policy.imageCount = 2;
+			policy.presentModes = { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo };
+			break;
+		case PresentationProfile::eThroughput:
+			policy.framesInFlight = 3;
+			policy.imageCount = 3;
+			policy.presentModes = { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo };
+			break;
+		case PresentationProfile::ePowerSaving:
+			policy.framesInFlight = 2;
+			policy.imageCount = 2;
+			policy.presentModes = { vk::PresentModeKHR::eFifo };
+			policy.frameRateCap = 30.0F;
+			break;
+		}
+
+		return policy;
+	}
+
+	vk::PresentModeKHR PresentationPolicy::choosePresentMode(std::span<const vk::PresentModeKHR> availablePresentModes) const
+	{
+		for (const auto presentMode : presentModes)
+		{
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end())
+			{
+				return presentMode;
+			}
+		}
+
+		// The only mode every implementation supports
+		return vk::PresentModeKHR::eFifo;
+	}
+
+	uint32_t PresentationPolicy::chooseImageCount(const vk::SurfaceCapabilitiesKHR& capabilities) const
+	{
+		uint32_t count = std::max(imageCount, capabilities.minImageCount);
+		if (capabilities.maxImageCount > 0)
+		{
+			count = std::min(count, capabilities.maxImageCount);
+		}
+		return count;
+	}
+
+}
@@ -0,0 +1,805 @@
+#include "RenderGraph.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "StCore/Hash.hpp"
+
+namespace st::renderer
+{
+	namespace
+	{
+		struct AccessInfo
+		{
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags access;
+			vk::ImageLayout layout;
+		};
+
+		AccessInfo accessInfo(ResourceAccess access)
+		{
+			switch (access)
+			{
+			case ResourceAccess::eColorAttachment:
+				return { vk::PipelineStageFlagBits::eColorAttachmentOutput,
+						 vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
+						 vk::ImageLayout::eColorAttachmentOptimal };
+			case ResourceAccess::eDepthAttachment:
+				return { vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+						 vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+						 vk::ImageLayout::eDepthStencilAttachmentOptimal };
+			case ResourceAccess::eDepthSampled:
+				return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eDepthStencilReadOnlyOptimal };
+			case ResourceAccess::eFragmentSampled:
+				return { vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eShaderReadOnlyOptimal };
+			case ResourceAccess::eComputeSampled:
+				return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eShaderReadOnlyOptimal };
+			case ResourceAccess::eComputeStorage:
+				return { vk::PipelineStageFlagBits::eComputeShader,
+						 vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+						 vk::ImageLayout::eGeneral };
+			case ResourceAccess::eTransferSource:
+				return { vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eTransferSrcOptimal };
+			}
+
+			return {};
+		}
+
+		vk::AccessFlags writeAccess(vk::AccessFlags access)
+		{
+			return access & (vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+							 vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite);
+		}
+
+		vk::ImageAspectFlags barrierAspect(const RenderGraphImage& description)
+		{
+			switch (description.format)
+			{
+			case vk::Format::eD16UnormS8Uint:
+			case vk::Format::eD24UnormS8Uint:
+			case vk::Format::eD32SfloatS8Uint:
+				return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+			default:
+				return description.aspect;
+			}
+		}
+
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		shutdown();
+	}
+
+	void RenderGraph::init(vk::Device device, MemoryAllocator& allocator, uint32_t frameCount)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_retired.assign(frameCount, {});
+	}
+
+	void RenderGraph::shutdown()
+	{
+		if (!m_device)
+		{
+			return;
+		}
+
+		retireTransients(0);
+		invalidateFramebuffers(0);
+		for (auto& retired : m_retired)
+		{
+			destroy(retired);
+		}
+		m_retired.clear();
+
+		for (const auto& [key, renderPass] : m_renderPasses)
+		{
+			m_device.destroyRenderPass(renderPass);
+		}
+		m_renderPasses.clear();
+
+		reset();
+		m_device = nullptr;
+	}
+
+	void RenderGraph::beginFrame(uint32_t frameIndex)
+	{
+		destroy(m_retired.at(frameIndex));
+	}
+
+	void RenderGraph::reset(std::pmr::memory_resource* frameMemory)
+	{
+		m_frameMemory = frameMemory;
+		m_passes.clear();
+		m_resources.clear();
+		m_states.clear();
+		m_physicalImages.clear();
+		m_finalBarriers.clear();
+	}
+
+	RenderGraph::Resource RenderGraph::importImage(vk::Image image,
+												   vk::ImageView view,
+												   const RenderGraphImage& description,
+												   vk::ImageLayout initialLayout,
+												   vk::PipelineStageFlags initialStages,
+												   vk::ImageLayout finalLayout,
+												   vk::PipelineStageFlags finalStages)
+	{
+		ResourceData& resource = m_resources.emplace_back();
+		resource.description = description;
+		resource.imported = true;
+		resource.image = image;
+		resource.view = view;
+		resource.initialLayout = initialLayout;
+		resource.initialStages = initialStages;
+		resource.finalLayout = finalLayout;
+		resource.finalStages = finalStages;
+
+		return static_cast<Resource>(m_resources.size() - 1);
+	}
+
+	RenderGraph::Resource RenderGraph::createImage(const RenderGraphImage& description)
+	{
+		m_resources.emplace_back().description = description;
+		return static_cast<Resource>(m_resources.size() - 1);
+	}
+
+	RenderGraph::Pass RenderGraph::addPass(ExecuteCallback execute)
+	{
+		m_passes.emplace_back(m_frameMemory).execute = std::move(execute);
+		return static_cast<Pass>(m_passes.size() - 1);
+	}
+
+	void RenderGraph::read(Pass pass, Resource resource, ResourceAccess access)
+	{
+		m_passes.at(pass).uses.push_back(Use { resource, access, false });
+	}
+
+	void RenderGraph::write(Pass pass, Resource resource, ResourceAccess access)
+	{
+		m_passes.at(pass).uses.push_back(Use { resource, access, true });
+	}
+
+	void RenderGraph::setColorAttachment(Pass pass, Resource resource, vk::AttachmentLoadOp loadOp, vk::ClearColorValue clearValue)
+	{
+		m_passes.at(pass).color = Attachment { resource, loadOp, clearValue };
+		write(pass, resource, ResourceAccess::eColorAttachment);
+	}
+
+	void RenderGraph::setDepthAttachment(Pass pass, Resource resource, vk::AttachmentLoadOp loadOp, vk::ClearDepthStencilValue clearValue)
+	{
+		m_passes.at(pass).depth = Attachment { resource, loadOp, clearValue };
+		write(pass, resource, ResourceAccess::eDepthAttachment);
+	}
+
+	void RenderGraph::setSideEffect(Pass pass)
+	{
+		m_passes.at(pass).sideEffect = true;
+	}
+
+	void RenderGraph::setSecondaryCommandBuffers(Pass pass)
+	{
+		m_passes.at(pass).secondaryCommandBuffers = true;
+	}
+
+	void RenderGraph::compile(uint32_t frameIndex)
+	{
+		m_statistics.passCount = static_cast<uint32_t>(m_passes.size());
+		m_statistics.culledPassCount = 0;
+		m_statistics.barrierCount = 0;
+
+		cullPasses();
+		computeLifetimes();
+		createTransients(frameIndex);
+		buildBarriers();
+		createRenderPasses();
+	}
+
+	void RenderGraph::execute(vk::CommandBuffer commandBuffer) const
+	{
+		for (const auto& pass : m_passes)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			if (!pass.barriers.empty())
+			{
+				commandBuffer.pipelineBarrier(pass.srcStages, pass.dstStages, {}, {}, {}, pass.barriers);
+			}
+
+			if (!pass.renderPass)
+			{
+				pass.execute(commandBuffer);
+				continue;
+			}
+
+			std::array<vk::ClearValue, 2> clearValues;
+			uint32_t clearValueCount = 0;
+			if (pass.color)
+			{
+				clearValues[clearValueCount++] = pass.color->clearValue;
+			}
+			if (pass.depth)
+			{
+				clearValues[clearValueCount++] = pass.depth->clearValue;
+			}
+
+			const vk::RenderPassBeginInfo beginInfo { pass.renderPass,
+													  pass.framebuffer,
+													  vk::Rect2D { { 0, 0 }, pass.extent },
+													  clearValueCount,
+													  clearValues.data() };
+			commandBuffer.beginRenderPass(beginInfo,
+										  pass.secondaryCommandBuffers ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+			pass.execute(commandBuffer);
+			commandBuffer.endRenderPass();
+		}
+
+		if (!m_finalBarriers.empty())
+		{
+			commandBuffer.pipelineBarrier(m_finalSrcStages, m_finalDstStages, {}, {}, {}, m_finalBarriers);
+		}
+	}
+
+	void RenderGraph::invalidateFramebuffers(uint32_t frameIndex)
+	{
+		auto& retired = m_retired.at(frameIndex);
+		for (const auto& [key, framebuffer] : m_framebuffers)
+		{
+			retired.framebuffers.push_back(framebuffer);
+		}
+		m_framebuffers.clear();
+	}
+
+	vk::ImageView RenderGraph::getImageView(Resource resource) const
+	{
+		if (m_resources.at(resource).imported)
+		{
+			return m_resources[resource].view;
+		}
+
+		const auto& physical = m_physicalImages.at(resource);
+		return physical ? m_transients[*physical].view : vk::ImageView {};
+	}
+
+	vk::CommandBufferInheritanceInfo RenderGraph::getInheritance(Pass pass) const
+	{
+		const auto& data = m_passes.at(pass);
+		return vk::CommandBufferInheritanceInfo { data.renderPass, 0, data.framebuffer };
+	}
+
+	RenderGraphStatistics RenderGraph::getStatistics() const
+	{
+		return m_statistics;
+	}
+
+	void RenderGraph::cullPasses()
+	{
+		// Walks backwards from the passes with visible results, a pass survives when a surviving
+		// pass or an imported image needs something it writes
+		std::pmr::vector<bool> needed(m_resources.size(), false, m_frameMemory);
+
+		for (size_t i = m_passes.size(); i-- > 0;)
+		{
+			PassData& pass = m_passes[i];
+
+			bool alive = pass.sideEffect;
+			for (const auto& use : pass.uses)
+			{
+				alive = alive || (use.write && (m_resources[use.resource].imported || needed[use.resource]));
+			}
+
+			pass.culled = !alive;
+			if (!alive)
+			{
+				++m_statistics.culledPassCount;
+				continue;
+			}
+
+			// Attachments that are not loaded are overwritten, earlier writes to them are dead
+			for (const auto& attachment : { pass.color, pass.depth })
+			{
+				if (attachment)
+				{
+					needed[attachment->resource] = attachment->loadOp == vk::AttachmentLoadOp::eLoad;
+				}
+			}
+
+			for (const auto& use : pass.uses)
+			{
+				if (!use.write)
+				{
+					needed[use.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::computeLifetimes()
+	{
+		for (uint32_t i = 0; i < m_passes.size(); ++i)
+		{
+			if (m_passes[i].culled)
+			{
+				continue;
+			}
+
+			for (const auto& use : m_passes[i].uses)
+			{
+				ResourceData& resource = m_resources[use.resource];
+				if (!resource.firstPass)
+				{
+					resource.firstPass = i;
+				}
+				resource.lastPass = i;
+			}
+		}
+	}
+
+	void RenderGraph::createTransients(uint32_t frameIndex)
+	{
+		// Greedy interval assignment in order of first use, an image joins the first group whose
+		// previous image was last used before it starts
+		std::pmr::vector<Resource> order(m_frameMemory);
+		for (Resource resource = 0; resource < m_resources.size(); ++resource)
+		{
+			if (!m_resources[resource].imported && m_resources[resource].firstPass)
+			{
+				order.push_back(resource);
+			}
+		}
+		// Ties keep declaration order, std::stable_sort would allocate a buffer every frame
+		std::sort(order.begin(), order.end(), [this](Resource a, Resource b) {
+			return std::pair { *m_resources[a].firstPass, a } < std::pair { *m_resources[b].firstPass, b };
+		});
+
+		std::pmr::vector<uint32_t> groupEnds(m_frameMemory);
+		std::pmr::vector<TransientImage> wanted(m_frameMemory);
+		m_physicalImages.assign(m_resources.size(), std::nullopt);
+
+		for (Resource resource : order)
+		{
+			const ResourceData& data = m_resources[resource];
+
+			uint32_t group = 0;
+			while (group < groupEnds.size() && groupEnds[group] >= *data.firstPass)
+			{
+				++group;
+			}
+			if (group == groupEnds.size())
+			{
+				groupEnds.push_back(0);
+			}
+			groupEnds[group] = data.lastPass;
+
+			m_physicalImages[resource] = static_cast<uint32_t>(wanted.size());
+			wanted.push_back(TransientImage { data.description, group });
+		}
+
+		const bool unchanged = std::equal(wanted.begin(), wanted.end(), m_transients.begin(), m_transients.end(), [](const TransientImage& a, const TransientImage& b) {
+			return a.description == b.description && a.aliasGroup == b.aliasGroup;
+		});
+		if (unchanged)
+		{
+			return;
+		}
+
+		retireTransients(frameIndex);
+		m_transients.assign(wanted.begin(), wanted.end());
+		m_statistics.transientBytes = 0;
+		m_statistics.unaliasedBytes = 0;
+
+		std::vector<vk::MemoryRequirements> slotRequirements;
+		std::vector<uint32_t> slotGroups;
+
+		for (auto& transient : m_transients)
+		{
+			const RenderGraphImage& description = transient.description;
+			transient.image = m_device.createImage(vk::ImageCreateInfo { {},
+																		 vk::ImageType::e2D,
+																		 description.format,
+																		 { description.extent.width, description.extent.height, 1 },
+																		 1,
+																		 1,
+																		 vk::SampleCountFlagBits::e1,
+																		 vk::ImageTiling::eOptimal,
+																		 description.usage,
+																		 vk::SharingMode::eExclusive,
+																		 {},
+																		 vk::ImageLayout::eUndefined });
+
+			const vk::MemoryRequirements requirements = m_device.getImageMemoryRequirements(transient.image);
+			m_statistics.unaliasedBytes += requirements.size;
+
+			// A group is split when its images cannot live in the same memory type
+			uint32_t slot = 0;
+			while (slot < slotRequirements.size() &&
+				   (slotGroups[slot] != transient.aliasGroup || (slotRequirements[slot].memoryTypeBits & requirements.memoryTypeBits) == 0))
+			{
+				++slot;
+			}
+			if (slot == slotRequirements.size())
+			{
+				slotRequirements.push_back(requirements);
+				slotGroups.push_back(transient.aliasGroup);
+			}
+
+			vk::MemoryRequirements& merged = slotRequirements[slot];
+			merged.size = std::max(merged.size, requirements.size);
+			merged.alignment = std::max(merged.alignment, requirements.alignment);
+			merged.memoryTypeBits &= requirements.memoryTypeBits;
+			transient.slot = slot;
+		}
+
+		m_slots.resize(slotRequirements.size());
+		for (uint32_t slot = 0; slot < m_slots.size(); ++slot)
+		{
+			m_slots[slot].memory = m_allocator->allocateAliased(slotRequirements[slot], vk::MemoryPropertyFlagBits::eDeviceLocal);
+			m_statistics.transientBytes += slotRequirements[slot].size;
+		}
+
+		for (auto& transient : m_transients)
+		{
+			const MemoryAllocation& memory = m_slots[transient.slot].memory;
+			m_device.bindImageMemory(transient.image, memory.memory, memory.offset);
+
+			transient.view = m_device.createImageView(vk::ImageViewCreateInfo { {},
+																				transient.image,
+																				vk::ImageViewType::e2D,
+																				transient.description.format,
+																				{},
+																				{ transient.description.aspect, 0, 1, 0, 1 } });
+		}
+	}
+
+	void RenderGraph::retireTransients(uint32_t frameIndex)
+	{
+		if (m_transients.empty())
+		{
+			return;
+		}
+
+		// Framebuffers may reference the views
+		invalidateFramebuffers(frameIndex);
+
+		auto& retired = m_retired.at(frameIndex);
+		for (auto& transient : m_transients)
+		{
+			retired.images.push_back(transient);
+		}
+		for (auto& slot : m_slots)
+		{
+			retired.memory.push_back(slot.memory);
+		}
+
+		m_transients.clear();
+		m_slots.clear();
+	}
+
+	void RenderGraph::buildBarriers()
+	{
+		// The previous frame may still use slot memory, the first use of every frame waits for it
+		for (const auto& pass : m_passes)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			for (const auto& use : pass.uses)
+			{
+				if (const auto& physical = m_physicalImages[use.resource])
+				{
+					const AccessInfo info = accessInfo(use.access);
+					MemorySlot& slot = m_slots[m_transients[*physical].slot];
+					slot.stages |= info.stages;
+					slot.writeAccess |= writeAccess(info.access);
+				}
+			}
+		}
+
+		m_states.assign(m_resources.size(), ResourceState {});
+		for (Resource resource = 0; resource < m_resources.size(); ++resource)
+		{
+			const ResourceData& data = m_resources[resource];
+			ResourceState& state = m_states[resource];
+
+			if (data.imported)
+			{
+				state.layout = data.initialLayout;
+				state.writeStages = data.initialStages;
+			}
+			else if (const auto& physical = m_physicalImages[resource])
+			{
+				const MemorySlot& slot = m_slots[m_transients[*physical].slot];
+				state.writeStages = slot.stages;
+				state.writeAccess = slot.writeAccess;
+			}
+		}
+
+		for (uint32_t i = 0; i < m_passes.size(); ++i)
+		{
+			PassData& pass = m_passes[i];
+			pass.barriers.clear();
+			pass.srcStages = {};
+			pass.dstStages = {};
+
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			// Undefined contents are never loaded, nothing read later is never stored
+			for (auto* attachment : { pass.color ? &*pass.color : nullptr, pass.depth ? &*pass.depth : nullptr })
+			{
+				if (!attachment)
+				{
+					continue;
+				}
+
+				const ResourceData& data = m_resources[attachment->resource];
+				if (attachment->loadOp == vk::AttachmentLoadOp::eLoad && m_states[attachment->resource].layout == vk::ImageLayout::eUndefined)
+				{
+					attachment->loadOp = vk::AttachmentLoadOp::eDontCare;
+				}
+				attachment->storeOp = (data.imported || data.lastPass > i) ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+			}
+
+			for (const auto& use : pass.uses)
+			{
+				addBarrier(pass, use.resource, use.access, use.write);
+			}
+			m_statistics.barrierCount += static_cast<uint32_t>(pass.barriers.size());
+		}
+
+		m_finalSrcStages = {};
+		m_finalDstStages = {};
+		for (Resource resource = 0; resource < m_resources.size(); ++resource)
+		{
+			const ResourceData& data = m_resources[resource];
+			const ResourceState& state = m_states[resource];
+			if (!data.imported || data.finalLayout == vk::ImageLayout::eUndefined)
+			{
+				continue;
+			}
+
+			const vk::PipelineStageFlags waitStages = state.writeStages | state.readStages;
+			if (state.layout == data.finalLayout && !state.writeAccess)
+			{
+				continue;
+			}
+
+			m_finalBarriers.push_back(vk::ImageMemoryBarrier { state.writeAccess,
+															   vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+															   state.layout,
+															   data.finalLayout,
+															   VK_QUEUE_FAMILY_IGNORED,
+															   VK_QUEUE_FAMILY_IGNORED,
+															   data.image,
+															   { barrierAspect(data.description), 0, 1, 0, 1 } });
+			m_finalSrcStages |= waitStages ? waitStages : vk::PipelineStageFlags { vk::PipelineStageFlagBits::eTopOfPipe };
+			m_finalDstStages |= data.finalStages;
+		}
+		m_statistics.barrierCount += static_cast<uint32_t>(m_finalBarriers.size());
+	}
+
+	void RenderGraph::addBarrier(PassData& pass, Resource resource, ResourceAccess access, bool write)
+	{
+		const ResourceData& data = m_resources[resource];
+		ResourceState& state = m_states[resource];
+
+		const AccessInfo info = accessInfo(access);
+		const vk::Image image = data.imported ? data.image : m_transients[*m_physicalImages[resource]].image;
+		const vk::ImageSubresourceRange range { barrierAspect(data.description), 0, 1, 0, 1 };
+
+		// Writes and layout transitions wait for every earlier access
+		if (write || state.layout != info.layout)
+		{
+			const vk::PipelineStageFlags waitStages = state.writeStages | state.readStages;
+			if (waitStages || state.layout != info.layout)
+			{
+				pass.barriers.push_back(vk::ImageMemoryBarrier { state.writeAccess,
+																 info.access,
+																 state.layout,
+																 info.layout,
+																 VK_QUEUE_FAMILY_IGNORED,
+																 VK_QUEUE_FAMILY_IGNORED,
+																 image,
+																 range });
+				pass.srcStages |= waitStages ? waitStages : vk::PipelineStageFlags { vk::PipelineStageFlagBits::eTopOfPipe };
+				pass.dstStages |= info.stages;
+			}
+
+			// A transition is a write as far as later readers are concerned
+			state.layout = info.layout;
+			state.writeStages = info.stages;
+			state.writeAccess = writeAccess(info.access);
+			state.readStages = {};
+			state.visibleStages = info.stages;
+			return;
+		}
+
+		// Reads in the same layout only wait for the last write, once per stage
+		if (state.writeStages && (state.visibleStages & info.stages) != info.stages)
+		{
+			pass.barriers.push_back(vk::ImageMemoryBarrier { state.writeAccess,
+															 info.access,
+															 state.layout,
+															 state.layout,
+															 VK_QUEUE_FAMILY_IGNORED,
+															 VK_QUEUE_FAMILY_IGNORED,
+															 image,
+															 range });
+			pass.srcStages |= state.writeStages;
+			pass.dstStages |= info.stages;
+			state.visibleStages |= info.stages;
+		}
+		state.readStages |= info.stages;
+	}
+
+	void RenderGraph::createRenderPasses()
+	{
+		for (auto& pass : m_passes)
+		{
+			pass.renderPass = nullptr;
+			pass.framebuffer = nullptr;
+
+			if (pass.culled || (!pass.color && !pass.depth))
+			{
+				continue;
+			}
+
+			RenderPassKey renderPassKey;
+			FramebufferKey framebufferKey;
+			if (pass.color)
+			{
+				const ResourceData& color = m_resources[pass.color->resource];
+				renderPassKey.colorFormat = color.description.format;
+				renderPassKey.colorLoadOp = pass.color->loadOp;
+				renderPassKey.colorStoreOp = pass.color->storeOp;
+				framebufferKey.colorView = getImageView(pass.color->resource);
+				framebufferKey.extent = color.description.extent;
+			}
+			if (pass.depth)
+			{
+				const ResourceData& depth = m_resources[pass.depth->resource];
+				renderPassKey.depthFormat = depth.description.format;
+				renderPassKey.depthLoadOp = pass.depth->loadOp;
+				renderPassKey.depthStoreOp = pass.depth->storeOp;
+				framebufferKey.depthView = getImageView(pass.depth->resource);
+				framebufferKey.extent = depth.description.extent;
+			}
+
+			pass.renderPass = getRenderPass(renderPassKey);
+			framebufferKey.renderPass = pass.renderPass;
+			pass.framebuffer = getFramebuffer(framebufferKey);
+			pass.extent = framebufferKey.extent;
+		}
+	}
+
+	vk::RenderPass RenderGraph::getRenderPass(const RenderPassKey& key)
+	{
+		const auto found = m_renderPasses.find(key);
+		if (found != m_renderPasses.end())
+		{
+			return found->second;
+		}
+
+		// The graph transitions the attachments before the pass begins, layouts never change inside
+		// it. Only formats and sample counts matter for pipeline compatibility.
+		std::vector<vk::AttachmentDescription> attachments;
+		std::vector<vk::AttachmentReference> colorReferences;
+		vk::AttachmentReference depthReference;
+
+		if (key.colorFormat != vk::Format::eUndefined)
+		{
+			colorReferences.push_back(vk::AttachmentReference { static_cast<uint32_t>(attachments.size()), vk::ImageLayout::eColorAttachmentOptimal });
+			attachments.push_back(vk::AttachmentDescription { {},
+															  key.colorFormat,
+															  vk::SampleCountFlagBits::e1,
+															  key.colorLoadOp,
+															  key.colorStoreOp,
+															  vk::AttachmentLoadOp::eDontCare,
+															  vk::AttachmentStoreOp::eDontCare,
+															  vk::ImageLayout::eColorAttachmentOptimal,
+															  vk::ImageLayout::eColorAttachmentOptimal });
+		}
+
+		if (key.depthFormat != vk::Format::eUndefined)
+		{
+			depthReference = vk::AttachmentReference { static_cast<uint32_t>(attachments.size()), vk::ImageLayout::eDepthStencilAttachmentOptimal };
+			attachments.push_back(vk::AttachmentDescription { {},
+															  key.depthFormat,
+															  vk::SampleCountFlagBits::e1,
+															  key.depthLoadOp,
+															  key.depthStoreOp,
+															  vk::AttachmentLoadOp::eDontCare,
+															  vk::AttachmentStoreOp::eDontCare,
+															  vk::ImageLayout::eDepthStencilAttachmentOptimal,
+															  vk::ImageLayout::eDepthStencilAttachmentOptimal });
+		}
+
+		vk::SubpassDescription subpass { {}, vk::PipelineBindPoint::eGraphics };
+		subpass.setColorAttachments(colorReferences);
+		if (key.depthFormat != vk::Format::eUndefined)
+		{
+			subpass.setPDepthStencilAttachment(&depthReference);
+		}
+
+		const vk::RenderPass renderPass = m_device.createRenderPass(vk::RenderPassCreateInfo { {}, attachments, subpass });
+		m_renderPasses.emplace(key, renderPass);
+		return renderPass;
+	}
+
+	vk::Framebuffer RenderGraph::getFramebuffer(const FramebufferKey& key)
+	{
+		const auto found = m_framebuffers.find(key);
+		if (found != m_framebuffers.end())
+		{
+			return found->second;
+		}
+
+		std::vector<vk::ImageView> views;
+		if (key.colorView)
+		{
+			views.push_back(key.colorView);
+		}
+		if (key.depthView)
+		{
+			views.push_back(key.depthView);
+		}
+
+		const vk::Framebuffer framebuffer =
+			m_device.createFramebuffer(vk::FramebufferCreateInfo { {}, key.renderPass, views, key.extent.width, key.extent.height, 1 });
+		m_framebuffers.emplace(key, framebuffer);
+		return framebuffer;
+	}
+
+	void RenderGraph::destroy(Retired& retired)
+	{
+		for (auto framebuffer : retired.framebuffers)
+		{
+			m_device.destroyFramebuffer(framebuffer);
+		}
+
+		for (auto& transient : retired.images)
+		{
+			m_device.destroyImageView(transient.view);
+			m_device.destroyImage(transient.image);
+		}
+
+		for (auto& memory : retired.memory)
+		{
+			m_allocator->free(memory);
+		}
+
+		retired = Retired {};
+	}
+
+	size_t RenderGraph::RenderPassKeyHash::operator()(const RenderPassKey& key) const
+	{
+		uint64_t hash = st::core::fnv1aOffsetBasis;
+		st::core::hashValue(hash, static_cast<uint64_t>(key.colorFormat));
+		st::core::hashValue(hash, static_cast<uint64_t>(key.colorLoadOp));
+		st::core::hashValue(hash, static_cast<uint64_t>(key.colorStoreOp));
+		st::core::hashValue(hash, static_cast<uint64_t>(key.depthFormat));
+		st::core::hashValue(hash, static_cast<uint64_t>(key.depthLoadOp));
+		st::core::hashValue(hash, static_cast<uint64_t>(key.depthStoreOp));
+		return static_cast<size_t>(hash);
+	}
+
+	size_t RenderGraph::FramebufferKeyHash::operator()(const FramebufferKey& key) const
+	{
+		uint64_t hash = st::core::fnv1aOffsetBasis;
+		st::core::hashValue(hash, st::core::handleValue(key.renderPass));
+		st::core::hashValue(hash, st::core::handleValue(key.colorView));
+		st::core::hashValue(hash, st::core::handleValue(key.depthView));
+		st::core::hashValue(hash, key.extent.width);
+		st::core::hashValue(hash, key.extent.height);
+		return static_cast<size_t>(hash);
+	}
+
+}
@@ -12,49 +12,24 @@
 
 
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <set>
+#include <thread>
+#include <utility>
 #include "StShader/Shader.hpp"
 #include "StMath/StMath.hpp"
 #include "Camera.hpp"
 
 struct UniformBufferObject
 {
-    st::math::Matrix4x4 model;
     st::math::Matrix4x4 view;
     st::math::Matrix4x4 proj;
 };
 
-struct Vertex
-{
-    st::math::Vector3 m_pos;
-    st::math::Vector2 m_texCoord;
-    st::math::Vector3 m_color;
-    st::math::Vector3 m_normal;
-
-
-    static vk::VertexInputBindingDescription getBindingDescription();
-
-    static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions();
-
-    bool operator==(const Vertex&) const = default;
-    auto operator<=>(const Vertex&) const = default;
-
-
-    friend std::ostream& operator<<(std::ostream& os, const Vertex& vertex)
-    {
-        os << "\nVertex(\n";
-        os << "\tPos    {" << vertex.m_pos.X       << ", " << vertex.m_pos.Y      << ", " << vertex.m_pos.Z  << "}\n";
-        os << "\tUV     {" << vertex.m_texCoord.X  << ", " << vertex.m_texCoord.Y << "}\n";
-        os << "\tColor  {" << vertex.m_color.X     << ", " << vertex.m_color.Y    << ", " << vertex.m_color.Z  << "}\n";
-        os << "\tNormal {" << vertex.m_normal.X    << ", " << vertex.m_normal.Y   << ", " << vertex.m_normal.Z << "}\n";
-        os << ")\n";
-        return os;
-    }
-};
-
 
 struct Texture
 {
@@ -62,22 +37,54 @@ struct Texture
 	uint32_t textureHeight;
 	uint32_t texChannels;
 
-	std::span<std::byte> pixels;
+	std::span<const std::byte> pixels;
 };
 
-static const std::vector<Vertex> planeVertexes {
-    {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-    {{ 0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}, 
-    {{ 0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}, 
-    {{-0.5f, 0.5f,  0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}} 
-};
+static constexpr const char* bindlessFragmentShader = "Assets/Shaders/frag_bindless.spv";
+static constexpr const char* objectVertexShader = "Assets/Shaders/vert_object.spv";
 
-static const std::vector<uint32_t> planeIndices = {
-    0, 1, 2, 2, 3, 0
+static constexpr float cameraNearPlane = 0.1F;
+static constexpr float cameraFarPlane = 100.0F;
+
+// Top field of the draw keys
+enum class ScenePass : uint32_t
+{
+	eObjects,
+	eInstanced
 };
 
 static st::renderer::Camera camera;
 
+// Centered on the bounding box, not minimal but cheap and stable
+static st::math::Vector4 computeBoundingSphere(std::span<const st::renderer::Vertex> vertices)
+{
+	if (vertices.empty())
+	{
+		return st::math::Vector4 {};
+	}
+
+	st::math::Vector3 min = vertices.front().m_pos;
+	st::math::Vector3 max = vertices.front().m_pos;
+	for (const auto& vertex : vertices)
+	{
+		min = st::math::Vector3 { std::min(min.X, vertex.m_pos.X), std::min(min.Y, vertex.m_pos.Y), std::min(min.Z, vertex.m_pos.Z) };
+		max = st::math::Vector3 { std::max(max.X, vertex.m_pos.X), std::max(max.Y, vertex.m_pos.Y), std::max(max.Z, vertex.m_pos.Z) };
+	}
+
+	const st::math::Vector3 center { (min.X + max.X) * 0.5F, (min.Y + max.Y) * 0.5F, (min.Z + max.Z) * 0.5F };
+
+	float radiusSquared = 0.0F;
+	for (const auto& vertex : vertices)
+	{
+		const float dx = vertex.m_pos.X - center.X;
+		const float dy = vertex.m_pos.Y - center.Y;
+		const float dz = vertex.m_pos.Z - center.Z;
+		radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+	}
+
+	return st::math::Vector4 { center, std::sqrt(radiusSquared) };
+}
+
 
 
 void printLog(const std::string &message)
@@ -103,21 +110,37 @@ QueueFamilyIndices QueueFamilyIndices::findQueueFamilies(const vk::PhysicalDevic
 	int i = 0;
 	for (const auto &queueFamily : queueFamilies)
 	{
-		if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+		if (!indices.isComplete())
 		{
-			indices.graphicsFamily = i;
+			// Culling is dispatched in the scene command buffer, so the graphics family must run compute
+			if ((queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute))
+			{
+				indices.graphicsFamily = i;
+			}
+
+			// Headless rendering never presents
+			if (surface && device.getSurfaceSupportKHR(i, surface))
+			{
+				indices.presentFamily = i;
+			}
+			else if (!surface && indices.graphicsFamily.has_value())
+			{
+				indices.presentFamily = indices.graphicsFamily;
+			}
 		}
 
-		VkBool32 presentSupport = device.getSurfaceSupportKHR(i, surface);
+		// Prefer a DMA only family, then any transfer family without graphics (async compute)
+		const bool transfer = static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eTransfer);
+		const bool graphics = static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics);
+		const bool compute = static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eCompute);
 
-		if (presentSupport)
+		if (transfer && !graphics && !compute)
 		{
-			indices.presentFamily = i;
+			indices.transferFamily = i;
 		}
-
-		if (indices.isComplete())
+		else if (transfer && !graphics && !indices.transferFamily.has_value())
 		{
-			break;
+			indices.transferFamily = i;
 		}
 
 		i++;
@@ -224,17 +247,56 @@ Public Api
 
 void VulkanRenderer::initRenderer(vk::Instance &instance,
                                   vk::SurfaceKHR &surface,
-                                  VulkanRendererValidationLayerLevel debugLevel)
+                                  VulkanRendererValidationLayerLevel debugLevel,
+                                  const st::renderer::PresentationPolicy& presentationPolicy)
 {
 	m_instance = instance;
 	m_surface = surface;
 
 	m_enableValidationLayers = debugLevel;
+	setPresentationPolicy(presentationPolicy);
 
 	// initWindow();
 	initVulkan();
 }
 
+void VulkanRenderer::initHeadless(vk::Instance& instance,
+								  uint32_t width,
+								  uint32_t height,
+								  VulkanRendererValidationLayerLevel debugLevel,
+								  const st::renderer::PresentationPolicy& presentationPolicy)
+{
+	m_instance = instance;
+	m_surface = nullptr;
+	m_swapchainWidth = width;
+	m_swapchainHeight = height;
+
+	m_enableValidationLayers = debugLevel;
+	setPresentationPolicy(presentationPolicy);
+
+	initVulkan();
+}
+
+bool VulkanRenderer::isHeadless() const
+{
+	return !m_surface;
+}
+
+void VulkanRenderer::captureFrame(const std::string& path)
+{
+	if (!isHeadless())
+	{
+		throw std::runtime_error("frame capture requires headless rendering!");
+	}
+
+	m_frameCapture.request(path);
+}
+
+void VulkanRenderer::waitForCaptures()
+{
+	m_frameCapture.waitIdle();
+}
+
 void VulkanRenderer::setupSwapchain(uint32_t width, uint32_t height)
 {
 	m_swapchainWidth = width;
@@ -243,6 +305,73 @@ void VulkanRenderer::setupSwapchain(uint32_t width, uint32_t height)
 
 void VulkanRenderer::resizeFramebuffer(uint32_t width, uint32_t height)
 {
+	// Recreated after the next present, the frame in progress still targets the current size
+	m_swapchainWidth = width;
+	m_swapchainHeight = height;
+	m_framebufferResized = true;
+}
+
+void VulkanRenderer::setPresentationPolicy(const st::renderer::PresentationPolicy& policy)
+{
+	const uint32_t framesInFlight = std::clamp(policy.framesInFlight, 1U, MAX_FRAMES_IN_FLIGHT);
+	m_presentationPolicy = policy;
+	m_presentationPolicy.framesInFlight = framesInFlight;
+
+	// Before initialization createSwapChain picks the policy up
+	if (!m_device)
+	{
+		m_framesInFlight = framesInFlight;
+		return;
+	}
+
+	if (framesInFlight != m_framesInFlight)
+	{
+		// Slots leaving the rotation still own deferred work, every slot is drained once
+		if (m_device.waitForFences(m_inFlightFences, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+		{
+			throw std::runtime_error("failed to wait for frames in flight!");
+		}
+
+		m_transferContext.collect();
+		for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+		{
+			m_frameArenas.at(frame).reset();
+			m_frameDescriptorAllocators.at(frame).reset();
+			m_geometryHeap.beginFrame(frame);
+			m_gpuCulling.beginFrame(frame);
+			m_renderGraph.beginFrame(frame);
+			m_parallelRecorder.beginFrame(frame);
+			m_frameCapture.collect(frame);
+			destroyRetiredSwapChains(frame);
+		}
+
+		m_framesInFlight = framesInFlight;
+		currentFrame = 0;
+		m_lastSubmittedFrame = m_framesInFlight - 1;
+	}
+
+	// The frame cap needs nothing recreated, offscreen targets do not depend on the policy
+	if (isHeadless())
+	{
+		return;
+	}
+
+	const SwapChainSupportDetails swapChainSupport = SwapChainSupportDetails::querySwapChainSupport(m_physicalDevice, m_surface);
+	if (m_presentationPolicy.choosePresentMode(swapChainSupport.presentModes) != m_presentMode ||
+		m_presentationPolicy.chooseImageCount(swapChainSupport.capabilities) != m_requestedImageCount)
+	{
+		recreateSwapChain();
+	}
+}
+
+const st::renderer::PresentationPolicy& VulkanRenderer::getPresentationPolicy() const
+{
+	return m_presentationPolicy;
+}
+
+uint32_t VulkanRenderer::getMinImageCount() const
+{
+	return m_requestedImageCount;
 }
 /*--------------------------------------------------------------------------------*/
 
@@ -286,28 +415,84 @@ vk::RenderPass VulkanRenderer::getUiRenderPass() const
 }
 
 
+void VulkanRenderer::setViewMatrix(const st::math::Matrix4x4& view)
+{
+	m_viewMatrix = view;
+}
+
 void VulkanRenderer::startFrame()
 {
+	// Sleeping ahead of the fence wait keeps fenceWaitTime a measure of GPU backpressure only
+	if (m_presentationPolicy.frameRateCap > 0.0F && m_frameStart != std::chrono::steady_clock::time_point {})
+	{
+		const std::chrono::duration<float> framePeriod { 1.0F / m_presentationPolicy.frameRateCap };
+		std::this_thread::sleep_until(m_frameStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(framePeriod));
+	}
+
+	// The only CPU wait of the frame, it returns as soon as the GPU released this frame slot
+	const auto waitStart = std::chrono::steady_clock::now();
     auto resultFence = m_device.waitForFences(m_inFlightFences.at(currentFrame), VK_TRUE, UINT64_MAX);
 	if (resultFence != vk::Result::eSuccess)
 	{
 		//std::cout << "syf" << std::endl;
 	}
+	const auto waitEnd = std::chrono::steady_clock::now();
 
-	auto [result, imageIndex] = m_device.acquireNextImageKHR(m_swapChain, UINT64_MAX, m_imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE);
-	currentFrameResult = result;
-	currentImageIndex = imageIndex;
-
-
-	updateUniformBuffer(currentFrame);
-
+	if (m_frameStart != std::chrono::steady_clock::time_point {})
+	{
+		m_frameTimings.frameTime = std::chrono::duration<float, std::milli>(waitStart - m_frameStart).count();
+		m_frameTimings.averageFrameTime = m_frameTimings.averageFrameTime == 0.0F
+											  ? m_frameTimings.frameTime
+											  : m_frameTimings.averageFrameTime * 0.95F + m_frameTimings.frameTime * 0.05F;
+	}
+	m_frameTimings.fenceWaitTime = std::chrono::duration<float, std::milli>(waitEnd - waitStart).count();
+	m_frameStart = waitStart;
+
+	m_transferContext.collect();
+	m_frameArenas.at(currentFrame).reset();
+	m_frameDescriptorAllocators.at(currentFrame).reset();
+	m_geometryHeap.beginFrame(currentFrame);
+	m_gpuCulling.beginFrame(currentFrame);
+	m_renderGraph.beginFrame(currentFrame);
+	m_parallelRecorder.beginFrame(currentFrame);
+	m_frameCapture.collect(currentFrame);
+	destroyRetiredSwapChains(currentFrame);
+
+	// A minimized window has no area for a swapchain, frames are skipped until it has one again
+	m_frameSkipped = false;
+	if (m_swapChainDeferred)
+	{
+		recreateSwapChain();
+		m_frameSkipped = m_swapChainDeferred;
+	}
 
-	m_device.resetFences(m_inFlightFences.at(currentFrame));
+	// Each slot owns its offscreen image, the fence above already guards it
+	if (isHeadless())
+	{
+		currentFrameResult = vk::Result::eSuccess;
+		currentImageIndex = currentFrame;
+	}
 
-	m_commandBuffers[currentFrame].reset(vk::CommandBufferResetFlags {});
-	recordCommandBuffer(m_commandBuffers[currentFrame], currentImageIndex);
+	// A failed acquire leaves the semaphore unsignaled, it is reused with the new swapchain.
+	// A suboptimal image is still rendered, the swapchain is replaced after its present.
+	while (!isHeadless() && !m_frameSkipped)
+	{
+		try
+		{
+			auto [result, imageIndex] = m_device.acquireNextImageKHR(m_swapChain, UINT64_MAX, m_imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE);
+			currentFrameResult = result;
+			currentImageIndex = imageIndex;
+			break;
+		}
+		catch (const vk::OutOfDateKHRError&)
+		{
+			recreateSwapChain();
+			m_frameSkipped = m_swapChainDeferred;
+		}
+	}
 
 
+	updateUniformBuffer(currentFrame);
 }
 
 
@@ -337,24 +522,97 @@ void VulkanRenderer::endUiRendering(vk::CommandBuffer& uiCommandBuffer )
 
 void VulkanRenderer::endFrame()
 {
-	m_device.resetFences(m_inFlightFences.at(currentFrame));
+	// The draws of a skipped frame are dropped, its fence was not reset and stays signaled
+	if (m_frameSkipped)
+	{
+		m_transferContext.flush();
+		m_meshDraws.clear();
+		m_frameInstances.clear();
+		m_objectDraws.clear();
+		m_objectModels.clear();
+		return;
+	}
+
+	// Scene recording is deferred to here so meshes and draws submitted during the frame are included
+	m_transferContext.flush();
+	updateInstanceBuffer(currentFrame);
+
+	// Until the cull pipelines have compiled the draws are recorded directly in a single pass
+	const bool gpuCulling = m_gpuCulling.isReady() && !m_meshDraws.empty();
+	buildRenderGraph(gpuCulling);
+
+	m_gpuCulling.prepare(currentFrame,
+						 m_instanceBuffers.at(currentFrame),
+						 m_meshDraws,
+						 m_meshes,
+						 static_cast<uint32_t>(m_frameInstances.size()),
+						 m_frameDescriptorAllocators.at(currentFrame),
+						 m_cullView);
+
+	// Every object transform of the frame in one pass, the vertex shader no longer multiplies matrices
+	m_objectTransforms.resize(m_objectModels.size());
+	st::math::multiplyBatch(m_viewProjection, m_objectModels, m_objectTransforms);
+
+	m_commandBuffers[currentFrame].reset(vk::CommandBufferResetFlags {});
+	recordCommandBuffer(m_commandBuffers[currentFrame]);
+
+	m_meshDraws.clear();
+	m_frameInstances.clear();
+	m_objectDraws.clear();
+	m_objectModels.clear();
+
 	vk::PipelineStageFlags waitDestinationStageMask{vk::PipelineStageFlagBits::eColorAttachmentOutput};
 
-	vk::SubmitInfo submitInfo(m_imageAvailableSemaphores[currentFrame],
-								waitDestinationStageMask,
-								m_commandBuffers[currentFrame],
-								m_uiAvailableSemaphores[currentFrame]);
+	std::array<vk::Semaphore, 2> waitSemaphores { m_imageAvailableSemaphores[currentFrame], m_transferContext.getTimelineSemaphore() };
+	std::array<vk::PipelineStageFlags, 2> waitStages { waitDestinationStageMask, st::renderer::TransferContext::consumerStages };
+	std::array<uint64_t, 2> waitValues { 0, m_transferContext.getLastSubmitted() };
+	std::array<uint64_t, 1> signalValues { 0 };
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo { waitValues, signalValues };
+
+	// Scene and UI in one batch, the render pass dependencies order the UI pass after the scene.
+	// The fence is reset right before the submit that signals it, an earlier exit would leave
+	// the frame slot waiting forever.
+	std::pmr::vector<vk::CommandBuffer> commandBuffers { { m_commandBuffers[currentFrame], m_uiCommandBuffers[currentFrame] },
+														 &m_frameArenas.at(currentFrame) };
+	vk::SubmitInfo submitInfo(waitSemaphores,
+								waitStages,
+								commandBuffers,
+								m_renderFinishedSemaphores[currentFrame]);
+	submitInfo.setPNext(&timelineInfo);
 
-	m_graphicsQueue.submit(submitInfo, m_inFlightFences[currentFrame]);
+	// Nothing was acquired and nothing is presented, only the transfer timeline is waited on
+	if (isHeadless())
+	{
+		const vk::CommandBuffer captureCommandBuffer =
+			m_frameCapture.record(currentFrame, m_swapChainImages[currentImageIndex], m_swapChainImageFormat, m_swapChainExtent);
+		if (captureCommandBuffer)
+		{
+			commandBuffers.push_back(captureCommandBuffer);
+			submitInfo.setCommandBuffers(commandBuffers);
+		}
+
+		submitInfo.setWaitSemaphoreCount(1).setPWaitSemaphores(&waitSemaphores[1]).setPWaitDstStageMask(&waitStages[1]);
+		submitInfo.setSignalSemaphoreCount(0).setPSignalSemaphores(nullptr);
+		timelineInfo.setWaitSemaphoreValueCount(1).setPWaitSemaphoreValues(&waitValues[1]);
+		timelineInfo.setSignalSemaphoreValueCount(0).setPSignalSemaphoreValues(nullptr);
+	}
 
-	auto resultFence = m_device.waitForFences(m_inFlightFences.at(currentFrame), VK_TRUE, UINT64_MAX);
 	m_device.resetFences(m_inFlightFences.at(currentFrame));
-	vk::SubmitInfo uiSubmitInfo(m_uiAvailableSemaphores[currentFrame],
-								waitDestinationStageMask,
-								m_uiCommandBuffers[currentFrame],
-								m_renderFinishedSemaphores[currentFrame]);
+	m_graphicsQueue.submit(submitInfo, m_inFlightFences[currentFrame]);
+	m_lastSubmittedFrame = currentFrame;
+
+	if (isHeadless())
+	{
+		if (m_framebufferResized)
+		{
+			m_framebufferResized = false;
+			recreateSwapChain();
+		}
 
-	m_graphicsQueue.submit(uiSubmitInfo, m_inFlightFences[currentFrame]);
+		currentFrame = (currentFrame + 1) % m_framesInFlight;
+		return;
+	}
 
 
 	vk::PresentInfoKHR presentInfo{m_renderFinishedSemaphores[currentFrame], m_swapChain, currentImageIndex};
@@ -363,32 +621,151 @@ void VulkanRenderer::endFrame()
 	{
 		currentFrameResult = m_presentQueue.presentKHR(presentInfo);
 	}
-	catch (std::exception const& exc)
+	catch (const vk::OutOfDateKHRError&)
 	{
-		std::cerr << exc.what();
-		//TODO - Fix
-		//recreateSwapChain();
+		currentFrameResult = vk::Result::eErrorOutOfDateKHR;
 	}
 
 	if (currentFrameResult == vk::Result::eErrorOutOfDateKHR || currentFrameResult == vk::Result::eSuboptimalKHR || m_framebufferResized)
 	{
 		m_framebufferResized = false;
-		//TODO - Fix
-		//recreateSwapChain();
+		recreateSwapChain();
 	}
 	else if (currentFrameResult != vk::Result::eSuccess)
 	{
 		throw std::runtime_error("failed to present swap chain image!");
 	}
 
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	currentFrame = (currentFrame + 1) % m_framesInFlight;
+}
+
+void VulkanRenderer::setMeshPermutation(const st::renderer::MeshShaderPermutation& permutation)
+{
+	m_graphicsPipeline = m_pipelineManager.request(meshPipelineDescription(permutation));
+	m_objectPipeline = m_pipelineManager.request(objectPipelineDescription(permutation));
+}
+
+st::renderer::MeshHandle VulkanRenderer::createMesh(std::span<const st::renderer::Vertex> vertices, std::span<const uint32_t> indices)
+{
+	st::renderer::GpuMesh mesh;
+	mesh.geometry = m_geometryHeap.add(vertices, indices);
+	mesh.boundingSphere = computeBoundingSphere(vertices);
+
+	m_meshes.push_back(mesh);
+	return static_cast<st::renderer::MeshHandle>(m_meshes.size() - 1);
+}
+
+void VulkanRenderer::destroyMesh(st::renderer::MeshHandle mesh)
+{
+	// Handles are not reused, the geometry is freed once no frame in flight reads it
+	st::renderer::GpuMesh& gpuMesh = m_meshes.at(mesh);
+	m_geometryHeap.release(gpuMesh.geometry);
+	gpuMesh = st::renderer::GpuMesh {};
+}
+
+void VulkanRenderer::drawMesh(st::renderer::MeshHandle mesh, const st::math::Matrix4x4& model, uint32_t materialIndex)
+{
+	m_objectDraws.push_back({ mesh, materialIndex });
+	m_objectModels.push_back(model);
+}
+
+st::renderer::TextureHandle VulkanRenderer::createTexture(uint32_t width, uint32_t height, std::span<const std::byte> rgbaPixels)
+{
+	// Without descriptor indexing only the default texture is bound
+	if (!m_bindlessTextures.isEnabled())
+	{
+		return 0;
+	}
+
+	Texture texture { width, height, 4, rgbaPixels };
+
+	st::renderer::GpuTexture gpuTexture;
+	createTextureImage(texture, gpuTexture.image, gpuTexture.memory);
+	createTextureImageView(gpuTexture.image, gpuTexture.view);
+	m_textures.push_back(gpuTexture);
+
+	return m_bindlessTextures.add(gpuTexture.view, m_textureSampler);
+}
+
+st::renderer::TextureHandle VulkanRenderer::createTexture(const std::string& path)
+{
+	int texWidth = 0;
+	int texHeight = 0;
+	int texChannels = 0;
+	stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	if (pixels == nullptr)
+	{
+		throw std::runtime_error("failed to load texture image!");
+	}
+
+	std::span<const std::byte> pixelsByte { reinterpret_cast<const std::byte*>(pixels), static_cast<size_t>(texWidth * texHeight * 4) };
+	st::renderer::TextureHandle handle = createTexture(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), pixelsByte);
+	stbi_image_free(pixels);
+
+	return handle;
+}
+
+bool VulkanRenderer::isBindlessEnabled() const
+{
+	return m_bindlessTextures.isEnabled();
+}
+
+const st::renderer::DeviceFeatures& VulkanRenderer::getDeviceFeatures() const
+{
+	return m_deviceFeatures;
+}
+
+void VulkanRenderer::drawMeshInstanced(st::renderer::MeshHandle mesh, std::span<const st::renderer::InstanceData> instances)
+{
+	if (instances.empty())
+	{
+		return;
+	}
+
+	m_meshDraws.push_back({ mesh, static_cast<uint32_t>(m_frameInstances.size()), static_cast<uint32_t>(instances.size()) });
+
+	for (const auto& instance : instances)
+	{
+		st::renderer::InstanceData& gpuInstance = m_frameInstances.emplace_back(instance);
+		gpuInstance.m_model.convertToColumnMajor();
+	}
+}
+
+st::renderer::DrawStatistics VulkanRenderer::getDrawStatistics() const
+{
+	return m_drawStatistics;
+}
+
+FrameTimings VulkanRenderer::getFrameTimings() const
+{
+	return m_frameTimings;
+}
+
+st::renderer::RenderGraphStatistics VulkanRenderer::getRenderGraphStatistics() const
+{
+	return m_renderGraph.getStatistics();
+}
+
+st::core::FrameArenaStatistics VulkanRenderer::getFrameArenaStatistics() const
+{
+	return m_frameArenas.at(m_lastSubmittedFrame).getStatistics();
+}
+
+st::renderer::MemoryStatistics VulkanRenderer::getMemoryStatistics() const
+{
+	return m_memoryAllocator.getStatistics();
 }
 
 Renderer_API vk::CommandBuffer VulkanRenderer::beginSingleTimeCommands()
 { 
 	vk::CommandBufferAllocateInfo allocInfo { m_commandPool, vk::CommandBufferLevel::ePrimary, 1 };
 
-	vk::CommandBuffer commandBuffer = m_device.allocateCommandBuffers(allocInfo).front();
+	// Into a single handle, the enhanced overload returns a std::vector
+	vk::CommandBuffer commandBuffer;
+	if (m_device.allocateCommandBuffers(&allocInfo, &commandBuffer) != vk::Result::eSuccess)
+	{
+		throw std::runtime_error("failed to allocate command buffer!");
+	}
 
 	vk::CommandBufferBeginInfo beginInfo { vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
 
@@ -405,6 +782,11 @@ Renderer_API void VulkanRenderer::endSingleTimeCommands(vk::CommandBuffer comman
 	m_device.freeCommandBuffers(m_commandPool, commandBuffer);
 }
 
+VulkanRenderer::~VulkanRenderer()
+{
+	cleanup();
+}
+
 /*--------------------------------------------------------------------------------*/
 
 void VulkanRenderer::initVulkan()
@@ -423,20 +805,22 @@ void VulkanRenderer::initVulkan()
 	createFramebuffer();
 
 
-	createVertexBuffer();
-	createIndexBuffer();
+	createDescriptorSets();
 	createCommandBuffers();
 	createSyncObjects();
 
 	updateGraphicPipelineRecourses();
 
+	m_transferContext.flush();
+
 }
 
 bool VulkanRenderer::checkDeviceExtensionSupport(const vk::PhysicalDevice &device)
 {
 	const std::vector<vk::ExtensionProperties> availableExtensions = device.enumerateDeviceExtensionProperties();
 
-	std::set<std::string> requiredExtensions(m_deviceExtensions.begin(), m_deviceExtensions.end());
+	const std::vector<const char*> deviceExtensions = getRequiredDeviceExtensions();
+	std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
 	for (const auto &extension : availableExtensions)
 	{
@@ -448,6 +832,57 @@ bool VulkanRenderer::checkDeviceExtensionSupport(const vk::PhysicalDevice &devic
 
 void VulkanRenderer::cleanup()
 {
+	if (!m_device)
+	{
+		return;
+	}
+
+	m_device.waitIdle();
+	for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+	{
+		m_frameCapture.collect(frame);
+	}
+	m_frameCapture.shutdown();
+	m_pipelineManager.shutdown();
+	m_gpuCulling.shutdown();
+	m_renderGraph.shutdown();
+	m_parallelRecorder.shutdown();
+	m_transferContext.shutdown();
+
+	m_descriptorCache.clear();
+	m_descriptorAllocator.shutdown();
+	for (auto& frameDescriptors : m_frameDescriptorAllocators)
+	{
+		frameDescriptors.shutdown();
+	}
+
+	m_uniformRing.shutdown();
+
+	m_meshes.clear();
+	m_geometryHeap.shutdown();
+
+	for (size_t i = 0; i < m_instanceBuffers.size(); i++)
+	{
+		m_device.destroyBuffer(m_instanceBuffers[i]);
+		m_memoryAllocator.free(m_instanceBuffersMemory[i]);
+	}
+
+	for (auto& texture : m_textures)
+	{
+		m_device.destroyImageView(texture.view);
+		m_device.destroyImage(texture.image);
+		m_memoryAllocator.free(texture.memory);
+	}
+	m_textures.clear();
+	m_bindlessTextures.shutdown();
+
+	m_device.destroyImageView(m_textureImageView);
+	m_device.destroyImage(m_textureImage);
+	m_memoryAllocator.free(textureImageMemory);
+
+	cleanupSwapChain();
+
+	m_memoryAllocator.shutdown();
 }
 
 void VulkanRenderer::createDebugMessenger()
@@ -490,20 +925,34 @@ void VulkanRenderer::pickPhysicalDevice()
 		throw std::runtime_error("Failed to find GPU's with Vulkan support!");
 	}
 
+	// Every device providing the required functionality is ranked, integrated GPUs are
+	// taken when no discrete one is suitable
+	uint64_t bestScore = 0;
 	for (const auto &device : devices)
 	{
-		// Check if devices contain all required functionality
-		// Pick first that fullfil condtion
-		if (device.getProperties().deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
+		if (!isDeviceSuitable(device))
 		{
-			if (isDeviceSuitable(device))
-			{
-				printLog("Pick physical device: " + std::string(device.getProperties().deviceName.data(), device.getProperties().deviceName.size()));
-				m_physicalDevice = device;
-				break;
-			}
+			continue;
+		}
+
+		const st::renderer::DeviceProfile profile = st::renderer::DeviceProfile::query(device);
+		const uint64_t score = profile.score();
+		printLog("Candidate physical device: " + profile.name + ", score " + std::to_string(score));
+
+		if (!m_physicalDevice || score > bestScore)
+		{
+			m_physicalDevice = device;
+			m_deviceFeatures = profile.features;
+			bestScore = score;
 		}
 	}
+
+	if (!m_physicalDevice)
+	{
+		throw std::runtime_error("Failed to find a suitable GPU!");
+	}
+
+	printLog("Pick physical device: " + std::string(m_physicalDevice.getProperties().deviceName.data()));
 }
 
 bool VulkanRenderer::isDeviceSuitable(const vk::PhysicalDevice &device)
@@ -513,14 +962,17 @@ bool VulkanRenderer::isDeviceSuitable(const vk::PhysicalDevice &device)
 
 	bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-	bool swapChainAdequate = false;
-	if (extensionsSupported)
+	bool swapChainAdequate = isHeadless();
+	if (extensionsSupported && !isHeadless())
 	{
 		SwapChainSupportDetails swapChainSupport = SwapChainSupportDetails::querySwapChainSupport(device, m_surface);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	return indices.isComplete() && extensionsSupported && swapChainAdequate;
+	auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	bool timelineSemaphoreSupported = features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
+
+	return indices.isComplete() && extensionsSupported && swapChainAdequate && timelineSemaphoreSupported;
 }
 
 void VulkanRenderer::createLogicalDevice()
@@ -529,6 +981,10 @@ void VulkanRenderer::createLogicalDevice()
 	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
 
 	std::set<uint32_t> uniqueQueueFamilies{indices.graphicsFamily.value(), indices.presentFamily.value()};
+	if (indices.transferFamily.has_value())
+	{
+		uniqueQueueFamilies.insert(indices.transferFamily.value());
+	}
 
 	float queuePriority = 1.0F;
 	for (const auto &queueFamily : uniqueQueueFamilies)
@@ -538,7 +994,34 @@ void VulkanRenderer::createLogicalDevice()
 		queueCreateInfos.push_back(deviceQueueCreateInfo);
 	}
 
-	vk::DeviceCreateInfo createInfo{vk::DeviceCreateFlags{}, queueCreateInfos, {}, m_deviceExtensions, {}};
+	// Optional features are enabled as negotiated in pickPhysicalDevice, the paths using them
+	// read m_deviceFeatures
+	vk::PhysicalDeviceFeatures deviceFeatures {};
+	deviceFeatures.multiDrawIndirect = m_deviceFeatures.multiDrawIndirect;
+
+	vk::PhysicalDeviceVulkan12Features vulkan12Features {};
+	vulkan12Features.timelineSemaphore = true;
+	vulkan12Features.drawIndirectCount = m_deviceFeatures.drawIndirectCount;
+
+	// Bindless textures fall back to the single texture binding when the device lacks descriptor indexing
+	m_bindlessSupported = m_deviceFeatures.descriptorIndexing;
+	if (m_bindlessSupported)
+	{
+		st::renderer::BindlessTextures::enableFeatures(vulkan12Features);
+	}
+
+	std::vector<const char*> deviceExtensions = getRequiredDeviceExtensions();
+	if (m_deviceFeatures.memoryBudget)
+	{
+		deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	// Records the queues actually created, nothing runs on a compute only family yet
+	m_deviceFeatures.dedicatedTransferQueue = indices.transferFamily.has_value();
+	m_deviceFeatures.asyncComputeQueue = false;
+
+	vk::DeviceCreateInfo createInfo{vk::DeviceCreateFlags{}, queueCreateInfos, {}, deviceExtensions, &deviceFeatures};
+	createInfo.setPNext(&vulkan12Features);
 
 	if (m_enableValidationLayers == VulkanRendererValidationLayerLevel::eEnabled)
 	{
@@ -554,22 +1037,31 @@ void VulkanRenderer::createLogicalDevice()
 
 	m_graphicsQueue = m_device.getQueue(indices.graphicsFamily.value(), 0);
 	m_presentQueue = m_device.getQueue(indices.presentFamily.value(), 0);
+
+	// Without a dedicated family uploads share the graphics queue
+	const uint32_t transferFamily = indices.transferFamily.value_or(indices.graphicsFamily.value());
+	m_transferQueue = m_device.getQueue(transferFamily, 0);
+
+	m_memoryAllocator.init(m_physicalDevice, m_device, m_deviceFeatures.memoryBudget);
+	m_transferContext.init(m_physicalDevice, m_device, m_transferQueue, transferFamily, indices.graphicsFamily.value(), m_memoryAllocator);
+	m_geometryHeap.init(m_device, m_memoryAllocator, m_transferContext, MAX_FRAMES_IN_FLIGHT);
+	m_renderGraph.init(m_device, m_memoryAllocator, MAX_FRAMES_IN_FLIGHT);
 }
 
-void VulkanRenderer::createSwapChain()
+void VulkanRenderer::createSwapChain(vk::SwapchainKHR oldSwapChain)
 {
+	if (isHeadless())
+	{
+		createOffscreenTargets();
+		return;
+	}
+
 	SwapChainSupportDetails swapChainSupport = SwapChainSupportDetails::querySwapChainSupport(m_physicalDevice, m_surface);
 
 	vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-	vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+	vk::PresentModeKHR presentMode = m_presentationPolicy.choosePresentMode(swapChainSupport.presentModes);
 	vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
-
-	// TODO - Image count == 2?
-	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-	if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
-	{
-		imageCount = swapChainSupport.capabilities.maxImageCount;
-	}
+	uint32_t imageCount = m_presentationPolicy.chooseImageCount(swapChainSupport.capabilities);
 
 	QueueFamilyIndices indices = QueueFamilyIndices::findQueueFamilies(m_physicalDevice, m_surface);
 
@@ -591,42 +1083,163 @@ void VulkanRenderer::createSwapChain()
 										  vk::CompositeAlphaFlagBitsKHR::eOpaque,
 										  presentMode,
 										  VK_TRUE,
-										  VK_NULL_HANDLE};
+										  oldSwapChain};
 
 	m_swapChain = m_device.createSwapchainKHR(createInfo);
 	m_swapChainImages = m_device.getSwapchainImagesKHR(m_swapChain);
 	m_uiSwapchainImages = m_device.getSwapchainImagesKHR(m_swapChain);
 	m_swapChainImageFormat = surfaceFormat.format;
 	m_swapChainExtent = extent;
+	m_presentMode = presentMode;
+	m_requestedImageCount = imageCount;
 
 	createSwapchainImageViews();
 }
 
-vk::SurfaceFormatKHR VulkanRenderer::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &availableFormats) const
+void VulkanRenderer::createOffscreenTargets()
 {
-	for (const auto &availableFormat : availableFormats)
+	// Stands in for the swapchain, one image per frame slot
+	m_swapChainImageFormat = vk::Format::eR8G8B8A8Srgb;
+	m_swapChainExtent = vk::Extent2D { m_swapchainWidth, m_swapchainHeight };
+	m_requestedImageCount = MAX_FRAMES_IN_FLIGHT;
+
+	m_swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	m_offscreenImageMemory.resize(MAX_FRAMES_IN_FLIGHT);
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 	{
-		if (availableFormat.format == vk::Format::eB8G8R8A8Srgb &&
-			availableFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
-		{
-			return availableFormat;
-		}
+		createImage(m_swapChainExtent.width,
+					m_swapChainExtent.height,
+					m_swapChainImageFormat,
+					vk::ImageTiling::eOptimal,
+					vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+					vk::MemoryPropertyFlagBits::eDeviceLocal,
+					m_swapChainImages[i],
+					m_offscreenImageMemory[i]);
 	}
+	m_uiSwapchainImages = m_swapChainImages;
 
-	return availableFormats[0];
+	createSwapchainImageViews();
+}
+
+vk::ImageLayout VulkanRenderer::getFinalColorLayout() const
+{
+	// Offscreen targets end ready for readback
+	return isHeadless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+}
+
+std::vector<const char*> VulkanRenderer::getRequiredDeviceExtensions() const
+{
+	if (isHeadless())
+	{
+		return {};
+	}
+	return std::vector<const char*>(m_deviceExtensions.begin(), m_deviceExtensions.end());
+}
+
+void VulkanRenderer::recreateSwapChain()
+{
+	// Nothing can be created for a surface without area, the current swapchain is kept and the
+	// recreation retried by every startFrame until the surface has an extent again
+	const vk::Extent2D extent = isHeadless() ? vk::Extent2D { m_swapchainWidth, m_swapchainHeight }
+											 : chooseSwapExtent(m_physicalDevice.getSurfaceCapabilitiesKHR(m_surface));
+	m_swapChainDeferred = extent.width == 0 || extent.height == 0;
+	if (m_swapChainDeferred)
+	{
+		return;
+	}
+
+	// Render passes only depend on the format, which the surface keeps. Frames in flight keep
+	// using the retired resources, they are destroyed once the last submitted frame completed.
+	RetiredSwapChain& retired = m_retiredSwapChains.at(m_lastSubmittedFrame).emplace_back(retireSwapChain());
+	m_renderGraph.invalidateFramebuffers(m_lastSubmittedFrame);
+
+	// Passing the old swapchain lets images already queued for presentation be shown
+	createSwapChain(retired.swapChain);
+	createFramebuffer();
+}
+
+VulkanRenderer::RetiredSwapChain VulkanRenderer::retireSwapChain()
+{
+	RetiredSwapChain retired;
+	retired.swapChain = std::exchange(m_swapChain, nullptr);
+
+	retired.framebuffers = std::move(m_uiSwapchainFramebuffers);
+	m_uiSwapchainFramebuffers.clear();
+
+	retired.imageViews = std::move(m_swapChainImageViews);
+	retired.imageViews.insert(retired.imageViews.end(), m_uiSwapchainImageViews.begin(), m_uiSwapchainImageViews.end());
+	m_swapChainImageViews.clear();
+	m_uiSwapchainImageViews.clear();
+
+	// Offscreen images are owned by the renderer, swapchain images by the swapchain
+	if (isHeadless())
+	{
+		retired.offscreenImages = std::move(m_swapChainImages);
+		retired.offscreenImageMemory = std::move(m_offscreenImageMemory);
+		m_offscreenImageMemory.clear();
+	}
+	m_swapChainImages.clear();
+	m_uiSwapchainImages.clear();
+
+	return retired;
+}
+
+void VulkanRenderer::destroySwapChain(RetiredSwapChain& retired)
+{
+	for (auto framebuffer : retired.framebuffers)
+	{
+		m_device.destroyFramebuffer(framebuffer);
+	}
+
+	for (auto imageView : retired.imageViews)
+	{
+		m_device.destroyImageView(imageView);
+	}
+
+	for (size_t i = 0; i < retired.offscreenImages.size(); ++i)
+	{
+		m_device.destroyImage(retired.offscreenImages[i]);
+		m_memoryAllocator.free(retired.offscreenImageMemory[i]);
+	}
+
+	if (retired.swapChain)
+	{
+		m_device.destroySwapchainKHR(retired.swapChain);
+	}
+}
+
+void VulkanRenderer::destroyRetiredSwapChains(uint32_t frameIndex)
+{
+	for (auto& retired : m_retiredSwapChains.at(frameIndex))
+	{
+		destroySwapChain(retired);
+	}
+	m_retiredSwapChains.at(frameIndex).clear();
+}
+
+void VulkanRenderer::cleanupSwapChain()
+{
+	for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+	{
+		destroyRetiredSwapChains(frame);
+	}
+
+	RetiredSwapChain current = retireSwapChain();
+	destroySwapChain(current);
 }
 
-vk::PresentModeKHR VulkanRenderer::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &availablePresentModes) const
+vk::SurfaceFormatKHR VulkanRenderer::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &availableFormats) const
 {
-	for (const auto &availablePresentMode : availablePresentModes)
+	for (const auto &availableFormat : availableFormats)
 	{
-		if (availablePresentMode == vk::PresentModeKHR::eMailbox)
+		if (availableFormat.format == vk::Format::eB8G8R8A8Srgb &&
+			availableFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
 		{
-			return availablePresentMode;
+			return availableFormat;
 		}
 	}
 
-	return vk::PresentModeKHR(VK_PRESENT_MODE_FIFO_KHR);
+	return availableFormats[0];
 }
 
 vk::Extent2D VulkanRenderer::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR &capabilities) const
@@ -694,10 +1307,12 @@ void VulkanRenderer::createRenderPass()
 											  vk::AttachmentLoadOp::eDontCare,
 											  vk::AttachmentStoreOp::eDontCare,
 											  vk::ImageLayout::eUndefined,
-											  vk::ImageLayout::ePresentSrcKHR};
+											  getFinalColorLayout()};
+
+	m_depthFormat = findDepthFormat();
 
 	vk::AttachmentDescription depthAttachment{vk::AttachmentDescriptionFlags{},
-											  findDepthFormat(),
+											  m_depthFormat,
 											  vk::SampleCountFlagBits::e1,
 											  vk::AttachmentLoadOp::eClear,
 											  vk::AttachmentStoreOp::eDontCare,
@@ -733,7 +1348,7 @@ vk::Format VulkanRenderer::findDepthFormat() const
 								vk::Format::eD32SfloatS8Uint,
 								vk::Format::eD24UnormS8Uint},
 							   vk::ImageTiling::eOptimal,
-							   vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+							   vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage);
 }
 
 vk::Format VulkanRenderer::findSupportedFormat(const std::vector<vk::Format> &candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features) const
@@ -762,89 +1377,82 @@ void VulkanRenderer::createGraphicsPipeline()
 	createDescriptorPool();
 	createDescriptorSetLayout(); // must stay in pipline creation
 
-	auto vertShaderCode = st::renderer::Shader::readFile("Assets/Shaders/vert.spv");
-	auto fragShaderCode = st::renderer::Shader::readFile("Assets/Shaders/frag.spv");
-
-	vk::ShaderModule vertShaderModule = st::renderer::Shader::createShaderModule(m_device, vertShaderCode);
-	vk::ShaderModule fragShaderModule = st::renderer::Shader::createShaderModule(m_device, fragShaderCode);
-
-	vk::PipelineShaderStageCreateInfo vertShaderStageInfo{{}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main"};
-
-	vk::PipelineShaderStageCreateInfo fragShaderStageInfo{{}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main"};
+	std::vector<vk::DescriptorSetLayout> setLayouts { m_descriptorSetLayout };
+	if (m_bindlessSupported)
+	{
+		m_bindlessTextures.init(m_physicalDevice, m_device);
+		setLayouts.push_back(m_bindlessTextures.getSetLayout());
+	}
 
-	std::vector<vk::PipelineShaderStageCreateInfo> shaderStages{vertShaderStageInfo, fragShaderStageInfo};
+	// Single objects push their premultiplied transform and material, the fragment stage may read the material
+	const vk::PushConstantRange drawConstantsRange { vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+													 0,
+													 sizeof(st::renderer::DrawConstants) };
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo{vk::PipelineLayoutCreateFlags{}, setLayouts, drawConstantsRange};
 
-	vk::PipelineVertexInputStateCreateInfo vertexInputInfo{{}, bindingDescription, attributeDescriptions};
+	m_pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
 
-	vk::PipelineInputAssemblyStateCreateInfo inputAssembly{vk::PipelineInputAssemblyStateCreateFlags{}, vk::PrimitiveTopology::eTriangleList, VK_FALSE};
+	m_pipelineManager.init(m_device, "", m_jobSystem);
+	m_pipelineManager.registerRenderPass("scene", m_renderPass);
+	m_pipelineManager.registerLayout("primitive", m_pipelineLayout);
 
-	vk::PipelineViewportStateCreateInfo viewportState{vk::PipelineViewportStateCreateFlags{}, 1, {}, 1, {}};
+	// The default variant is the placeholder for every other scene variant, so it is the only one compiled up front
+	m_graphicsPipeline = m_pipelineManager.compileNow(meshPipelineDescription(st::renderer::MeshShaderPermutation {}));
+	m_pipelineManager.setFallback("scene", m_graphicsPipeline);
 
-	vk::PipelineRasterizationStateCreateInfo rasterizer{vk::PipelineRasterizationStateCreateFlags{},
-														VK_FALSE,
-														VK_FALSE,
-														vk::PolygonMode::eFill,
-														vk::CullModeFlagBits::eBack,
-														vk::FrontFace::eCounterClockwise,
-														VK_FALSE,
-														0.0f,
-														0.0f,
-														0.0f,
-														1.0F};
+	// The scene fallback has the instanced vertex input, so objects keep their own default variant
+	m_defaultObjectPipeline = m_pipelineManager.compileNow(objectPipelineDescription(st::renderer::MeshShaderPermutation {}));
+	m_objectPipeline = m_defaultObjectPipeline;
 
-	vk::PipelineMultisampleStateCreateInfo multisampling{vk::PipelineMultisampleStateCreateFlags{}, vk::SampleCountFlagBits::e1, VK_FALSE};
+	m_gpuCulling.init(m_device,
+					  m_memoryAllocator,
+					  m_pipelineManager,
+					  m_uniformRing,
+					  MAX_FRAMES_IN_FLIGHT,
+					  st::renderer::GpuCulling::Features { m_deviceFeatures.drawIndirectCount, m_deviceFeatures.multiDrawIndirect });
 
-	vk::PipelineDepthStencilStateCreateInfo depthStencil{{}, true, true, vk::CompareOp::eLess, false, false};
+	// Variants recorded by previous runs compile on the workers while the rest of the renderer initializes
+	m_pipelineManager.prewarm();
+}
 
-	m_dynamicStateEnables = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+st::renderer::GraphicsPipelineDescription VulkanRenderer::meshPipelineDescription(const st::renderer::MeshShaderPermutation& permutation) const
+{
+	auto bindingDescription = st::renderer::Vertex::getBindingDescription();
+	auto attributeDescriptions = st::renderer::Vertex::getAttributeDescriptions();
+	auto instanceBindingDescription = st::renderer::InstanceData::getBindingDescription();
+	auto instanceAttributeDescriptions = st::renderer::InstanceData::getAttributeDescriptions();
 
-	m_pipelineDynamicStateCreateInfo = vk::PipelineDynamicStateCreateInfo{{}, m_dynamicStateEnables};
+	st::renderer::GraphicsPipelineDescription description;
+	description.vertexShader = "Assets/Shaders/vert.spv";
+	description.fragmentShader = m_bindlessTextures.isEnabled() ? bindlessFragmentShader : "Assets/Shaders/frag.spv";
+	description.specialization = permutation.specializationConstants();
+	description.vertexBindings = {bindingDescription, instanceBindingDescription};
+	description.vertexAttributes = {attributeDescriptions.begin(), attributeDescriptions.end()};
+	description.vertexAttributes.insert(description.vertexAttributes.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+	description.renderPass = "scene";
+	description.layout = "primitive";
 
-	vk::PipelineColorBlendAttachmentState colorBlendAttachment{VK_FALSE,
-															   vk::BlendFactor::eZero,
-															   vk::BlendFactor::eZero,
-															   vk::BlendOp::eAdd,
-															   vk::BlendFactor::eZero,
-															   vk::BlendFactor::eZero,
-															   vk::BlendOp::eAdd,
-															   vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-																   vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA};
+	if (permutation.isEnabled(st::renderer::MeshPermutationKeys::eAlphaTest))
+	{
+		// Cut-out geometry is usually seen from both sides
+		description.cullMode = vk::CullModeFlagBits::eNone;
+	}
 
-	vk::PipelineColorBlendStateCreateInfo colorBlending{
-		vk::PipelineColorBlendStateCreateFlags{},
-		VK_FALSE,
-		vk::LogicOp::eCopy,
-		colorBlendAttachment,
-		{0.0f, 0.0f, 0.0f, 0.0f}};
+	return description;
+}
 
-	vk::PipelineLayoutCreateInfo pipelineLayoutInfo{vk::PipelineLayoutCreateFlags{}, m_descriptorSetLayout};
+st::renderer::GraphicsPipelineDescription VulkanRenderer::objectPipelineDescription(const st::renderer::MeshShaderPermutation& permutation) const
+{
+	// Same state as the instanced variant without the instance binding
+	st::renderer::GraphicsPipelineDescription description = meshPipelineDescription(permutation);
+	description.vertexShader = objectVertexShader;
+	description.vertexBindings = { st::renderer::Vertex::getBindingDescription() };
 
-	m_pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
+	auto attributeDescriptions = st::renderer::Vertex::getAttributeDescriptions();
+	description.vertexAttributes = { attributeDescriptions.begin(), attributeDescriptions.end() };
 
-	vk::GraphicsPipelineCreateInfo pipelineInfo{vk::PipelineCreateFlags{},
-												shaderStages,
-												&vertexInputInfo,
-												&inputAssembly,
-												{},
-												&viewportState,
-												&rasterizer,
-												&multisampling,
-												&depthStencil,
-												&colorBlending,
-												&m_pipelineDynamicStateCreateInfo,
-												m_pipelineLayout,
-												m_renderPass};
-
-	m_pipelineCache = m_device.createPipelineCache(vk::PipelineCacheCreateInfo());
-	m_graphicsPipeline = m_device.createGraphicsPipeline(m_pipelineCache, pipelineInfo).value;
-
-	// Note VkShaderModule is passed into pipline and are not longer available trought object they are used to create
-	// If ther are used later, then they must not be destroyed
-	m_device.destroy(fragShaderModule);
-	m_device.destroy(vertShaderModule);
+	return description;
 }
 
 void VulkanRenderer::createTextureSampler()
@@ -875,35 +1483,24 @@ void VulkanRenderer::createTextureSampler()
 
 void VulkanRenderer::createUniformBuffers()
 {
-	const VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-	m_uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-	m_uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		createBuffer(bufferSize,
-					 vk::BufferUsageFlagBits::eUniformBuffer,
-					 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-					 m_uniformBuffers[i],
-					 m_uniformBuffersMemory[i]);
-	}
+	m_uniformRing.init(m_physicalDevice, m_device, m_memoryAllocator, MAX_FRAMES_IN_FLIGHT);
 }
 
 void VulkanRenderer::createDescriptorPool()
 {
-	std::array<vk::DescriptorPoolSize, 2> poolsSize {
-		vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, MAX_FRAMES_IN_FLIGHT * 2},
-		vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, MAX_FRAMES_IN_FLIGHT * 2} 
-	};
+	// Long lived sets go through the cache, per-frame sets through the transient allocators
+	m_descriptorAllocator.init(m_device);
+	m_descriptorCache.init(m_device, m_descriptorAllocator);
 
-	const vk::DescriptorPoolCreateInfo poolInfo{{}, MAX_FRAMES_IN_FLIGHT * 2, poolsSize};
-	m_primitiveDescriptorPool = m_device.createDescriptorPool(poolInfo);
+	for (auto& frameDescriptors : m_frameDescriptorAllocators)
+	{
+		frameDescriptors.init(m_device);
+	}
 }
 
 void VulkanRenderer::createDescriptorSetLayout()
 {
-	vk::DescriptorSetLayoutBinding uboLayoutBinding { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex };
+	vk::DescriptorSetLayoutBinding uboLayoutBinding { 0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex };
 
 	vk::DescriptorSetLayoutBinding samplerLayoutBinding { 1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment };
 
@@ -920,76 +1517,50 @@ void VulkanRenderer::updateGraphicPipelineRecourses()
 	int texChannels = 0;
 	stbi_uc* pixels = stbi_load("Assets/Textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 
-	std::span<std::byte> pixelsByte { reinterpret_cast<std::byte*>(pixels), static_cast<std::span<std::byte>::size_type>(texWidth * texHeight * 4) };
+	std::span<const std::byte> pixelsByte { reinterpret_cast<const std::byte*>(pixels), static_cast<size_t>(texWidth * texHeight * 4) };
 	Texture texture { texWidth, texHeight, texChannels, pixelsByte };	
 
 	createTextureImage(texture, m_textureImage, textureImageMemory);
+	stbi_image_free(pixels);
 	createTextureImageView(m_textureImage, m_textureImageView);
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
-	{
-		vk::DescriptorBufferInfo bufferInfo { m_uniformBuffers.at(i), 0, sizeof(UniformBufferObject) };
-		vk::DescriptorImageInfo imageInfo { m_textureSampler, m_textureImageView, vk::ImageLayout::eShaderReadOnlyOptimal };
-
-
-		std::array<vk::WriteDescriptorSet, 2> graphicDescriptorWrites {
-			vk::WriteDescriptorSet { m_descriptorSets.at(i), 0, 0, vk::DescriptorType::eUniformBuffer,        {},        bufferInfo, {}},
-			vk::WriteDescriptorSet { m_descriptorSets.at(i), 1, 0, vk::DescriptorType::eCombinedImageSampler, imageInfo, {},         {}}
-		};
-
-		m_device.updateDescriptorSets(graphicDescriptorWrites, {});
-	}
-}
-
-uint32_t VulkanRenderer::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
-{
-	vk::PhysicalDeviceMemoryProperties memProperties = m_physicalDevice.getMemoryProperties();
-
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+	// The default texture is material 0
+	if (m_bindlessTextures.isEnabled())
 	{
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-		{
-			return i;
-		}
+		m_bindlessTextures.add(m_textureImageView, m_textureSampler);
 	}
 
-	throw std::runtime_error("failed to find suitable memory type!");
-}
-
-void VulkanRenderer::copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height)
-{
-	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
-
-	vk::BufferImageCopy region {
-		0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
-			{ 0, 0, 0 },
-			{ width, height, 1 }
+	// The offset into the ring is supplied as a dynamic offset at bind time, so every frame shares one set
+	std::array<st::renderer::DescriptorBinding, 2> bindings {
+		st::renderer::DescriptorBinding { 0, vk::DescriptorType::eUniformBufferDynamic, { m_uniformRing.getBuffer(), 0, sizeof(UniformBufferObject) }, {} },
+		st::renderer::DescriptorBinding { 1, vk::DescriptorType::eCombinedImageSampler, {}, { m_textureSampler, m_textureImageView, vk::ImageLayout::eShaderReadOnlyOptimal } }
 	};
 
-	commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
-
-	endSingleTimeCommands(commandBuffer);
+	m_sceneDescriptorSet = m_descriptorCache.get(m_descriptorSetLayout, bindings);
 }
 
 void VulkanRenderer::createUiGraphicsPipeline()
 {
+	// ImGui allocates from a single pool it is handed, so it cannot chain pools. The font atlas and
+	// every texture registered with ImGui take one set, which are freed individually.
 	std::array<vk::DescriptorPoolSize, 1> poolsSize {
-		vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, MAX_FRAMES_IN_FLIGHT * 2} 
+		vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, MAX_UI_DESCRIPTOR_SETS}
 	};
 
-	const vk::DescriptorPoolCreateInfo poolInfo{{}, MAX_FRAMES_IN_FLIGHT * 2, poolsSize};
+	const vk::DescriptorPoolCreateInfo poolInfo{vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, MAX_UI_DESCRIPTOR_SETS, poolsSize};
 	m_uiDescriptorPool = m_device.createDescriptorPool(poolInfo);
 
 
+	// Drawn over the scene, which left the image in the final layout
 	vk::AttachmentDescription colorAttachment{vk::AttachmentDescriptionFlags{},
 											  m_swapChainImageFormat,
 											  vk::SampleCountFlagBits::e1,
-											  vk::AttachmentLoadOp::eDontCare,
+											  vk::AttachmentLoadOp::eLoad,
 											  vk::AttachmentStoreOp::eStore,
 											  vk::AttachmentLoadOp::eDontCare,
 											  vk::AttachmentStoreOp::eDontCare,
-											  vk::ImageLayout::eUndefined,
-											  vk::ImageLayout::ePresentSrcKHR};
+											  getFinalColorLayout(),
+											  getFinalColorLayout()};
 
 
 	vk::AttachmentReference colorAttachmentRef{0, vk::ImageLayout::eColorAttachmentOptimal};
@@ -1009,17 +1580,32 @@ void VulkanRenderer::createUiGraphicsPipeline()
     );
 
 
-    vk::SubpassDependency dependency(
+    // The scene is submitted in the same batch, no semaphore makes its color writes visible
+    std::vector<vk::SubpassDependency> dependencies;
+    dependencies.emplace_back(
         VK_SUBPASS_EXTERNAL,               // srcSubpass
         0,                                 // dstSubpass
         vk::PipelineStageFlagBits::eColorAttachmentOutput, // srcStageMask
         vk::PipelineStageFlagBits::eColorAttachmentOutput, // dstStageMask
-        {},                                // srcAccessMask
+        vk::AccessFlagBits::eColorAttachmentWrite,         // srcAccessMask
         vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite // dstAccessMask
     );
 
+    // Headless frames end in eTransferSrcOptimal and are read back by the capture copy
+    if (isHeadless())
+    {
+        dependencies.emplace_back(
+            0,                                 // srcSubpass
+            VK_SUBPASS_EXTERNAL,               // dstSubpass
+            vk::PipelineStageFlagBits::eColorAttachmentOutput, // srcStageMask
+            vk::PipelineStageFlagBits::eTransfer,              // dstStageMask
+            vk::AccessFlagBits::eColorAttachmentWrite,         // srcAccessMask
+            vk::AccessFlagBits::eTransferRead                  // dstAccessMask
+        );
+    }
+
 	std::array<vk::AttachmentDescription, 1> attachments{colorAttachment};
-	vk::RenderPassCreateInfo renderPassInfo{{}, attachments, subpass, dependency};
+	vk::RenderPassCreateInfo renderPassInfo{{}, attachments, subpass, dependencies};
 
 
 	m_uiRenderPass = m_device.createRenderPass(renderPassInfo);
@@ -1033,28 +1619,12 @@ void VulkanRenderer::createCommandPool()
 	vk::CommandPoolCreateInfo poolInfo { vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamilyIndices.graphicsFamily.value() };
 
 	m_commandPool = m_device.createCommandPool(poolInfo);
+
+	m_parallelRecorder.init(m_device, queueFamilyIndices.graphicsFamily.value(), MAX_FRAMES_IN_FLIGHT, m_jobSystem);
 }
 
 void VulkanRenderer::createFramebuffer()
 {
-	createDepthResources();
-
-	m_swapchainFramebuffers.reserve(m_swapChainImageViews.size());
-	for (const auto& swapChainImageView : m_swapChainImageViews)
-	{
-		std::array<vk::ImageView, 2> attachments { swapChainImageView, m_depthImageView };
-
-		vk::FramebufferCreateInfo framebufferInfo { vk::FramebufferCreateFlags {},
-													m_renderPass,
-													attachments,
-													m_swapChainExtent.width,
-													m_swapChainExtent.height,
-													1 };
-
-		m_swapchainFramebuffers.emplace_back(m_device.createFramebuffer(framebufferInfo));
-	}
-
-
 	m_uiSwapchainFramebuffers.reserve(m_uiSwapchainImageViews.size());
 	for (const auto& swapChainImageView : m_uiSwapchainImageViews)
 	{
@@ -1071,111 +1641,43 @@ void VulkanRenderer::createFramebuffer()
 	}
 }
 
-void VulkanRenderer::createDepthResources()
-{
-	vk::Format depthFormat = findDepthFormat();
-
-	createImage(m_swapChainExtent.width,
-							m_swapChainExtent.height,
-							depthFormat,
-							vk::ImageTiling::eOptimal,
-							vk::ImageUsageFlagBits::eDepthStencilAttachment,
-							vk::MemoryPropertyFlagBits::eDeviceLocal,
-							m_depthImage,
-							m_depthImageMemory);
-
-	m_depthImageView = createImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
-}
-
-void VulkanRenderer::createVertexBuffer()
-{
-	vk::DeviceSize bufferSize = sizeof(planeVertexes[0]) * planeVertexes.size();
-
-	vk::Buffer stagingBuffer;
-	vk::DeviceMemory stagingBufferMemory;
-
-
-	createBuffer(bufferSize,
-									vk::BufferUsageFlagBits::eTransferSrc,
-									vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-									stagingBuffer,
-									stagingBufferMemory);
-
-	void* lineData = m_device.mapMemory(stagingBufferMemory, 0, bufferSize);
-	memcpy(lineData, planeVertexes.data(), (size_t)bufferSize); //vertices should fullfil trival object specyfication?
-	m_device.unmapMemory(stagingBufferMemory);
-
-	createBuffer(bufferSize,
-									vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-									vk::MemoryPropertyFlagBits::eDeviceLocal,
-									m_planeVertexBuffer,
-									m_planeVertexBufferMemory);
-
-	copyBuffer(stagingBuffer, m_planeVertexBuffer, bufferSize);
-
-	m_device.destroyBuffer(stagingBuffer);
-	m_device.freeMemory(stagingBufferMemory);
-
-
-	std::vector<vk::DescriptorSetLayout> graphicLayouts(MAX_FRAMES_IN_FLIGHT, m_descriptorSetLayout);
-	const vk::DescriptorSetAllocateInfo graphicAllocInfo { m_primitiveDescriptorPool, graphicLayouts };
-	m_descriptorSets = m_device.allocateDescriptorSets(graphicAllocInfo);
-}
-
-void VulkanRenderer::createIndexBuffer()
+void VulkanRenderer::createDescriptorSets()
 {
-	vk::DeviceSize planeBufferSize = sizeof(planeIndices[0]) * planeIndices.size();
-
-	vk::Buffer planetagingBuffer;
-	vk::DeviceMemory planetagingBufferMemory;
-	createBuffer(planeBufferSize,
-									vk::BufferUsageFlagBits::eTransferSrc,
-									vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-									planetagingBuffer,
-									planetagingBufferMemory);
-
-	void* planeData = m_device.mapMemory(planetagingBufferMemory, 0, planeBufferSize);
-	memcpy(planeData, planeIndices.data(), (size_t)planeBufferSize);
-	m_device.unmapMemory(planetagingBufferMemory);
-
-	createBuffer(planeBufferSize,
-									vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-									vk::MemoryPropertyFlagBits::eDeviceLocal,
-									m_planeIndexBuffer,
-									m_planeIndexBufferMemory);
-
-	copyBuffer(planetagingBuffer, m_planeIndexBuffer, planeBufferSize);
-
-	m_device.destroyBuffer(planetagingBuffer);
-	m_device.freeMemory(planetagingBufferMemory);
+	m_instanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	m_instanceBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+	m_instanceBufferCapacity.resize(MAX_FRAMES_IN_FLIGHT, 0);
 }
 
 void VulkanRenderer::createCommandBuffers()
 {
+	// Indexed by frame slot, the swapchain image count may change at runtime
 	vk::CommandBufferAllocateInfo cmdAllocInfo { m_commandPool,
 												vk::CommandBufferLevel::ePrimary,
-												static_cast<uint32_t>(m_swapchainFramebuffers.size()) };
+												MAX_FRAMES_IN_FLIGHT };
 
 	vk::CommandBufferAllocateInfo uiCmdAllocInfo { m_commandPool,
 												vk::CommandBufferLevel::ePrimary,
-												static_cast<uint32_t>(m_uiSwapchainFramebuffers.size()) };
+												MAX_FRAMES_IN_FLIGHT };
 
 	m_commandBuffers 	= m_device.allocateCommandBuffers(cmdAllocInfo);
 	m_uiCommandBuffers 	= m_device.allocateCommandBuffers(uiCmdAllocInfo);
 
+	if (isHeadless())
+	{
+		m_frameCapture.init(m_device, m_memoryAllocator, m_commandPool, MAX_FRAMES_IN_FLIGHT, m_jobSystem);
+	}
+
 }
 
 void VulkanRenderer::createSyncObjects()
 {
 	m_imageAvailableSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-	m_uiAvailableSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
 	m_renderFinishedSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
 	m_inFlightFences.reserve(MAX_FRAMES_IN_FLIGHT);
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		m_imageAvailableSemaphores.emplace_back(m_device.createSemaphore(vk::SemaphoreCreateInfo {}));
-		m_uiAvailableSemaphores.emplace_back(m_device.createSemaphore(vk::SemaphoreCreateInfo {}));
 		m_renderFinishedSemaphores.emplace_back(m_device.createSemaphore(vk::SemaphoreCreateInfo {}));
 		m_inFlightFences.emplace_back(m_device.createFence(vk::FenceCreateInfo { vk::FenceCreateFlagBits::eSignaled }));
 	}
@@ -1184,44 +1686,220 @@ void VulkanRenderer::createSyncObjects()
 void VulkanRenderer::updateUniformBuffer(uint32_t currentImage)
 {
 	UniformBufferObject ubo {};
-	ubo.model = st::math::Matrix4x4::indentityMatrix();
-	ubo.model.convertToColumnMajor();
-
-	ubo.view = camera.getViewMatrix();
-	ubo.view.convertToColumnMajor();
-
+	ubo.view = m_viewMatrix.value_or(camera.getViewMatrix());
 	ubo.proj = camera.getProjectionMatrix(45.0F,
 											(m_swapChainExtent.width / static_cast<float>(m_swapChainExtent.height)),
-											0.1F,
-											100.0F);
+											cameraNearPlane,
+											cameraFarPlane);
+
+	m_cullView = st::renderer::makeCullView(ubo.view, ubo.proj);
+	m_viewProjection = ubo.proj * ubo.view;
+
+	ubo.view.convertToColumnMajor();
 	ubo.proj.convertToColumnMajor();
 
 
-	void* data = m_device.mapMemory(m_uniformBuffersMemory.at(currentImage), 0, sizeof(ubo));
-	memcpy(data, &ubo, sizeof(ubo));
-	m_device.unmapMemory(m_uniformBuffersMemory.at(currentImage));
+	m_uniformRing.beginFrame(currentImage);
+	m_sceneUniformOffset = m_uniformRing.push(ubo);
+	m_uniformRing.flush();
+}
+
+void VulkanRenderer::updateInstanceBuffer(uint32_t currentImage)
+{
+	if (m_frameInstances.empty())
+	{
+		return;
+	}
+
+	const vk::DeviceSize requiredSize = m_frameInstances.size() * sizeof(st::renderer::InstanceData);
+
+	// The fence of this frame was waited on in startFrame, so its buffer can be replaced
+	if (m_instanceBufferCapacity.at(currentImage) < requiredSize)
+	{
+		m_device.destroyBuffer(m_instanceBuffers.at(currentImage));
+		m_memoryAllocator.free(m_instanceBuffersMemory.at(currentImage));
+
+		const vk::DeviceSize capacity = std::max(requiredSize, 2 * m_instanceBufferCapacity.at(currentImage));
+		createBuffer(capacity,
+					 vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+					 vk::MemoryPropertyFlagBits::eHostVisible,
+					 m_instanceBuffers.at(currentImage),
+					 m_instanceBuffersMemory.at(currentImage));
+		m_instanceBufferCapacity.at(currentImage) = capacity;
+	}
+
+	memcpy(m_instanceBuffersMemory.at(currentImage).mappedData, m_frameInstances.data(), requiredSize);
+	m_memoryAllocator.flush(m_instanceBuffersMemory.at(currentImage), 0, requiredSize);
+}
+
+void VulkanRenderer::buildRenderGraph(bool gpuCulling)
+{
+	m_renderGraph.reset(&m_frameArenas.at(currentFrame));
+
+	// Swapchain images wait for the acquire at the color output stage, the UI pass loads the
+	// result in the final layout
+	const auto color = m_renderGraph.importImage(m_swapChainImages[currentImageIndex],
+												 m_swapChainImageViews[currentImageIndex],
+												 st::renderer::RenderGraphImage { m_swapChainImageFormat,
+																				  m_swapChainExtent,
+																				  vk::ImageUsageFlagBits::eColorAttachment,
+																				  vk::ImageAspectFlagBits::eColor },
+												 vk::ImageLayout::eUndefined,
+												 vk::PipelineStageFlagBits::eColorAttachmentOutput,
+												 getFinalColorLayout(),
+												 vk::PipelineStageFlagBits::eColorAttachmentOutput);
+	const auto depth = m_renderGraph.createImage(st::renderer::RenderGraphImage { m_depthFormat,
+																				  m_swapChainExtent,
+																				  vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
+																				  vk::ImageAspectFlagBits::eDepth });
+
+	const vk::ClearColorValue colorClear { std::array<float, 4> { 0.0F, 0.0F, 0.0F, 1.0F } };
+	const vk::ClearDepthStencilValue depthClear { 1.0F, 0 };
+
+	// Culling passes write buffers the graph does not track, they synchronize themselves
+	if (gpuCulling)
+	{
+		const auto earlyCull = m_renderGraph.addPass([this](vk::CommandBuffer commandBuffer) {
+			m_gpuCulling.recordCulling(commandBuffer, currentFrame, st::renderer::CullPhase::eEarly);
+		});
+		m_renderGraph.setSideEffect(earlyCull);
+	}
+
+	m_scenePass = m_renderGraph.addPass([this, gpuCulling](vk::CommandBuffer commandBuffer) { recordScenePass(commandBuffer, gpuCulling); });
+	m_renderGraph.setColorAttachment(m_scenePass, color, vk::AttachmentLoadOp::eClear, colorClear);
+	m_renderGraph.setDepthAttachment(m_scenePass, depth, vk::AttachmentLoadOp::eClear, depthClear);
+	m_renderGraph.setSecondaryCommandBuffers(m_scenePass);
+
+	if (gpuCulling)
+	{
+		// Occlusion is tested against the depth of what was visible last frame, newly visible
+		// instances are drawn on top
+		const auto depthPyramid = m_renderGraph.addPass([this](vk::CommandBuffer commandBuffer) { m_gpuCulling.recordDepthPyramid(commandBuffer); });
+		m_renderGraph.read(depthPyramid, depth, st::renderer::ResourceAccess::eDepthSampled);
+		m_renderGraph.setSideEffect(depthPyramid);
+
+		const auto lateCull = m_renderGraph.addPass([this](vk::CommandBuffer commandBuffer) {
+			m_gpuCulling.recordCulling(commandBuffer, currentFrame, st::renderer::CullPhase::eLate);
+		});
+		m_renderGraph.setSideEffect(lateCull);
+
+		const auto late = m_renderGraph.addPass([this](vk::CommandBuffer commandBuffer) {
+			st::renderer::CommandStateCache stateCache { commandBuffer, m_drawStatistics };
+			bindSceneState(commandBuffer, stateCache);
+			stateCache.bindPipeline(m_pipelineManager.getPipeline(m_graphicsPipeline));
+			m_gpuCulling.recordDraws(commandBuffer, currentFrame, st::renderer::CullPhase::eLate, m_meshDraws);
+			m_drawStatistics.drawCount += static_cast<uint32_t>(m_meshDraws.size());
+		});
+		m_renderGraph.setColorAttachment(late, color, vk::AttachmentLoadOp::eLoad);
+		m_renderGraph.setDepthAttachment(late, depth, vk::AttachmentLoadOp::eLoad);
+	}
+
+	m_renderGraph.compile(m_lastSubmittedFrame);
+
+	// The depth pyramid is reduced from the depth attachment
+	const vk::ImageView depthView = m_renderGraph.getImageView(depth);
+	if (depthView != m_depthImageView)
+	{
+		m_depthImageView = depthView;
+		m_gpuCulling.resize(m_depthImageView, m_swapChainExtent, m_lastSubmittedFrame);
+	}
 }
 
-void VulkanRenderer::recordCommandBuffer(vk::CommandBuffer &commandBuffer, uint32_t imageIndex)
+void VulkanRenderer::recordCommandBuffer(vk::CommandBuffer &commandBuffer)
 {
 	commandBuffer.begin(vk::CommandBufferBeginInfo {});
 
-	const vk::ClearColorValue colorClean {
-		std::array<float, 4> {0.0F, 0.0F, 0.0F, 1.0F}
+	m_transferContext.recordAcquireBarriers(commandBuffer);
+
+	m_drawStatistics = {};
+	m_renderGraph.execute(commandBuffer);
+
+	commandBuffer.end();
+}
+
+void VulkanRenderer::recordScenePass(vk::CommandBuffer commandBuffer, bool gpuCulling)
+{
+	// Every variant shares the layout, so the descriptor sets stay bound across pipeline changes
+	const st::renderer::PipelineHandle objectPipeline = m_pipelineManager.isReady(m_objectPipeline) ? m_objectPipeline : m_defaultObjectPipeline;
+	buildDrawList(gpuCulling, objectPipeline);
+
+	// Resolved once, the workers would otherwise contend on the pipeline manager lock per draw
+	const vk::Pipeline objectPipelineHandle = m_pipelineManager.getPipeline(objectPipeline);
+	const vk::Pipeline meshPipelineHandle = m_pipelineManager.getPipeline(m_graphicsPipeline);
+
+	const auto packets = m_drawList.getPackets();
+	const uint32_t packetCount = static_cast<uint32_t>(packets.size());
+
+	std::pmr::memory_resource* const frameMemory = &m_frameArenas.at(currentFrame);
+	std::pmr::vector<st::renderer::DrawStatistics> workerStatistics(m_parallelRecorder.getWorkerCount(), frameMemory);
+
+	//-------------------Draw all objects----------------------------------
+	const auto recordRange = [&](vk::CommandBuffer secondary, uint32_t worker, uint32_t first, uint32_t count) {
+		st::renderer::DrawStatistics& statistics = workerStatistics[worker];
+		st::renderer::CommandStateCache stateCache { secondary, statistics };
+		bindSceneState(secondary, stateCache);
+
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const auto& packet = packets[i];
+			const bool object = st::renderer::DrawKey::pass(packet.key) == static_cast<uint32_t>(ScenePass::eObjects);
+			const st::renderer::MeshHandle meshHandle = object ? m_objectDraws[packet.payload].mesh : m_meshDraws[packet.payload].mesh;
+			const st::renderer::GeometryRange& geometry = m_meshes.at(meshHandle).geometry;
+
+			stateCache.bindPipeline(object ? objectPipelineHandle : meshPipelineHandle);
+			++statistics.drawCount;
+
+			if (object)
+			{
+				st::renderer::DrawConstants constants;
+				constants.m_modelViewProjection = m_objectTransforms[packet.payload];
+				std::copy_n(&m_objectModels[packet.payload][0], 12, constants.m_modelRows);
+				constants.m_materialIndex = m_objectDraws[packet.payload].materialIndex;
+
+				secondary.pushConstants(m_pipelineLayout,
+										vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+										0,
+										sizeof(constants),
+										&constants);
+				secondary.drawIndexed(geometry.indexCount, 1, geometry.firstIndex, geometry.vertexOffset, 0);
+			}
+			else
+			{
+				const st::renderer::MeshDraw& draw = m_meshDraws[packet.payload];
+				secondary.drawIndexed(geometry.indexCount, draw.instanceCount, geometry.firstIndex, geometry.vertexOffset, draw.firstInstance);
+			}
+		}
+
+		// The indirect draws go last, after every sorted packet
+		if (gpuCulling && first + count == packetCount)
+		{
+			stateCache.bindPipeline(meshPipelineHandle);
+			m_gpuCulling.recordDraws(secondary, currentFrame, st::renderer::CullPhase::eEarly, m_meshDraws);
+			statistics.drawCount += static_cast<uint32_t>(m_meshDraws.size());
+		}
 	};
-	const vk::ClearDepthStencilValue depthClean { 1.0F, 0 };
 
-	std::array<vk::ClearValue, 2> clearValues { colorClean, depthClean };
+	// By reference, the callback is not copied into a heap allocated std::function
+	const auto secondaries = m_parallelRecorder.record(currentFrame,
+													   m_renderGraph.getInheritance(m_scenePass),
+													   packetCount,
+													   std::ref(recordRange),
+													   frameMemory);
 
-	//Draw primitive
-	vk::Extent2D swapChainExtent = m_swapChainExtent;
-	vk::RenderPassBeginInfo renderPassInfo { m_renderPass,
-												m_swapchainFramebuffers[imageIndex],
-												vk::Rect2D((0, 0), swapChainExtent),
-												clearValues };
+	commandBuffer.executeCommands(secondaries);
 
-	commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	for (const auto& statistics : workerStatistics)
+	{
+		m_drawStatistics.drawCount += statistics.drawCount;
+		m_drawStatistics.pipelineBinds += statistics.pipelineBinds;
+		m_drawStatistics.bufferBinds += statistics.bufferBinds;
+		m_drawStatistics.bindsSaved += statistics.bindsSaved;
+	}
+}
 
+void VulkanRenderer::bindSceneState(vk::CommandBuffer commandBuffer, st::renderer::CommandStateCache& stateCache)
+{
+	vk::Extent2D swapChainExtent = m_swapChainExtent;
 	vk::Viewport viewport { 0.0F, 0.0F, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0F, 1.0F };
 
 	vk::Rect2D scissor {
@@ -1231,47 +1909,70 @@ void VulkanRenderer::recordCommandBuffer(vk::CommandBuffer &commandBuffer, uint3
 	commandBuffer.setViewport(0, 1, &viewport);
 	commandBuffer.setScissor(0, 1, &scissor);
 
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+										m_pipelineLayout,
+										0,
+										m_sceneDescriptorSet,
+										m_sceneUniformOffset);
 
-	//-------------------Draw all objects----------------------------------
-	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_graphicsPipeline);
+	// Every texture is reachable through the material index, one bind for the whole frame
+	if (m_bindlessTextures.isEnabled())
+	{
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 1, m_bindlessTextures.getDescriptorSet(), {});
+	}
 
-	vk::Buffer vertexBuffers[] = { m_planeVertexBuffer };
-	vk::DeviceSize offsets[] = { 0 };
+	// Every mesh lives in the geometry heap, its buffers are bound once for the frame
+	stateCache.bindVertexBuffer(0, m_geometryHeap.getVertexBuffer());
+	stateCache.bindIndexBuffer(m_geometryHeap.getIndexBuffer());
 
-	commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
-	commandBuffer.bindIndexBuffer(m_planeIndexBuffer, 0, vk::IndexType::eUint32);
+	if (!m_meshDraws.empty())
+	{
+		stateCache.bindVertexBuffer(1, m_instanceBuffers.at(currentFrame));
+	}
+}
 
-	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-										m_pipelineLayout,
-										0,
-										m_descriptorSets.at(currentFrame),
-										{});
+void VulkanRenderer::buildDrawList(bool gpuCulling, st::renderer::PipelineHandle objectPipeline)
+{
+	m_drawList.clear();
 
-	commandBuffer.drawIndexed(planeIndices.size(), 1, 0, 0, 0);
-	
+	for (uint32_t i = 0; i < m_objectDraws.size(); ++i)
+	{
+		// Clip space w of the premultiplied transform is the view distance of the object origin
+		const uint32_t depth = st::renderer::DrawKey::quantizeDepth(m_objectTransforms[i][15], cameraFarPlane);
+		m_drawList.add(st::renderer::DrawKey::make(static_cast<uint32_t>(ScenePass::eObjects),
+												   objectPipeline,
+												   m_objectDraws[i].materialIndex,
+												   m_objectDraws[i].mesh,
+												   depth),
+					   i);
+	}
 
-	commandBuffer.endRenderPass();
-	commandBuffer.end();
+	// Culled instances are drawn indirectly in submission order
+	if (!gpuCulling)
+	{
+		for (uint32_t i = 0; i < m_meshDraws.size(); ++i)
+		{
+			m_drawList.add(st::renderer::DrawKey::make(static_cast<uint32_t>(ScenePass::eInstanced), m_graphicsPipeline, 0, m_meshDraws[i].mesh, 0), i);
+		}
+	}
+
+	m_drawList.sort();
 }
 
 void VulkanRenderer::createBuffer(vk::DeviceSize size,
                                   vk::BufferUsageFlags usage,
                                   vk::MemoryPropertyFlags properties,
                                   vk::Buffer &buffer,
-                                  vk::DeviceMemory &bufferMemory) const
+                                  st::renderer::MemoryAllocation &bufferMemory)
 {
 
 	vk::BufferCreateInfo bufferInfo{{}, size, usage, vk::SharingMode::eExclusive};
 
 	buffer = m_device.createBuffer(bufferInfo);
 
-	vk::MemoryRequirements memoryRequirements = m_device.getBufferMemoryRequirements(buffer);
+	bufferMemory = m_memoryAllocator.allocateForBuffer(buffer, properties);
 
-	vk::MemoryAllocateInfo allocInfo{memoryRequirements.size, findMemoryType(memoryRequirements.memoryTypeBits, properties)};
-
-	bufferMemory = m_device.allocateMemory(allocInfo);
-
-	m_device.bindBufferMemory(buffer, bufferMemory, 0);
+	m_device.bindBufferMemory(buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
 void VulkanRenderer::createImage(uint32_t width,
@@ -1281,7 +1982,7 @@ void VulkanRenderer::createImage(uint32_t width,
 				 vk::ImageUsageFlags usage,
 				 vk::MemoryPropertyFlags properties,
 				 vk::Image& image,
-				 vk::DeviceMemory& imageMemory) const
+				 st::renderer::MemoryAllocation& imageMemory)
 {
 
 	vk::ImageCreateInfo imageInfo {
@@ -1294,13 +1995,9 @@ void VulkanRenderer::createImage(uint32_t width,
 
 	image = m_device.createImage(imageInfo);
 
-	vk::MemoryRequirements m_memRequirements = m_device.getImageMemoryRequirements(image);
-
-	vk::MemoryAllocateInfo allocInfo { m_memRequirements.size, findMemoryType(m_memRequirements.memoryTypeBits, properties) };
-
-	imageMemory = m_device.allocateMemory(allocInfo);
+	imageMemory = m_memoryAllocator.allocateForImage(image, properties);
 
-	m_device.bindImageMemory(image, imageMemory, 0);
+	m_device.bindImageMemory(image, imageMemory.memory, imageMemory.offset);
 }
 
 vk::ImageView VulkanRenderer::createImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags) const
@@ -1315,25 +2012,8 @@ vk::ImageView VulkanRenderer::createImageView(vk::Image image, vk::Format format
 	return m_device.createImageView(viewInfo);
 }
 
-void VulkanRenderer::createTextureImage(Texture &texture, vk::Image &textureImage, vk::DeviceMemory &textureImageMemory)
+void VulkanRenderer::createTextureImage(Texture &texture, vk::Image &textureImage, st::renderer::MemoryAllocation &textureImageMemory)
 {
-	vk::DeviceSize imageSize = texture.textureWidth * texture.textureHeight * 4;
-
-
-		vk::Buffer stagingBuffer;
-		vk::DeviceMemory stagingBufferMemory;
-
-		createBuffer(imageSize,
-									 vk::BufferUsageFlagBits::eTransferSrc,
-									 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-									 stagingBuffer,
-									 stagingBufferMemory);
-
-		void* data = m_device.mapMemory(stagingBufferMemory, 0, imageSize);
-		memcpy(data, texture.pixels.data(), static_cast<size_t>(imageSize));
-		m_device.unmapMemory(stagingBufferMemory);
-
-
 		createImage(texture.textureWidth,
 								   texture.textureHeight,
 								   vk::Format::eR8G8B8A8Srgb,
@@ -1343,128 +2023,14 @@ void VulkanRenderer::createTextureImage(Texture &texture, vk::Image &textureImag
 								   textureImage,
 								   textureImageMemory);
 
-		transitionImageLayout(textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-
-		copyBufferToImage(stagingBuffer, textureImage, texture.textureWidth, texture.textureHeight);
-
-		transitionImageLayout(textureImage,
-											 vk::Format::eR8G8B8A8Srgb,
-											 vk::ImageLayout::eTransferDstOptimal,
-											 vk::ImageLayout::eShaderReadOnlyOptimal);
-
-		m_device.destroyBuffer(stagingBuffer);
-		m_device.freeMemory(stagingBufferMemory);
+		m_transferContext.uploadImage(textureImage,
+									  { texture.textureWidth, texture.textureHeight, 1 },
+									  texture.pixels,
+									  vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
 void VulkanRenderer::createTextureImageView(vk::Image &textureImage, vk::ImageView &textureImageView)
 {
 	textureImageView = createImageView(textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
 
-}
-
-void VulkanRenderer::transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
-{
-	vk::CommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		vk::ImageMemoryBarrier barrier {
-			vk::AccessFlagBits::eNone, vk::AccessFlagBits::eNone, oldLayout, newLayout,
-			VK_QUEUE_FAMILY_IGNORED,   VK_QUEUE_FAMILY_IGNORED,   image,     {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}
-		};
-
-		vk::PipelineStageFlags sourceStage {};
-		vk::PipelineStageFlags destinationStage {};
-
-		if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal)
-		{
-			barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-			barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-			sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-			destinationStage = vk::PipelineStageFlagBits::eTransfer;
-		}
-		else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
-		{
-			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-			sourceStage = vk::PipelineStageFlagBits::eTransfer;
-			destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
-		}
-		else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal)
-		{
-			barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-			barrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-
-			sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-			destinationStage = vk::PipelineStageFlagBits::eEarlyFragmentTests;
-		}
-		else
-		{
-			throw std::invalid_argument("unsupported layout transition!");
-		}
-
-		commandBuffer.pipelineBarrier(sourceStage, destinationStage, {}, {}, {}, barrier);
-
-		endSingleTimeCommands(commandBuffer);
-}
-
-vk::VertexInputBindingDescription Vertex::getBindingDescription()
-{
-	vk::VertexInputBindingDescription bindingDescription{
-		0,
-		sizeof(Vertex),
-		vk::VertexInputRate::eVertex};
-
-	return bindingDescription;
-}
-
-std::array<vk::VertexInputAttributeDescription, 4> Vertex::getAttributeDescriptions()
-{
-	std::array<vk::VertexInputAttributeDescription, 4> attributeDescriptions{
-		vk::VertexInputAttributeDescription{
-			0,
-			0,
-			vk::Format::eR32G32B32Sfloat,
-			static_cast<uint32_t>(offsetof(Vertex, m_pos))},
-		vk::VertexInputAttributeDescription{
-			1,
-			0,
-			vk::Format::eR32G32Sfloat,
-			static_cast<uint32_t>(offsetof(Vertex, m_texCoord))},
-		vk::VertexInputAttributeDescription{
-			2,
-			0,
-			vk::Format::eR32G32B32Sfloat,
-			static_cast<uint32_t>(offsetof(Vertex, m_color))},
-		vk::VertexInputAttributeDescription{
-			3,
-			0,
-			vk::Format::eR32G32B32Sfloat,
-			static_cast<uint32_t>(offsetof(Vertex, m_normal))}};
-
-	return attributeDescriptions;
-}
-
-void VulkanRenderer::copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size)
-{
-	vk::CommandBufferAllocateInfo allocInfo { m_commandPool, vk::CommandBufferLevel::ePrimary, 1 };
-
-	auto commandBuffer = m_device.allocateCommandBuffers(allocInfo);
-
-	vk::CommandBufferBeginInfo beginInfo { vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
-
-	commandBuffer.at(0).begin(beginInfo);
-
-	vk::BufferCopy copyRegin { 0, 0, size };
-
-	commandBuffer.at(0).copyBuffer(srcBuffer, dstBuffer, 1, &copyRegin);
-
-	commandBuffer.at(0).end();
-
-	vk::SubmitInfo submitInfo { {}, {}, commandBuffer };
-
-	m_graphicsQueue.submit(1, &submitInfo, {}); //TODO GraphicQueue should copy buffers?
-	m_graphicsQueue.waitIdle();
-
-	m_device.freeCommandBuffers(m_commandPool, commandBuffer);
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "StagingRing.hpp"
+
+namespace st::renderer
+{
+	namespace
+	{
+		vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	StagingRing::~StagingRing()
+	{
+		shutdown();
+	}
+
+	void StagingRing::init(vk::Device device, MemoryAllocator& allocator, vk::DeviceSize size)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+		m_size = size;
+		m_head = 0;
+
+		m_buffer = m_device.createBuffer(vk::BufferCreateInfo { {}, size, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive });
+		m_memory = m_allocator->allocateForBuffer(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		m_device.bindBufferMemory(m_buffer, m_memory.memory, m_memory.offset);
+	}
+
+	void StagingRing::shutdown()
+	{
+		if (!m_buffer)
+		{
+			return;
+		}
+
+		m_device.destroyBuffer(m_buffer);
+		m_allocator->free(m_memory);
+
+		m_buffer = nullptr;
+		m_regions.clear();
+		m_head = 0;
+	}
+
+	std::optional<StagingRegion> StagingRing::allocate(vk::DeviceSize size, vk::DeviceSize alignment, uint64_t submission)
+	{
+		if (size > m_size)
+		{
+			return std::nullopt;
+		}
+
+		vk::DeviceSize offset = 0;
+
+		if (m_regions.empty())
+		{
+			offset = 0;
+		}
+		else
+		{
+			const vk::DeviceSize tail = m_regions.front().begin;
+
+			offset = alignUp(m_head, alignment);
+			if (m_head > tail)
+			{
+				// Not wrapped, use the end of the buffer or wrap around to the front
+				if (offset + size > m_size)
+				{
+					if (size > tail)
+					{
+						return std::nullopt;
+					}
+					offset = 0;
+				}
+			}
+			else if (offset + size > tail)
+			{
+				return std::nullopt;
+			}
+		}
+
+		m_head = offset + size;
+		m_regions.push_back({ submission, offset, m_head });
+
+		return StagingRegion { m_buffer, offset, size, static_cast<std::byte*>(m_memory.mappedData) + offset };
+	}
+
+	void StagingRing::retire(uint64_t completedSubmission)
+	{
+		while (!m_regions.empty() && m_regions.front().submission <= completedSubmission)
+		{
+			m_regions.pop_front();
+		}
+
+		if (m_regions.empty())
+		{
+			m_head = 0;
+		}
+	}
+
+	vk::Buffer StagingRing::getBuffer() const
+	{
+		return m_buffer;
+	}
+
+	vk::DeviceSize StagingRing::getSize() const
+	{
+		return m_size;
+	}
+
+	vk::DeviceSize StagingRing::getUsedSize() const
+	{
+		if (m_regions.empty())
+		{
+			return 0;
+		}
+
+		const vk::DeviceSize tail = m_regions.front().begin;
+		return m_head > tail ? m_head - tail : m_size - tail + m_head;
+	}
+
+}
@@ -0,0 +1,308 @@
+#include "TlsfAllocator.hpp"
+
+#include <bit>
+#include <cassert>
+
+namespace st::renderer
+{
+	TlsfAllocator::TlsfAllocator(uint64_t size):
+		m_firstLevelBitmap(0),
+		m_secondLevelBitmap(),
+		m_freeHeads(),
+		m_size(0),
+		m_usedSize(0),
+		m_allocationCount(0)
+	{
+		reset(size);
+	}
+
+	void TlsfAllocator::reset(uint64_t size)
+	{
+		m_nodes.clear();
+		m_unusedNodes.clear();
+
+		m_firstLevelBitmap = 0;
+		m_secondLevelBitmap.fill(0);
+		m_freeHeads.fill(invalidNode);
+
+		m_size = size;
+		m_usedSize = 0;
+		m_allocationCount = 0;
+
+		if (size > 0)
+		{
+			insertFree(createNode(0, size));
+		}
+	}
+
+	TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+	{
+		assert(alignment > 0 && std::has_single_bit(alignment));
+
+		size = size == 0 ? 1 : size;
+
+		// Worst case padding is searched for, so any block found can hold the aligned allocation
+		const uint32_t node = findFreeNode(size + alignment - 1);
+		if (node == invalidNode)
+		{
+			return {};
+		}
+
+		removeFree(node);
+
+		const uint64_t alignedOffset = (m_nodes[node].offset + alignment - 1) & ~(alignment - 1);
+		const uint64_t padding = alignedOffset - m_nodes[node].offset;
+		if (padding > 0)
+		{
+			insertFree(splitFront(node, padding));
+		}
+
+		if (m_nodes[node].size > size)
+		{
+			const uint32_t tail = createNode(m_nodes[node].offset + size, m_nodes[node].size - size);
+
+			m_nodes[tail].prevPhysical = node;
+			m_nodes[tail].nextPhysical = m_nodes[node].nextPhysical;
+			if (m_nodes[node].nextPhysical != invalidNode)
+			{
+				m_nodes[m_nodes[node].nextPhysical].prevPhysical = tail;
+			}
+
+			m_nodes[node].nextPhysical = tail;
+			m_nodes[node].size = size;
+
+			insertFree(tail);
+		}
+
+		m_nodes[node].used = true;
+		m_usedSize += size;
+		++m_allocationCount;
+
+		return { m_nodes[node].offset, node };
+	}
+
+	void TlsfAllocator::free(Allocation allocation)
+	{
+		if (!allocation.isValid())
+		{
+			return;
+		}
+
+		uint32_t node = allocation.node;
+		assert(m_nodes[node].used);
+
+		m_nodes[node].used = false;
+		m_usedSize -= m_nodes[node].size;
+		--m_allocationCount;
+
+		// Free neighbours are always merged, so at most one on each side has to be checked
+		const uint32_t prev = m_nodes[node].prevPhysical;
+		if (prev != invalidNode && !m_nodes[prev].used)
+		{
+			removeFree(prev);
+
+			m_nodes[prev].size += m_nodes[node].size;
+			m_nodes[prev].nextPhysical = m_nodes[node].nextPhysical;
+			if (m_nodes[node].nextPhysical != invalidNode)
+			{
+				m_nodes[m_nodes[node].nextPhysical].prevPhysical = prev;
+			}
+
+			releaseNode(node);
+			node = prev;
+		}
+
+		const uint32_t next = m_nodes[node].nextPhysical;
+		if (next != invalidNode && !m_nodes[next].used)
+		{
+			removeFree(next);
+
+			m_nodes[node].size += m_nodes[next].size;
+			m_nodes[node].nextPhysical = m_nodes[next].nextPhysical;
+			if (m_nodes[next].nextPhysical != invalidNode)
+			{
+				m_nodes[m_nodes[next].nextPhysical].prevPhysical = node;
+			}
+
+			releaseNode(next);
+		}
+
+		insertFree(node);
+	}
+
+	uint64_t TlsfAllocator::getAllocationSize(Allocation allocation) const
+	{
+		return allocation.isValid() ? m_nodes[allocation.node].size : 0;
+	}
+
+	uint64_t TlsfAllocator::getSize() const
+	{
+		return m_size;
+	}
+
+	uint64_t TlsfAllocator::getUsedSize() const
+	{
+		return m_usedSize;
+	}
+
+	uint32_t TlsfAllocator::getAllocationCount() const
+	{
+		return m_allocationCount;
+	}
+
+	bool TlsfAllocator::isEmpty() const
+	{
+		return m_allocationCount == 0;
+	}
+
+	void TlsfAllocator::mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		if (size < secondLevelCount)
+		{
+			// Small sizes get one exact bucket each
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size);
+			return;
+		}
+
+		const uint32_t log2 = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		firstLevel = log2 - secondLevelBits + 1;
+		secondLevel = static_cast<uint32_t>(size >> (log2 - secondLevelBits)) - secondLevelCount;
+	}
+
+	uint64_t TlsfAllocator::roundUpToBucket(uint64_t size)
+	{
+		if (size < secondLevelCount)
+		{
+			return size;
+		}
+
+		const uint32_t log2 = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		return size + (1ULL << (log2 - secondLevelBits)) - 1;
+	}
+
+	uint32_t TlsfAllocator::findFreeNode(uint64_t size) const
+	{
+		uint32_t firstLevel = 0;
+		uint32_t secondLevel = 0;
+		mapping(roundUpToBucket(size), firstLevel, secondLevel);
+
+		if (firstLevel >= firstLevelCount)
+		{
+			return invalidNode;
+		}
+
+		uint32_t secondLevelMap = m_secondLevelBitmap[firstLevel] & (~0U << secondLevel);
+		if (secondLevelMap == 0)
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < firstLevelCount ? m_firstLevelBitmap & (~0ULL << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+			{
+				return invalidNode;
+			}
+
+			firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+			secondLevelMap = m_secondLevelBitmap[firstLevel];
+		}
+
+		secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+		return m_freeHeads[firstLevel * secondLevelCount + secondLevel];
+	}
+
+	void TlsfAllocator::insertFree(uint32_t node)
+	{
+		uint32_t firstLevel = 0;
+		uint32_t secondLevel = 0;
+		mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+		uint32_t& head = m_freeHeads[firstLevel * secondLevelCount + secondLevel];
+
+		m_nodes[node].prevFree = invalidNode;
+		m_nodes[node].nextFree = head;
+		if (head != invalidNode)
+		{
+			m_nodes[head].prevFree = node;
+		}
+		head = node;
+
+		m_firstLevelBitmap |= 1ULL << firstLevel;
+		m_secondLevelBitmap[firstLevel] |= 1U << secondLevel;
+	}
+
+	void TlsfAllocator::removeFree(uint32_t node)
+	{
+		uint32_t firstLevel = 0;
+		uint32_t secondLevel = 0;
+		mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+		uint32_t& head = m_freeHeads[firstLevel * secondLevelCount + secondLevel];
+
+		const uint32_t prev = m_nodes[node].prevFree;
+		const uint32_t next = m_nodes[node].nextFree;
+
+		if (prev != invalidNode)
+		{
+			m_nodes[prev].nextFree = next;
+		}
+		if (next != invalidNode)
+		{
+			m_nodes[next].prevFree = prev;
+		}
+
+		if (head == node)
+		{
+			head = next;
+			if (head == invalidNode)
+			{
+				m_secondLevelBitmap[firstLevel] &= ~(1U << secondLevel);
+				if (m_secondLevelBitmap[firstLevel] == 0)
+				{
+					m_firstLevelBitmap &= ~(1ULL << firstLevel);
+				}
+			}
+		}
+
+		m_nodes[node].prevFree = invalidNode;
+		m_nodes[node].nextFree = invalidNode;
+	}
+
+	uint32_t TlsfAllocator::createNode(uint64_t offset, uint64_t size)
+	{
+		const Node node { offset, size, invalidNode, invalidNode, invalidNode, invalidNode, false };
+
+		if (!m_unusedNodes.empty())
+		{
+			const uint32_t index = m_unusedNodes.back();
+			m_unusedNodes.pop_back();
+			m_nodes[index] = node;
+			return index;
+		}
+
+		m_nodes.push_back(node);
+		return static_cast<uint32_t>(m_nodes.size() - 1);
+	}
+
+	void TlsfAllocator::releaseNode(uint32_t node)
+	{
+		m_unusedNodes.push_back(node);
+	}
+
+	uint32_t TlsfAllocator::splitFront(uint32_t node, uint64_t frontSize)
+	{
+		const uint32_t front = createNode(m_nodes[node].offset, frontSize);
+
+		m_nodes[front].prevPhysical = m_nodes[node].prevPhysical;
+		m_nodes[front].nextPhysical = node;
+		if (m_nodes[node].prevPhysical != invalidNode)
+		{
+			m_nodes[m_nodes[node].prevPhysical].nextPhysical = front;
+		}
+
+		m_nodes[node].prevPhysical = front;
+		m_nodes[node].offset += frontSize;
+		m_nodes[node].size -= frontSize;
+
+		return front;
+	}
+
+}
@@ -0,0 +1,329 @@
+#include "TransferContext.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace st::renderer
+{
+	TransferContext::~TransferContext()
+	{
+		shutdown();
+	}
+
+	void TransferContext::init(vk::PhysicalDevice physicalDevice,
+							   vk::Device device,
+							   vk::Queue queue,
+							   uint32_t queueFamilyIndex,
+							   uint32_t graphicsQueueFamilyIndex,
+							   MemoryAllocator& allocator,
+							   vk::DeviceSize stagingSize)
+	{
+		m_device = device;
+		m_queue = queue;
+		m_queueFamilyIndex = queueFamilyIndex;
+		m_graphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+		m_allocator = &allocator;
+
+		// Image copies need the offset to be a multiple of the texel size, 16 covers every format used
+		m_copyAlignment = std::max<vk::DeviceSize>(physicalDevice.getProperties().limits.optimalBufferCopyOffsetAlignment, 16);
+
+		m_commandPool = m_device.createCommandPool(vk::CommandPoolCreateInfo { vk::CommandPoolCreateFlagBits::eTransient |
+																				   vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+																			   queueFamilyIndex });
+
+		vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> timelineInfo { {}, { vk::SemaphoreType::eTimeline, 0 } };
+		m_timeline = m_device.createSemaphore(timelineInfo.get<vk::SemaphoreCreateInfo>());
+
+		m_stagingRing.init(m_device, allocator, stagingSize);
+	}
+
+	void TransferContext::shutdown()
+	{
+		if (!m_commandPool)
+		{
+			return;
+		}
+
+		waitIdle();
+
+		m_freeBatches.clear();
+		m_pendingBufferAcquires.clear();
+		m_pendingImageAcquires.clear();
+
+		m_stagingRing.shutdown();
+
+		m_device.destroySemaphore(m_timeline);
+		m_device.destroyCommandPool(m_commandPool);
+		m_commandPool = nullptr;
+	}
+
+	void TransferContext::uploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, std::span<const std::byte> data)
+	{
+		if (data.empty())
+		{
+			return;
+		}
+
+		const StagingRegion staging = acquireStaging(data.size(), data);
+
+		vk::CommandBuffer commandBuffer = recordingCommandBuffer();
+
+		const vk::BufferCopy region { staging.offset, dstOffset, data.size() };
+		commandBuffer.copyBuffer(staging.buffer, dstBuffer, region);
+
+		if (hasOwnershipTransfer())
+		{
+			const vk::BufferMemoryBarrier release { vk::AccessFlagBits::eTransferWrite,
+													{},
+													m_queueFamilyIndex,
+													m_graphicsQueueFamilyIndex,
+													dstBuffer,
+													dstOffset,
+													data.size() };
+
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, release, {});
+
+			vk::BufferMemoryBarrier acquire = release;
+			acquire.srcAccessMask = {};
+			acquire.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead |
+									vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eIndirectCommandRead;
+
+			m_recording->bufferAcquires.push_back(acquire);
+		}
+	}
+
+	void TransferContext::uploadImage(vk::Image dstImage,
+									  vk::Extent3D extent,
+									  std::span<const std::byte> data,
+									  vk::ImageLayout finalLayout,
+									  vk::ImageAspectFlags aspect)
+	{
+		const StagingRegion staging = acquireStaging(data.size(), data);
+
+		vk::CommandBuffer commandBuffer = recordingCommandBuffer();
+
+		const vk::ImageSubresourceRange range { aspect, 0, 1, 0, 1 };
+
+		vk::ImageMemoryBarrier toTransfer { {},
+											vk::AccessFlagBits::eTransferWrite,
+											vk::ImageLayout::eUndefined,
+											vk::ImageLayout::eTransferDstOptimal,
+											VK_QUEUE_FAMILY_IGNORED,
+											VK_QUEUE_FAMILY_IGNORED,
+											dstImage,
+											range };
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, toTransfer);
+
+		const vk::BufferImageCopy region { staging.offset, 0, 0, { aspect, 0, 0, 1 }, { 0, 0, 0 }, extent };
+		commandBuffer.copyBufferToImage(staging.buffer, dstImage, vk::ImageLayout::eTransferDstOptimal, region);
+
+		// Visibility for the readers comes from the timeline wait or the acquire barrier,
+		// the release only changes the layout and the owner
+		vk::ImageMemoryBarrier release { vk::AccessFlagBits::eTransferWrite,
+										 {},
+										 vk::ImageLayout::eTransferDstOptimal,
+										 finalLayout,
+										 VK_QUEUE_FAMILY_IGNORED,
+										 VK_QUEUE_FAMILY_IGNORED,
+										 dstImage,
+										 range };
+
+		if (hasOwnershipTransfer())
+		{
+			release.srcQueueFamilyIndex = m_queueFamilyIndex;
+			release.dstQueueFamilyIndex = m_graphicsQueueFamilyIndex;
+
+			vk::ImageMemoryBarrier acquire = release;
+			acquire.srcAccessMask = {};
+			acquire.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+			m_recording->imageAcquires.push_back(acquire);
+		}
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, release);
+	}
+
+	uint64_t TransferContext::flush()
+	{
+		if (!m_recording)
+		{
+			return m_lastSubmitted;
+		}
+
+		m_recording->commandBuffer.end();
+
+		const uint64_t signalValue = m_recording->submission;
+		const vk::TimelineSemaphoreSubmitInfo timelineInfo { {}, signalValue };
+
+		vk::SubmitInfo submitInfo { {}, {}, m_recording->commandBuffer, m_timeline };
+		submitInfo.setPNext(&timelineInfo);
+
+		m_queue.submit(submitInfo);
+
+		m_pendingBufferAcquires.insert(m_pendingBufferAcquires.end(), m_recording->bufferAcquires.begin(), m_recording->bufferAcquires.end());
+		m_pendingImageAcquires.insert(m_pendingImageAcquires.end(), m_recording->imageAcquires.begin(), m_recording->imageAcquires.end());
+		m_recording->bufferAcquires.clear();
+		m_recording->imageAcquires.clear();
+
+		m_lastSubmitted = m_recording->submission;
+		m_inFlight.push_back(std::move(*m_recording));
+		m_recording.reset();
+
+		return m_lastSubmitted;
+	}
+
+	void TransferContext::recordAcquireBarriers(vk::CommandBuffer commandBuffer)
+	{
+		if (m_pendingBufferAcquires.empty() && m_pendingImageAcquires.empty())
+		{
+			return;
+		}
+
+		// Ordered after the release by the timeline wait at consumerStages
+		commandBuffer.pipelineBarrier(consumerStages, consumerStages, {}, {}, m_pendingBufferAcquires, m_pendingImageAcquires);
+
+		m_pendingBufferAcquires.clear();
+		m_pendingImageAcquires.clear();
+	}
+
+	void TransferContext::collect()
+	{
+		if (m_inFlight.empty())
+		{
+			return;
+		}
+
+		const uint64_t completed = m_device.getSemaphoreCounterValue(m_timeline);
+
+		while (!m_inFlight.empty() && m_inFlight.front().submission <= completed)
+		{
+			retire(m_inFlight.front());
+
+			m_freeBatches.push_back(std::move(m_inFlight.front()));
+			m_inFlight.pop_front();
+		}
+	}
+
+	bool TransferContext::isComplete(uint64_t submission)
+	{
+		collect();
+		return submission <= m_lastCompleted;
+	}
+
+	void TransferContext::wait(uint64_t submission)
+	{
+		if (m_recording && m_recording->submission <= submission)
+		{
+			flush();
+		}
+
+		submission = std::min(submission, m_lastSubmitted);
+		if (submission <= m_lastCompleted)
+		{
+			return;
+		}
+
+		const vk::SemaphoreWaitInfo waitInfo { {}, m_timeline, submission };
+		auto result = m_device.waitSemaphores(waitInfo, UINT64_MAX);
+		if (result != vk::Result::eSuccess)
+		{
+			throw std::runtime_error("failed to wait for transfer batch!");
+		}
+
+		collect();
+	}
+
+	void TransferContext::waitIdle()
+	{
+		wait(flush());
+	}
+
+	vk::Semaphore TransferContext::getTimelineSemaphore() const
+	{
+		return m_timeline;
+	}
+
+	uint64_t TransferContext::getLastSubmitted() const
+	{
+		return m_lastSubmitted;
+	}
+
+	bool TransferContext::hasOwnershipTransfer() const
+	{
+		return m_queueFamilyIndex != m_graphicsQueueFamilyIndex;
+	}
+
+	vk::CommandBuffer TransferContext::recordingCommandBuffer()
+	{
+		if (m_recording)
+		{
+			return m_recording->commandBuffer;
+		}
+
+		if (!m_freeBatches.empty())
+		{
+			m_recording = std::move(m_freeBatches.back());
+			m_freeBatches.pop_back();
+		}
+		else
+		{
+			m_recording.emplace();
+
+			const vk::CommandBufferAllocateInfo allocInfo { m_commandPool, vk::CommandBufferLevel::ePrimary, 1 };
+			m_recording->commandBuffer = m_device.allocateCommandBuffers(allocInfo).front();
+		}
+
+		m_recording->submission = m_nextSubmission++;
+		m_recording->commandBuffer.begin(vk::CommandBufferBeginInfo { vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+		return m_recording->commandBuffer;
+	}
+
+	StagingRegion TransferContext::acquireStaging(vk::DeviceSize size, std::span<const std::byte> data)
+	{
+		recordingCommandBuffer();
+
+		if (size > m_stagingRing.getSize())
+		{
+			vk::Buffer buffer = m_device.createBuffer(vk::BufferCreateInfo { {}, size, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive });
+			MemoryAllocation memory =
+				m_allocator->allocateForBuffer(buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+			m_device.bindBufferMemory(buffer, memory.memory, memory.offset);
+
+			std::memcpy(memory.mappedData, data.data(), data.size());
+
+			m_recording->oversizedStaging.emplace_back(buffer, memory);
+
+			return StagingRegion { buffer, 0, size, static_cast<std::byte*>(memory.mappedData) };
+		}
+
+		std::optional<StagingRegion> region = m_stagingRing.allocate(size, m_copyAlignment, m_recording->submission);
+		while (!region)
+		{
+			// Ring is full, submit what is recorded and reclaim the oldest batch
+			const uint64_t submission = flush();
+			wait(m_inFlight.empty() ? submission : m_inFlight.front().submission);
+
+			recordingCommandBuffer();
+			region = m_stagingRing.allocate(size, m_copyAlignment, m_recording->submission);
+		}
+
+		std::memcpy(region->mappedData, data.data(), data.size());
+		return *region;
+	}
+
+	void TransferContext::retire(Batch& batch)
+	{
+		for (auto& [buffer, memory] : batch.oversizedStaging)
+		{
+			m_device.destroyBuffer(buffer);
+			m_allocator->free(memory);
+		}
+		batch.oversizedStaging.clear();
+
+		m_stagingRing.retire(batch.submission);
+		m_lastCompleted = batch.submission;
+	}
+
+}
@@ -0,0 +1,96 @@
+#include "UniformRing.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace st::renderer
+{
+	namespace
+	{
+		vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	UniformRing::~UniformRing()
+	{
+		shutdown();
+	}
+
+	void UniformRing::init(vk::PhysicalDevice physicalDevice,
+						   vk::Device device,
+						   MemoryAllocator& allocator,
+						   uint32_t frameCount,
+						   vk::DeviceSize frameSize)
+	{
+		m_device = device;
+		m_allocator = &allocator;
+
+		m_alignment = std::max<vk::DeviceSize>(physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment, 1);
+		m_frameSize = alignUp(frameSize, m_alignment);
+
+		m_buffer = m_device.createBuffer(vk::BufferCreateInfo { {}, m_frameSize * frameCount, vk::BufferUsageFlagBits::eUniformBuffer, vk::SharingMode::eExclusive });
+
+		// Coherency is not required, flush() takes care of non-coherent memory types
+		m_memory = m_allocator->allocateForBuffer(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible);
+		m_device.bindBufferMemory(m_buffer, m_memory.memory, m_memory.offset);
+
+		beginFrame(0);
+	}
+
+	void UniformRing::shutdown()
+	{
+		if (!m_buffer)
+		{
+			return;
+		}
+
+		m_device.destroyBuffer(m_buffer);
+		m_allocator->free(m_memory);
+		m_buffer = nullptr;
+	}
+
+	void UniformRing::beginFrame(uint32_t frameIndex)
+	{
+		m_frameBegin = m_frameSize * frameIndex;
+		m_head = m_frameBegin;
+		m_flushedHead = m_frameBegin;
+	}
+
+	uint32_t UniformRing::push(const void* data, vk::DeviceSize size)
+	{
+		const vk::DeviceSize offset = alignUp(m_head, m_alignment);
+		if (offset + size > m_frameBegin + m_frameSize)
+		{
+			throw std::runtime_error("uniform ring frame region overflow!");
+		}
+
+		std::memcpy(static_cast<std::byte*>(m_memory.mappedData) + offset, data, size);
+		m_head = offset + size;
+
+		return static_cast<uint32_t>(offset);
+	}
+
+	void UniformRing::flush()
+	{
+		if (m_head == m_flushedHead)
+		{
+			return;
+		}
+
+		m_allocator->flush(m_memory, m_flushedHead, m_head - m_flushedHead);
+		m_flushedHead = m_head;
+	}
+
+	vk::Buffer UniformRing::getBuffer() const
+	{
+		return m_buffer;
+	}
+
+	vk::DeviceSize UniformRing::getAlignment() const
+	{
+		return m_alignment;
+	}
+
+}
@@ -6,7 +6,18 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include "StCore/FixedTimestep.hpp"
+#include "StCore/TripleBuffer.hpp"
+#include "StMath/TransformBuffer.hpp"
+#include "StRenderer/Camera.hpp"
 #include "StRenderer/Renderer.hpp"
 
 
@@ -19,6 +30,222 @@ const bool enableValidationLayers = true;
 static constexpr uint32_t initialWindowsWidth = 1280;
 static constexpr uint32_t initialWindowsHeight = 720;
 
+static const std::vector<st::renderer::Vertex> planeVertexes {
+    {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+    {{ 0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+    {{ 0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+    {{-0.5f, 0.5f,  0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}
+};
+
+static const std::vector<uint32_t> planeIndices = {
+    0, 1, 2, 2, 3, 0
+};
+
+static constexpr int planeGridSize = 4;
+static constexpr float planeGridSpacing = 1.25f;
+
+// ImGui reuses its draw lists on the next NewFrame, a frame rendered on another thread needs its own
+class UiDrawData
+{
+public:
+    UiDrawData() = default;
+    ~UiDrawData()
+    {
+        clear();
+    }
+
+    UiDrawData(const UiDrawData&) = delete;
+    UiDrawData& operator=(const UiDrawData&) = delete;
+
+    void capture(const ImDrawData* source)
+    {
+        clear();
+
+        m_drawData = *source;
+        for (int i = 0; i < source->CmdListsCount; ++i)
+        {
+            m_drawLists.push_back(source->CmdLists[i]->CloneOutput());
+        }
+        setDrawLists(m_drawData, m_drawLists);
+    }
+
+    ImDrawData* get()
+    {
+        return &m_drawData;
+    }
+
+private:
+    // CmdLists became an ImVector in ImGui 1.89.8, a raw array before
+    template <typename DrawData>
+    static void setDrawLists(DrawData& drawData, std::vector<ImDrawList*>& drawLists)
+    {
+        if constexpr (std::is_pointer_v<decltype(drawData.CmdLists)>)
+        {
+            drawData.CmdLists = drawLists.data();
+        }
+        else
+        {
+            drawData.CmdLists.resize(static_cast<int>(drawLists.size()));
+            for (size_t i = 0; i < drawLists.size(); ++i)
+            {
+                drawData.CmdLists[static_cast<int>(i)] = drawLists[i];
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (ImDrawList* drawList : m_drawLists)
+        {
+            IM_DELETE(drawList);
+        }
+        m_drawLists.clear();
+        m_drawData = ImDrawData {};
+    }
+
+    ImDrawData m_drawData;
+    std::vector<ImDrawList*> m_drawLists;
+};
+
+// Everything the render thread needs for one frame, written by the main thread only
+struct FrameSnapshot
+{
+    uint32_t framebufferWidth { 0 };
+    uint32_t framebufferHeight { 0 };
+    st::math::Matrix4x4 view;
+
+    std::vector<st::renderer::InstanceData> planeInstances;
+    st::math::Matrix4x4 backdropModel;
+
+    UiDrawData ui;
+    std::optional<st::renderer::PresentationProfile> presentationProfile;
+    bool quit { false };
+};
+
+// Renderer state shown in the UI, read back by the main thread a frame or more late
+struct RendererReport
+{
+    st::renderer::DrawStatistics drawStatistics;
+    FrameTimings frameTimings;
+    st::renderer::RenderGraphStatistics graphStatistics;
+    st::renderer::MemoryStatistics memoryStatistics;
+    st::renderer::PresentationProfile presentationProfile { st::renderer::PresentationProfile::eThroughput };
+};
+
+// Mouse input is queued by the GLFW callbacks and applied by the next simulation tick
+struct MouseEvent
+{
+    enum class Type
+    {
+        ePress,
+        eMove,
+        eRelease
+    };
+
+    Type type;
+    int64_t x;
+    int64_t y;
+    st::renderer::Camera::Actions action { st::renderer::Camera::Actions::NoAction };
+};
+
+// State advanced in fixed ticks, rendering only reads it through interpolation
+struct Simulation
+{
+    st::renderer::Camera camera;
+    st::math::Vector3 previousEye;
+    st::math::Vector3 previousCenter;
+
+    st::math::TransformBuffer planes;
+    std::vector<float> planeAngles;
+    std::vector<float> planeSpeeds;
+
+    std::vector<MouseEvent> pendingInput;
+};
+
+static void simulationTick(Simulation& simulation, float seconds)
+{
+    simulation.previousEye = simulation.camera.getEye();
+    simulation.previousCenter = simulation.camera.getCenter();
+    for (const MouseEvent& event : simulation.pendingInput)
+    {
+        switch (event.type)
+        {
+        case MouseEvent::Type::ePress:
+            simulation.camera.mousePressEvent(event.x, event.y, event.action);
+            break;
+        case MouseEvent::Type::eMove:
+            simulation.camera.mouseMove(event.x, event.y);
+            break;
+        case MouseEvent::Type::eRelease:
+            simulation.camera.releaseMouseClick();
+            break;
+        }
+    }
+    simulation.pendingInput.clear();
+
+    // Every plane spins in place around its normal
+    simulation.planes.beginTick();
+    st::math::TransformStream& planes = simulation.planes.current();
+    for (size_t i = 0; i < simulation.planeAngles.size(); ++i)
+    {
+        simulation.planeAngles[i] = std::fmod(simulation.planeAngles[i] + simulation.planeSpeeds[i] * seconds, 2.0f * std::numbers::pi_v<float>);
+        planes.rotationZ[i] = std::sin(simulation.planeAngles[i] * 0.5f);
+        planes.rotationW[i] = std::cos(simulation.planeAngles[i] * 0.5f);
+    }
+}
+
+static st::math::Matrix4x4 interpolateView(Simulation& simulation, float alpha)
+{
+    const st::math::Vector3 eye = simulation.previousEye * (1.0f - alpha) + simulation.camera.getEye() * alpha;
+    const st::math::Vector3 center = simulation.previousCenter * (1.0f - alpha) + simulation.camera.getCenter() * alpha;
+    return simulation.camera.lookAt(eye, center, simulation.camera.getUp());
+}
+
+static void renderFrame(VulkanRenderer& vulkanRenderer,
+                        FrameSnapshot& snapshot,
+                        st::renderer::MeshHandle planeMesh,
+                        st::renderer::TextureHandle secondTexture,
+                        uint32_t& framebufferWidth,
+                        uint32_t& framebufferHeight)
+{
+    if (snapshot.framebufferWidth != framebufferWidth || snapshot.framebufferHeight != framebufferHeight)
+    {
+        framebufferWidth = snapshot.framebufferWidth;
+        framebufferHeight = snapshot.framebufferHeight;
+        vulkanRenderer.resizeFramebuffer(framebufferWidth, framebufferHeight);
+    }
+
+    vulkanRenderer.setViewMatrix(snapshot.view);
+    vulkanRenderer.startFrame();
+
+    auto commandBuffer = vulkanRenderer.beginUiRendering();
+    ImGui_ImplVulkan_RenderDrawData(snapshot.ui.get(), commandBuffer);
+    vulkanRenderer.endUiRendering(commandBuffer);
+
+    vulkanRenderer.drawMeshInstanced(planeMesh, snapshot.planeInstances);
+    vulkanRenderer.drawMesh(planeMesh, snapshot.backdropModel, secondTexture);
+
+    vulkanRenderer.endFrame();
+
+    if (snapshot.presentationProfile)
+    {
+        vulkanRenderer.setPresentationPolicy(st::renderer::PresentationPolicy::make(*snapshot.presentationProfile));
+    }
+
+    // A resize or a policy change may recreate the swapchain with another image count, ImGui only
+    // rebuilds its buffers when the count differs
+    ImGui_ImplVulkan_SetMinImageCount(vulkanRenderer.getMinImageCount());
+}
+
+static void writeReport(const VulkanRenderer& vulkanRenderer, RendererReport& report)
+{
+    report.drawStatistics = vulkanRenderer.getDrawStatistics();
+    report.frameTimings = vulkanRenderer.getFrameTimings();
+    report.graphStatistics = vulkanRenderer.getRenderGraphStatistics();
+    report.memoryStatistics = vulkanRenderer.getMemoryStatistics();
+    report.presentationProfile = vulkanRenderer.getPresentationPolicy().profile;
+}
+
 static void check_vk_result(VkResult err)
 {
     if (err == 0)
@@ -137,7 +364,11 @@ vk::SurfaceKHR createSurface(vk::Instance& instance, GLFWwindow* window)
     return  static_cast<vk::SurfaceKHR>(surface);
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Renders on a thread of its own, the main thread builds the next frame meanwhile
+    const bool renderThread = argc > 1 && std::string(argv[1]) == "--render-thread";
+
+
     // Initialize GLFW
     glfwInit();
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -167,6 +398,78 @@ int main() {
                                 surface,
                                 VulkanRendererValidationLayerLevel::eEnabled);
 
+    st::renderer::MeshHandle planeMesh = vulkanRenderer.createMesh(planeVertexes, planeIndices);
+
+    st::renderer::TextureHandle secondTexture = vulkanRenderer.createTexture("Assets/Textures/texture2.jpg");
+
+    std::vector<st::renderer::InstanceData> planeInstances;
+    for (int y = 0; y < planeGridSize; ++y)
+    {
+        for (int x = 0; x < planeGridSize; ++x)
+        {
+            st::renderer::InstanceData instance;
+            instance.m_model.translate({ (x - (planeGridSize - 1) * 0.5f) * planeGridSpacing,
+                                         (y - (planeGridSize - 1) * 0.5f) * planeGridSpacing,
+                                         0.0f });
+            instance.m_color = st::math::Vector4 { static_cast<float>(x + 1) / planeGridSize,
+                                                   static_cast<float>(y + 1) / planeGridSize,
+                                                   1.0f,
+                                                   1.0f };
+            // Checkerboard of both textures, all instances stay in one draw
+            instance.m_materialIndex = (x + y) % 2 == 0 ? 0 : secondTexture;
+            planeInstances.push_back(instance);
+        }
+    }
+
+    // A lone plane behind the grid goes through the push constant path
+    st::math::Matrix4x4 backdropModel = st::math::Matrix4x4::indentityMatrix();
+    backdropModel.translate({ 0.0f, 0.0f, -1.0f });
+
+    Simulation simulation;
+    simulation.previousEye = simulation.camera.getEye();
+    simulation.previousCenter = simulation.camera.getCenter();
+    simulation.planes.resize(planeInstances.size());
+    for (size_t i = 0; i < planeInstances.size(); ++i)
+    {
+        st::math::TransformStream& planes = simulation.planes.current();
+        planes.positionX[i] = planeInstances[i].m_model[3];
+        planes.positionY[i] = planeInstances[i].m_model[7];
+        planes.positionZ[i] = planeInstances[i].m_model[11];
+
+        simulation.planeAngles.push_back(0.0f);
+        simulation.planeSpeeds.push_back(0.5f + 0.25f * static_cast<float>(i % 4));
+    }
+    // Both ticks start at rest
+    simulation.planes.beginTick();
+    std::vector<st::math::Matrix4x4> planeModels(planeInstances.size());
+
+    // Installed before the ImGui backend, which chains to them
+    glfwSetWindowUserPointer(window, &simulation);
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* clickedWindow, int button, int action, int) {
+        auto* simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(clickedWindow));
+        if (ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse && action == GLFW_PRESS)
+        {
+            return;
+        }
+
+        double x = 0.0;
+        double y = 0.0;
+        glfwGetCursorPos(clickedWindow, &x, &y);
+
+        MouseEvent event { action == GLFW_PRESS ? MouseEvent::Type::ePress : MouseEvent::Type::eRelease,
+                           static_cast<int64_t>(x),
+                           static_cast<int64_t>(y) };
+        event.action = button == GLFW_MOUSE_BUTTON_LEFT    ? st::renderer::Camera::Actions::Orbit :
+                       button == GLFW_MOUSE_BUTTON_RIGHT   ? st::renderer::Camera::Actions::Pan :
+                       button == GLFW_MOUSE_BUTTON_MIDDLE  ? st::renderer::Camera::Actions::Zoom :
+                                                             st::renderer::Camera::Actions::NoAction;
+        simulation->pendingInput.push_back(event);
+    });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* movedWindow, double x, double y) {
+        auto* simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(movedWindow));
+        simulation->pendingInput.push_back(MouseEvent { MouseEvent::Type::eMove, static_cast<int64_t>(x), static_cast<int64_t>(y) });
+    });
+
 
     // Initialize ImGui
     IMGUI_CHECKVERSION();
@@ -188,8 +491,9 @@ int main() {
     init_info.PipelineCache = {};
     init_info.DescriptorPool = vulkanRenderer.getUiDescriptorPool();
     init_info.Subpass = 0;
-    init_info.MinImageCount = 2;
-    init_info.ImageCount = 2;
+    init_info.MinImageCount = vulkanRenderer.getMinImageCount();
+    // ImGui keeps one set of buffers per image count, it has to cover every frame slot
+    init_info.ImageCount = VulkanRenderer::MAX_FRAMES_IN_FLIGHT;
     init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
     init_info.Allocator = {};
     init_info.CheckVkResultFn = check_vk_result;
@@ -205,11 +509,68 @@ int main() {
     }
     
 
-    ImGui_ImplVulkan_SetMinImageCount(2);
+    st::core::TripleBuffer<FrameSnapshot> snapshots;
+    st::core::TripleBuffer<RendererReport> reports;
+    RendererReport report;
+    writeReport(vulkanRenderer, report);
+
+    uint32_t renderedWidth = initialWindowsWidth;
+    uint32_t renderedHeight = initialWindowsHeight;
+
+    std::thread renderer;
+    if (renderThread)
+    {
+        renderer = std::thread([&] {
+            while (true)
+            {
+                snapshots.waitForPublish();
+                snapshots.acquire();
+
+                FrameSnapshot& snapshot = snapshots.getReadBuffer();
+                if (snapshot.quit)
+                {
+                    return;
+                }
+
+                renderFrame(vulkanRenderer, snapshot, planeMesh, secondTexture, renderedWidth, renderedHeight);
+
+                writeReport(vulkanRenderer, reports.getWriteBuffer());
+                reports.publish();
+            }
+        });
+    }
+
+    // The simulation runs at a fixed rate whatever the display does
+    st::core::FixedTimestep timestep;
+    auto previousTime = std::chrono::steady_clock::now();
+
     // Main loop
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
+        const auto now = std::chrono::steady_clock::now();
+        const uint32_t ticks = timestep.advance(std::chrono::duration<double>(now - previousTime).count());
+        previousTime = now;
+        for (uint32_t tick = 0; tick < ticks; ++tick)
+        {
+            simulationTick(simulation, static_cast<float>(timestep.getTickSeconds()));
+        }
+
+        // A minimized window has no area to create a swapchain for
+        int framebufferWidth = 0;
+        int framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        if (framebufferWidth == 0 || framebufferHeight == 0)
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        if (reports.acquire())
+        {
+            report = reports.getReadBuffer();
+        }
+
         // Start the ImGui frame
         ImGui_ImplVulkan_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -224,29 +585,89 @@ int main() {
             // This code block will run when the button is pressed.
         }
 
-        ImGui::Render();
-
-        //renderer->update
-        //auto* test = ImGui::GetDrawData();
-        //vulkanRenderer.renderFrame(test);
-        //ImGui_ImplVulkan_RenderDrawData()
-
-        //renderer -> start frame
-        vulkanRenderer.startFrame();
+        const st::renderer::DrawStatistics& drawStatistics = report.drawStatistics;
+        ImGui::Begin("Renderer");
+        ImGui::Text("Render thread %d", renderThread);
+        ImGui::Text("Simulation %.0f Hz, %u ticks this frame", 1.0 / timestep.getTickSeconds(), ticks);
+        ImGui::Text("Draws %u", drawStatistics.drawCount);
+        ImGui::Text("Pipeline binds %u, buffer binds %u", drawStatistics.pipelineBinds, drawStatistics.bufferBinds);
+        ImGui::Text("Binds saved %u", drawStatistics.bindsSaved);
+
+        const FrameTimings& frameTimings = report.frameTimings;
+        ImGui::Text("Frame %.2f ms (average %.2f ms)", frameTimings.frameTime, frameTimings.averageFrameTime);
+        ImGui::Text("Fence wait %.2f ms", frameTimings.fenceWaitTime);
+
+        const st::renderer::RenderGraphStatistics& graphStatistics = report.graphStatistics;
+        ImGui::Text("Passes %u (culled %u), barriers %u", graphStatistics.passCount, graphStatistics.culledPassCount, graphStatistics.barrierCount);
+        ImGui::Text("Transient memory %llu / %llu KiB",
+                    static_cast<unsigned long long>(graphStatistics.transientBytes >> 10),
+                    static_cast<unsigned long long>(graphStatistics.unaliasedBytes >> 10));
+
+        const st::renderer::DeviceFeatures& deviceFeatures = vulkanRenderer.getDeviceFeatures();
+        ImGui::Text("Bindless %d, indirect count %d, multi draw %d",
+                    deviceFeatures.descriptorIndexing,
+                    deviceFeatures.drawIndirectCount,
+                    deviceFeatures.multiDrawIndirect);
+        ImGui::Text("Transfer queue %d, memory budget %d", deviceFeatures.dedicatedTransferQueue, deviceFeatures.memoryBudget);
+        if (deviceFeatures.memoryBudget)
+        {
+            const st::renderer::MemoryStatistics& memoryStatistics = report.memoryStatistics;
+            ImGui::Text("Device memory %llu / %llu MiB",
+                        static_cast<unsigned long long>(memoryStatistics.deviceLocalUsage >> 20),
+                        static_cast<unsigned long long>(memoryStatistics.deviceLocalBudget >> 20));
+        }
 
-        auto commandBuffer = vulkanRenderer.beginUiRendering();
-        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(),commandBuffer);
-        vulkanRenderer.endUiRendering(commandBuffer);
+        const char* presentationProfiles[] = { "Low latency", "Throughput", "Power saving" };
+        int presentationProfile = static_cast<int>(report.presentationProfile);
+        const bool presentationChanged = ImGui::Combo("Presentation", &presentationProfile, presentationProfiles, IM_ARRAYSIZE(presentationProfiles));
+        ImGui::End();
 
-        vulkanRenderer.endFrame();
+        ImGui::Render();
 
-        //renderer -> render ui
+        // At most one frame ahead of the render thread, a newer snapshot would only replace it
+        if (renderThread)
+        {
+            snapshots.waitUntilConsumed();
+        }
 
+        FrameSnapshot& snapshot = snapshots.getWriteBuffer();
+        snapshot.framebufferWidth = static_cast<uint32_t>(framebufferWidth);
+        snapshot.framebufferHeight = static_cast<uint32_t>(framebufferHeight);
+        // Rendered state lags the simulation by up to one tick, in exchange it moves every frame
+        const float alpha = timestep.getAlpha();
+        simulation.planes.interpolate(alpha, planeModels);
+        for (size_t i = 0; i < planeInstances.size(); ++i)
+        {
+            planeInstances[i].m_model = planeModels[i];
+        }
 
-        //renderer -> stop frame
+        snapshot.view = interpolateView(simulation, alpha);
+        snapshot.planeInstances = planeInstances;
+        snapshot.backdropModel = backdropModel;
+        snapshot.ui.capture(ImGui::GetDrawData());
+        snapshot.presentationProfile.reset();
+        if (presentationChanged)
+        {
+            snapshot.presentationProfile = static_cast<st::renderer::PresentationProfile>(presentationProfile);
+        }
 
+        if (renderThread)
+        {
+            snapshots.publish();
+        }
+        else
+        {
+            renderFrame(vulkanRenderer, snapshot, planeMesh, secondTexture, renderedWidth, renderedHeight);
+            writeReport(vulkanRenderer, report);
+        }
+    }
 
-        //ImGui::End();
+    if (renderThread)
+    {
+        snapshots.waitUntilConsumed();
+        snapshots.getWriteBuffer().quit = true;
+        snapshots.publish();
+        renderer.join();
     }
 
     // Cleanup
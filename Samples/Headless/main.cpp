@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "StRenderer/Renderer.hpp"
+
+// Renders the plane grid of the desktop sample without a window, any Vulkan device will do,
+// including CPU implementations such as lavapipe or SwiftShader.
+//
+// Usage: Headless_Renderer [frames] [capture.ppm|capture.png]
+
+#ifdef NDEBUG
+const bool enableValidationLayers = false;
+#else
+const bool enableValidationLayers = true;
+#endif
+
+static constexpr uint32_t frameWidth = 1280;
+static constexpr uint32_t frameHeight = 720;
+static constexpr uint32_t defaultFrameCount = 500;
+// Caches, rings and frame arenas have grown to their working size by then
+static constexpr uint32_t warmupFrameCount = 16;
+
+static const std::vector<st::renderer::Vertex> planeVertexes {
+    {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+    {{ 0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+    {{ 0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+    {{-0.5f, 0.5f,  0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}
+};
+
+static const std::vector<uint32_t> planeIndices = {
+    0, 1, 2, 2, 3, 0
+};
+
+static constexpr int planeGridSize = 16;
+static constexpr float planeGridSpacing = 1.25f;
+
+// Every global heap allocation of the process, the frame loop reports how many it makes once warmed
+// up. Validation layers allocate on their own, release builds show the renderer alone.
+static std::atomic<uint64_t> heapAllocationCount { 0 };
+
+void* operator new(std::size_t size)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept
+{
+    std::free(memory);
+}
+
+// Over-aligned types skip the overloads above, the pointer from malloc is kept in front of the block
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    if (void* memory = std::malloc(size + align + sizeof(void*)))
+    {
+        const std::uintptr_t address = (reinterpret_cast<std::uintptr_t>(memory) + sizeof(void*) + align - 1) & ~(align - 1);
+        reinterpret_cast<void**>(address)[-1] = memory;
+        return reinterpret_cast<void*>(address);
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t /*alignment*/) noexcept
+{
+    if (memory != nullptr)
+    {
+        std::free(static_cast<void**>(memory)[-1]);
+    }
+}
+
+void operator delete(void* memory, std::size_t /*size*/, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+vk::Instance createInstance()
+{
+    vk::ApplicationInfo appInfo { "Android Vulkan Demo Headless",
+                                  1,
+                                  "No Engine",
+                                  1,
+                                  VK_API_VERSION_1_2 };
+
+    // No surface extensions, the instance works on machines without a display
+    std::vector<const char*> enabledLayers;
+    std::vector<const char*> enabledExtensions;
+    if (enableValidationLayers)
+    {
+        enabledLayers.push_back("VK_LAYER_KHRONOS_validation");
+        enabledExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
+
+    vk::InstanceCreateInfo instanceCreateInfo {
+        {},
+        &appInfo,
+        enabledLayers,
+        enabledExtensions };
+
+    return vk::createInstance(instanceCreateInfo);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t frameCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : defaultFrameCount;
+    const std::string capturePath = argc > 2 ? argv[2] : std::string {};
+
+    vk::Instance instance = createInstance();
+
+    VulkanRenderer vulkanRenderer;
+    vulkanRenderer.initHeadless(instance,
+                                frameWidth,
+                                frameHeight,
+                                enableValidationLayers ? VulkanRendererValidationLayerLevel::eEnabled : VulkanRendererValidationLayerLevel::eNone);
+
+    st::renderer::MeshHandle planeMesh = vulkanRenderer.createMesh(planeVertexes, planeIndices);
+
+    std::vector<st::renderer::InstanceData> planeInstances;
+    for (int y = 0; y < planeGridSize; ++y)
+    {
+        for (int x = 0; x < planeGridSize; ++x)
+        {
+            st::renderer::InstanceData instance;
+            instance.m_model.translate({ (x - (planeGridSize - 1) * 0.5f) * planeGridSpacing,
+                                         (y - (planeGridSize - 1) * 0.5f) * planeGridSpacing,
+                                         0.0f });
+            instance.m_color = st::math::Vector4 { static_cast<float>(x + 1) / planeGridSize,
+                                                   static_cast<float>(y + 1) / planeGridSize,
+                                                   1.0f,
+                                                   1.0f };
+            planeInstances.push_back(instance);
+        }
+    }
+
+    uint64_t steadyAllocations = 0;
+    uint32_t steadyFrames = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        const uint64_t frameAllocationStart = heapAllocationCount.load(std::memory_order_relaxed);
+
+        const bool capture = !capturePath.empty() && frame + 1 == frameCount;
+        if (capture)
+        {
+            vulkanRenderer.captureFrame(capturePath);
+        }
+
+        vulkanRenderer.startFrame();
+
+        auto commandBuffer = vulkanRenderer.beginUiRendering();
+        vulkanRenderer.endUiRendering(commandBuffer);
+
+        vulkanRenderer.drawMeshInstanced(planeMesh, planeInstances);
+
+        vulkanRenderer.endFrame();
+
+        // The capture frame reads back and encodes the image, it is not part of the steady state
+        if (frame >= warmupFrameCount && !capture)
+        {
+            steadyAllocations += heapAllocationCount.load(std::memory_order_relaxed) - frameAllocationStart;
+            ++steadyFrames;
+        }
+    }
+    vulkanRenderer.getLogicalDevice().waitIdle();
+    const auto end = std::chrono::steady_clock::now();
+
+    const float totalTime = std::chrono::duration<float, std::milli>(end - start).count();
+    const FrameTimings frameTimings = vulkanRenderer.getFrameTimings();
+    std::cout << "Frames " << frameCount << ", total " << totalTime << " ms, "
+              << totalTime / static_cast<float>(std::max(frameCount, 1U)) << " ms per frame\n";
+    std::cout << "Average frame " << frameTimings.averageFrameTime << " ms, last fence wait " << frameTimings.fenceWaitTime << " ms\n";
+
+    const st::core::FrameArenaStatistics arenaStatistics = vulkanRenderer.getFrameArenaStatistics();
+    std::cout << "Frame arena " << arenaStatistics.allocationCount << " allocations, " << arenaStatistics.bytesUsed << " of "
+              << arenaStatistics.capacity << " bytes, " << arenaStatistics.overflowCount << " overflows\n";
+    if (steadyFrames > 0)
+    {
+        std::cout << "Heap allocations after " << warmupFrameCount << " frames: " << steadyAllocations << " in " << steadyFrames << " frames, "
+                  << static_cast<double>(steadyAllocations) / steadyFrames << " per frame\n";
+    }
+
+    return 0;
+}
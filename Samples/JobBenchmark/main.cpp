@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include "StCore/JobSystem.hpp"
+#include "StMath/MatrixBatch.hpp"
+
+// Animates, transforms and frustum culls a field of instances every frame with 1 to N workers and
+// reports the time per frame and the speedup over a single worker.
+//
+// Usage: Job_Benchmark [instances] [frames]
+
+static constexpr uint32_t defaultInstanceCount = 1'000'000;
+static constexpr uint32_t defaultFrameCount = 30;
+static constexpr uint32_t grainSize = 4096;
+static constexpr float instanceRadius = 0.75f;
+
+struct Scene
+{
+    std::vector<st::math::Vector3> positions;
+    std::vector<float> phases;
+
+    std::vector<st::math::Matrix4x4> models;
+    std::vector<st::math::Matrix4x4> transforms;
+    std::vector<uint8_t> visible;
+};
+
+Scene createScene(uint32_t instanceCount)
+{
+    Scene scene;
+    scene.positions.reserve(instanceCount);
+    scene.phases.reserve(instanceCount);
+
+    // A square grid around the camera, roughly a quarter of it ends up in the frustum
+    const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+    for (uint32_t i = 0; i < instanceCount; ++i)
+    {
+        const float x = static_cast<float>(i % side) - side * 0.5f;
+        const float z = static_cast<float>(i / side) - side * 0.5f;
+        scene.positions.emplace_back(x * 2.0f, 0.0f, z * 2.0f);
+        scene.phases.push_back(static_cast<float>(i % 360) * 0.0174533f);
+    }
+
+    scene.models.resize(instanceCount);
+    scene.transforms.resize(instanceCount);
+    scene.visible.resize(instanceCount);
+    return scene;
+}
+
+// Returns the number of visible instances
+uint32_t simulateFrame(st::core::JobSystem& jobSystem, Scene& scene, const st::math::Matrix4x4& viewProjection, float time)
+{
+    const uint32_t instanceCount = static_cast<uint32_t>(scene.positions.size());
+
+    jobSystem.parallelFor(instanceCount, grainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            st::math::Matrix4x4 model = st::math::Matrix4x4::rotationAroundAxis(time + scene.phases[i], st::math::Vector3 { 0.0f, 1.0f, 0.0f });
+            model.translate(scene.positions[i]);
+            scene.models[i] = model;
+        }
+
+        const std::span<const st::math::Matrix4x4> models { scene.models.data() + begin, end - begin };
+        st::math::multiplyBatch(viewProjection, models, std::span { scene.transforms.data() + begin, end - begin });
+    });
+
+    std::atomic<uint32_t> visibleCount { 0 };
+    jobSystem.parallelFor(instanceCount, grainSize, [&](uint32_t begin, uint32_t end) {
+        uint32_t rangeVisible = 0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            // Clip space origin of the instance, the sphere is tested against the six planes
+            const st::math::Matrix4x4& transform = scene.transforms[i];
+            const float x = transform[3];
+            const float y = transform[7];
+            const float z = transform[11];
+            const float w = transform[15];
+
+            const bool inside = std::abs(x) <= w + instanceRadius &&
+                                std::abs(y) <= w + instanceRadius &&
+                                z >= -instanceRadius &&
+                                z <= w + instanceRadius;
+
+            scene.visible[i] = inside ? 1 : 0;
+            rangeVisible += inside ? 1 : 0;
+        }
+        visibleCount.fetch_add(rangeVisible, std::memory_order_relaxed);
+    });
+
+    return visibleCount.load(std::memory_order_relaxed);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t instanceCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : defaultInstanceCount;
+    const uint32_t frameCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : defaultFrameCount;
+
+    Scene scene = createScene(instanceCount);
+
+    st::math::Matrix4x4 viewProjection = st::math::Matrix4x4::projectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    viewProjection.translate(st::math::Vector3 { 0.0f, -5.0f, 0.0f });
+
+    // Doubling up to the core count, the last step is the core count itself
+    std::vector<uint32_t> workerCounts;
+    const uint32_t maxWorkers = st::core::JobSystem::defaultWorkerCount();
+    for (uint32_t workers = 1; workers < maxWorkers; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(maxWorkers);
+
+    std::printf("%u instances, %u frames\n", instanceCount, frameCount);
+    std::printf("%8s %12s %10s %10s\n", "workers", "ms/frame", "speedup", "visible");
+
+    double singleWorkerTime = 0.0;
+    for (const uint32_t workers : workerCounts)
+    {
+        st::core::JobSystem jobSystem { workers };
+
+        // One untimed frame faults in the pages and wakes the workers
+        simulateFrame(jobSystem, scene, viewProjection, 0.0f);
+
+        uint32_t visible = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frameCount; ++frame)
+        {
+            visible = simulateFrame(jobSystem, scene, viewProjection, static_cast<float>(frame) * 0.016f);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const double frameTime = std::chrono::duration<double, std::milli>(end - start).count() / std::max(frameCount, 1U);
+        if (workers == 1)
+        {
+            singleWorkerTime = frameTime;
+        }
+
+        std::printf("%8u %12.3f %9.2fx %10u\n", workers, frameTime, singleWorkerTime / frameTime, visible);
+    }
+
+    return 0;
+}